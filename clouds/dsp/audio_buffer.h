@@ -277,6 +277,17 @@ class AudioBuffer {
     return ((((a * t) - b_neg) * t + c) * t + x0) * scale;
   }
   
+  // Single sample, without wrap-around nor interpolation.
+  inline float ReadRaw(int32_t index) const {
+    if (resolution == RESOLUTION_16_BIT) {
+      return static_cast<float>(s16_[index]) * (1.0f / 32768.0f);
+    } else if (resolution == RESOLUTION_8_BIT_MU_LAW) {
+      return static_cast<float>(MuLaw2Lin(s8_[index])) * (1.0f / 32768.0f);
+    } else {
+      return static_cast<float>(s8_[index]) * (1.0f / 128.0f);
+    }
+  }
+  
   inline int32_t size() const { return size_; }
   inline int32_t head() const { return write_head_; }
   
@@ -30,10 +30,20 @@
 
 #include <algorithm>
 
+#ifdef CORRELATOR_USE_SIMD
+  #include "clouds/dsp/simd.h"
+#endif  // CORRELATOR_USE_SIMD
+
 namespace clouds {
 
 using namespace std;
 
+static inline uint32_t PopCount(uint32_t x) {
+  x = x - ((x >> 1) & 0x55555555);
+  x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+  return (((x + (x >> 4)) & 0xf0f0f0f) * 0x1010101) >> 24;
+}
+
 void Correlator::Init(uint32_t* source, uint32_t* destination) {
   source_ = source;
   destination_ = destination;
@@ -57,12 +67,9 @@ void Correlator::EvaluateNextCandidate() {
     uint32_t source_bits = source[i];
     uint32_t destination_bits = 0;
     destination_bits |= destination[i] << offset_bits;
-    destination_bits |= destination[i + 1] >> (32 - offset_bits);
-    uint32_t count = ~(source_bits ^ destination_bits);
-    count = count - ((count >> 1) & 0x55555555);
-    count = (count & 0x33333333) + ((count >> 2) & 0x33333333);
-    count = (((count + (count >> 4)) & 0xf0f0f0f) * 0x1010101) >> 24;
-    xcorr += count;
+    // Shifting by 32 is undefined, hence the two-step shift.
+    destination_bits |= (destination[i + 1] >> 1) >> (31 - offset_bits);
+    xcorr += PopCount(~(source_bits ^ destination_bits));
   }
   if (xcorr > best_score_) {
     best_match_ = candidate_;
@@ -72,6 +79,55 @@ void Correlator::EvaluateNextCandidate() {
   done_ = candidate_ >= size_;
 }
 
+void Correlator::EvaluateAllCandidates() {
+#ifdef CORRELATOR_USE_SIMD
+  // Each candidate is evaluated 4 words at a time, so that all lanes are
+  // shifted by the same amount (neither SSE2 nor NEON can shift each lane by
+  // a different amount without falling back to scalar code).
+  uint32_t num_words = size_ >> 5;
+  uint32_t num_vector_words = num_words & ~3;
+  const uint32_t* source = &source_[0];
+  while (!done_) {
+    uint32_t offset_words = candidate_ >> 5;
+    uint32_t offset_bits = candidate_ & 0x1f;
+    const uint32_t* destination = &destination_[offset_words];
+    
+    UInt4 xcorr = UInt4();
+    uint32_t i = 0;
+    while (i < num_vector_words) {
+      // Per-byte counts are accumulated over at most 31 vectors, so that
+      // they do not overflow.
+      uint32_t end = min(i + 31 * 4, num_vector_words);
+      UInt4 counts = UInt4();
+      for (; i < end; i += 4) {
+        UInt4 source_bits = Load(&source[i]);
+        UInt4 destination_bits = Load(&destination[i]) << offset_bits;
+        destination_bits |= (Load(&destination[i + 1]) >> 1) >> \
+            (31 - offset_bits);
+        counts += PopCountBytes(~(source_bits ^ destination_bits));
+      }
+      xcorr += SumBytes(counts);
+    }
+    uint32_t score = (xcorr[0] + xcorr[1]) + (xcorr[2] + xcorr[3]);
+    for (; i < num_words; ++i) {
+      uint32_t destination_bits = destination[i] << offset_bits;
+      destination_bits |= (destination[i + 1] >> 1) >> (31 - offset_bits);
+      score += PopCount(~(source[i] ^ destination_bits));
+    }
+    if (score > best_score_) {
+      best_match_ = candidate_;
+      best_score_ = score;
+    }
+    ++candidate_;
+    done_ = candidate_ >= size_;
+  }
+#else
+  while (!done_) {
+    EvaluateNextCandidate();
+  }
+#endif  // CORRELATOR_USE_SIMD
+}
+
 void Correlator::StartSearch(
     int32_t size,
     int32_t offset,
@@ -33,6 +33,10 @@
 
 #include "stmlib/stmlib.h"
 
+#if defined(__SSE2__) || defined(__ARM_NEON__)
+  #define CORRELATOR_USE_SIMD
+#endif  // __SSE2__ || __ARM_NEON__
+
 namespace clouds {
   
 class Correlator {
@@ -57,6 +61,10 @@ class Correlator {
   }
 
   void EvaluateNextCandidate();
+  
+  // Evaluates all the remaining candidates in one pass. On targets with a
+  // vector unit, the score of each candidate is computed 4 words at a time.
+  void EvaluateAllCandidates();
 
   inline uint32_t* source() { return source_; }
   inline uint32_t* destination() { return destination_; }
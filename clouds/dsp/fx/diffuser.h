@@ -61,37 +61,39 @@ class Diffuser {
     E::DelayLine<Memory, 5> apr2;
     E::DelayLine<Memory, 6> apr3;
     E::DelayLine<Memory, 7> apr4;
-    E::Context c;
+    E::BlockContext c;
     const float kap = 0.625f;
-    while (size--) {
-      engine_.Start(&c);
+    // All delay lines are longer than a block, so they can be processed one
+    // block at a time. The end of APR4 is adjacent to the beginning of APL1 in
+    // the circular buffer, so it is read before APL1 is written.
+    float l[E::max_block_size];
+    float r[E::max_block_size];
+    float apr4_tail[E::max_block_size];
+    while (size) {
+      size_t block_size = std::min(
+          size, static_cast<size_t>(E::max_block_size));
+      engine_.StartBlock(&c, block_size);
+      c.Read(apr4 TAIL, apr4_tail);
       
-      float wet = 0.0f;
-      c.Read(in_out->l);
-      c.Read(apl1 TAIL, kap);
-      c.WriteAllPass(apl1, -kap);
-      c.Read(apl2 TAIL, kap);
-      c.WriteAllPass(apl2, -kap);
-      c.Read(apl3 TAIL, kap);
-      c.WriteAllPass(apl3, -kap);
-      c.Read(apl4 TAIL, kap);
-      c.WriteAllPass(apl4, -kap);
-      c.Write(wet, 0.0f);
-      in_out->l += amount_ * (wet - in_out->l);
+      for (size_t i = 0; i < block_size; ++i) {
+        l[i] = in_out[i].l;
+        r[i] = in_out[i].r;
+      }
+      c.AllPass(apl1, kap, l);
+      c.AllPass(apl2, kap, l);
+      c.AllPass(apl3, kap, l);
+      c.AllPass(apl4, kap, l);
+      c.AllPass(apr1, kap, r);
+      c.AllPass(apr2, kap, r);
+      c.AllPass(apr3, kap, r);
+      c.AllPass(apr4, kap, apr4_tail, r);
+      for (size_t i = 0; i < block_size; ++i) {
+        in_out[i].l += amount_ * (l[i] - in_out[i].l);
+        in_out[i].r += amount_ * (r[i] - in_out[i].r);
+      }
       
-      c.Read(in_out->r);
-      c.Read(apr1 TAIL, kap);
-      c.WriteAllPass(apr1, -kap);
-      c.Read(apr2 TAIL, kap);
-      c.WriteAllPass(apr2, -kap);
-      c.Read(apr3 TAIL, kap);
-      c.WriteAllPass(apr3, -kap);
-      c.Read(apr4 TAIL, kap);
-      c.WriteAllPass(apr4, -kap);
-      c.Write(wet, 0.0f);
-      in_out->r += amount_ * (wet - in_out->r);
-
-      ++in_out;
+      in_out += block_size;
+      size -= block_size;
     }
   }
   
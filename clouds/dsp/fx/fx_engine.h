@@ -36,6 +36,8 @@
 #include "stmlib/dsp/dsp.h"
 #include "stmlib/dsp/cosine_oscillator.h"
 
+#include "clouds/dsp/fx/fx_block_context.h"
+
 namespace clouds {
 
 #define TAIL , -1
@@ -66,6 +68,17 @@ struct DataType<FORMAT_12_BIT> {
     return static_cast<uint16_t>(
         stmlib::Clip16(static_cast<int32_t>(value * 4096.0f)));
   }
+
+#ifdef FX_ENGINE_USE_SIMD
+  static inline Float4 Load(const T* source) {
+    Int4 x = clouds::Load(source);
+    return ToFloat((x << 16) >> 16) * (1.0f / 4096.0f);
+  }
+  
+  static inline void Store(T* destination, Float4 value) {
+    clouds::Store(destination, SaturateInt16(ToInt(value * 4096.0f)));
+  }
+#endif  // FX_ENGINE_USE_SIMD
 };
 
 template<>
@@ -80,6 +93,17 @@ struct DataType<FORMAT_16_BIT> {
     return static_cast<uint16_t>(
         stmlib::Clip16(static_cast<int32_t>(value * 32768.0f)));
   }
+
+#ifdef FX_ENGINE_USE_SIMD
+  static inline Float4 Load(const T* source) {
+    Int4 x = clouds::Load(source);
+    return ToFloat((x << 16) >> 16) * (1.0f / 32768.0f);
+  }
+  
+  static inline void Store(T* destination, Float4 value) {
+    clouds::Store(destination, SaturateInt16(ToInt(value * 32768.0f)));
+  }
+#endif  // FX_ENGINE_USE_SIMD
 };
 
 template<>
@@ -93,6 +117,16 @@ struct DataType<FORMAT_32_BIT> {
   static inline T Compress(float value) {
     return value;
   }
+
+#ifdef FX_ENGINE_USE_SIMD
+  static inline Float4 Load(const T* source) {
+    return clouds::Load(source);
+  }
+  
+  static inline void Store(T* destination, Float4 value) {
+    clouds::Store(destination, value);
+  }
+#endif  // FX_ENGINE_USE_SIMD
 };
 
 template<
@@ -262,6 +296,14 @@ class FxEngine {
     DISALLOW_COPY_AND_ASSIGN(Context);
   };
   
+  // Block-wise access to the delay memory, see
+  // fx_block_context.h.
+  typedef FxBlockContext<size, DataType<format> > BlockContext;
+  
+  enum {
+    max_block_size = BlockContext::max_block_size
+  };
+  
   inline void SetLFOFrequency(LFOIndex index, float frequency) {
     lfo_[index].template Init<stmlib::COSINE_OSCILLATOR_APPROXIMATE>(
         frequency * 32.0f);
@@ -285,6 +327,10 @@ class FxEngine {
     }
   }
   
+  inline void StartBlock(BlockContext* c, size_t block_size) {
+    c->Start(buffer_, &write_ptr_, lfo_, block_size);
+  }
+  
  private:
   enum {
     MASK = size - 1
@@ -0,0 +1,255 @@
+// Copyright 2014 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Dense bank of grains, stored as structure of arrays and rendered 4 grains at
+// a time. Active grains are kept contiguous, so that all vector lanes do
+// useful work.
+
+#ifndef CLOUDS_DSP_GRAIN_BANK_H_
+#define CLOUDS_DSP_GRAIN_BANK_H_
+
+#include "stmlib/stmlib.h"
+
+#include "clouds/dsp/audio_buffer.h"
+#include "clouds/dsp/frame.h"
+#include "clouds/dsp/grain.h"
+#include "clouds/dsp/simd.h"
+
+#include "clouds/resources.h"
+
+namespace clouds {
+
+const int32_t kMaxNumDenseGrains = 1024;
+
+class GrainBank {
+ public:
+  GrainBank() { }
+  ~GrainBank() { }
+
+  void Init() {
+    num_grains_ = 0;
+  }
+  
+  // Same arguments as Grain::Start(). All grains are rendered with linear
+  // interpolation and the high quality envelope.
+  void Start(
+      int32_t pre_delay,
+      int32_t buffer_size,
+      int32_t start,
+      int32_t width,
+      int32_t phase_increment,
+      float window_shape,
+      float gain_l,
+      float gain_r,
+      GrainQuality recommended_quality) {
+    if (num_grains_ >= kMaxNumDenseGrains) {
+      return;
+    }
+    int32_t i = num_grains_++;
+    pre_delay_[i] = pre_delay;
+    first_sample_[i] = (start + buffer_size) % buffer_size;
+    phase_[i] = 0;
+    phase_increment_[i] = phase_increment;
+    envelope_phase_[i] = 0.0f;
+    envelope_phase_increment_[i] = 2.0f / static_cast<float>(width);
+    if (window_shape >= 0.5f) {
+      envelope_smoothness_[i] = (window_shape - 0.5f) * 2.0f;
+      envelope_slope_[i] = 0.0f;
+    } else {
+      envelope_smoothness_[i] = 0.0f;
+      envelope_slope_[i] = 0.5f / (window_shape + 0.01f);
+    }
+    gain_l_[i] = gain_l;
+    gain_r_[i] = gain_r;
+  }
+  
+  template<int32_t num_channels, Resolution resolution>
+  void OverlapAdd(
+      const AudioBuffer<resolution>* buffer,
+      float* destination,
+      size_t size) {
+    if (!num_grains_) {
+      return;
+    }
+    
+    // Pad the last group with finished grains.
+    for (int32_t i = num_grains_; i % kSimdWidth; ++i) {
+      pre_delay_[i] = 0;
+      first_sample_[i] = 0;
+      phase_[i] = 0;
+      phase_increment_[i] = 0;
+      envelope_phase_[i] = 2.0f;
+      envelope_phase_increment_[i] = 0.0f;
+      envelope_smoothness_[i] = 0.0f;
+      envelope_slope_[i] = 0.0f;
+      gain_l_[i] = gain_r_[i] = 0.0f;
+    }
+    
+    for (size_t t = 0; t < size; ++t) {
+      sum_l_[t] = sum_r_[t] = Float4();
+    }
+    for (int32_t i = 0; i < num_grains_; i += kSimdWidth) {
+      RenderGroup<num_channels>(buffer, i, size);
+    }
+    for (size_t t = 0; t < size; ++t) {
+      *destination++ += Sum(sum_l_[t]);
+      *destination++ += Sum(sum_r_[t]);
+    }
+    
+    // Remove finished grains.
+    int32_t i = 0;
+    while (i < num_grains_) {
+      if (envelope_phase_[i] >= 2.0f) {
+        Move(--num_grains_, i);
+      } else {
+        ++i;
+      }
+    }
+  }
+  
+  inline int32_t num_grains() const { return num_grains_; }
+  
+ private:
+  template<int32_t num_channels, Resolution resolution>
+  inline void RenderGroup(
+      const AudioBuffer<resolution>* buffer,
+      int32_t first_grain,
+      size_t size) {
+    const Int4 pre_delay = Load(&pre_delay_[first_grain]);
+    const Int4 first_sample = Load(&first_sample_[first_grain]);
+    const Int4 phase_increment = Load(&phase_increment_[first_grain]);
+    const Float4 increment = Load(&envelope_phase_increment_[first_grain]);
+    const Float4 smoothness = Load(&envelope_smoothness_[first_grain]);
+    const Float4 slope = Load(&envelope_slope_[first_grain]);
+    const Int4 use_lut = smoothness != 0.0f;
+    const Float4 gain_l = Load(&gain_l_[first_grain]);
+    const Float4 gain_r = Load(&gain_r_[first_grain]);
+    const Int4 buffer_size = Int4() + buffer[0].size();
+    Int4 phase = Load(&phase_[first_grain]);
+    Float4 envelope_phase = Load(&envelope_phase_[first_grain]);
+
+    for (size_t t = 0; t < size; ++t) {
+      // Grains start after their pre-delay, and end (without rendering the
+      // last sample) when the envelope phase reaches 2.0, as in Grain.
+      Int4 running = (Int4() + static_cast<int32_t>(t)) >= pre_delay;
+      Float4 next = envelope_phase + increment;
+      Int4 alive = running & (next < 2.0f);
+      if (!(alive[0] | alive[1] | alive[2] | alive[3])) {
+        envelope_phase = running ? next : envelope_phase;
+        continue;
+      }
+      
+      Float4 gain = envelope_phase >= 1.0f
+          ? 2.0f - envelope_phase
+          : envelope_phase;
+      Float4 window = InterpolateLinear(lut_window, gain * 4096.0f);
+      Float4 smooth_gain = gain + smoothness * (window - gain);
+      Float4 sloped_gain = Min(gain * slope, Splat(1.0f));
+      gain = use_lut ? smooth_gain : sloped_gain;
+      gain = alive ? gain : Float4();
+      
+      // The play head of finished grains is frozen, so it is safe to read
+      // from all lanes.
+      Int4 sample_index = first_sample + (phase >> 16);
+      sample_index = sample_index >= buffer_size
+          ? sample_index - buffer_size
+          : sample_index;
+      Float4 fractional = ToFloat(phase & 65535) * (1.0f / 65536.0f);
+      Float4 l = ReadLinear(buffer[0], sample_index, fractional);
+      Float4 r = num_channels == 2
+          ? ReadLinear(buffer[1], sample_index, fractional)
+          : Float4();
+      l *= gain;
+      if (num_channels == 1) {
+        sum_l_[t] += l * gain_l;
+        sum_r_[t] += l * gain_r;
+      } else {
+        r *= gain;
+        sum_l_[t] += l * gain_l + r * (1.0f - gain_r);
+        sum_r_[t] += r * gain_r + l * (1.0f - gain_l);
+      }
+      envelope_phase = running ? next : envelope_phase;
+      phase = alive ? phase + phase_increment : phase;
+    }
+    
+    Int4 remaining_delay = pre_delay - static_cast<int32_t>(size);
+    Store(&pre_delay_[first_grain], remaining_delay > 0
+        ? remaining_delay
+        : Int4());
+    Store(&phase_[first_grain], phase);
+    Store(&envelope_phase_[first_grain], envelope_phase);
+  }
+  
+  template<Resolution resolution>
+  static inline Float4 ReadLinear(
+      const AudioBuffer<resolution>& buffer,
+      Int4 integral,
+      Float4 fractional) {
+    Float4 x0 = { buffer.ReadRaw(integral[0]), buffer.ReadRaw(integral[1]),
+        buffer.ReadRaw(integral[2]), buffer.ReadRaw(integral[3]) };
+    Float4 x1 = { buffer.ReadRaw(integral[0] + 1),
+        buffer.ReadRaw(integral[1] + 1),
+        buffer.ReadRaw(integral[2] + 1),
+        buffer.ReadRaw(integral[3] + 1) };
+    return x0 + (x1 - x0) * fractional;
+  }
+  
+  inline void Move(int32_t from, int32_t to) {
+    pre_delay_[to] = pre_delay_[from];
+    first_sample_[to] = first_sample_[from];
+    phase_[to] = phase_[from];
+    phase_increment_[to] = phase_increment_[from];
+    envelope_phase_[to] = envelope_phase_[from];
+    envelope_phase_increment_[to] = envelope_phase_increment_[from];
+    envelope_smoothness_[to] = envelope_smoothness_[from];
+    envelope_slope_[to] = envelope_slope_[from];
+    gain_l_[to] = gain_l_[from];
+    gain_r_[to] = gain_r_[from];
+  }
+  
+  int32_t num_grains_;
+  
+  int32_t pre_delay_[kMaxNumDenseGrains];
+  int32_t first_sample_[kMaxNumDenseGrains];
+  int32_t phase_[kMaxNumDenseGrains];
+  int32_t phase_increment_[kMaxNumDenseGrains];
+  float envelope_phase_[kMaxNumDenseGrains];
+  float envelope_phase_increment_[kMaxNumDenseGrains];
+  float envelope_smoothness_[kMaxNumDenseGrains];
+  float envelope_slope_[kMaxNumDenseGrains];
+  float gain_l_[kMaxNumDenseGrains];
+  float gain_r_[kMaxNumDenseGrains];
+  
+  // One partial sum per lane, reduced once per block.
+  Float4 sum_l_[kMaxBlockSize];
+  Float4 sum_r_[kMaxBlockSize];
+  
+  DISALLOW_COPY_AND_ASSIGN(GrainBank);
+};
+
+}  // namespace clouds
+
+#endif  // CLOUDS_DSP_GRAIN_BANK_H_
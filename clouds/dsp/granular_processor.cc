@@ -52,6 +52,11 @@ void GranularProcessor::Init(
   
   num_channels_ = 2;
   low_fidelity_ = false;
+  max_num_grains_ = 0;
+  max_wsola_size_ = 0;
+  full_correlator_search_ = false;
+  spectral_hop_ratio_ = 4;
+  spectral_latency_ = 1;
   bypass_ = false;
   
   src_down_.Init();
@@ -62,6 +67,44 @@ void GranularProcessor::Init(
   previous_playback_mode_ = PLAYBACK_MODE_LAST;
   reset_buffers_ = true;
   dry_wet_ = 0.0f;
+  
+  memset(&control_shadow_, 0, sizeof(control_shadow_));
+  control_shadow_.playback_mode = PLAYBACK_MODE_LAST;
+  control_shadow_.quality = -1;
+  control_shadow_.num_freeze_toggles = 0;
+  control_.Init();
+  posted_playback_mode_ = PLAYBACK_MODE_LAST;
+  posted_quality_ = -1;
+  control_playback_mode_ = PLAYBACK_MODE_LAST;
+  control_quality_ = -1;
+  control_num_freeze_toggles_ = 0;
+}
+
+void GranularProcessor::ApplyControlSnapshot(const ControlSnapshot& snapshot) {
+  if (snapshot.has_parameters) {
+    bool freeze = parameters_.freeze;
+    parameters_ = snapshot.parameters;
+    parameters_.freeze = freeze;
+  }
+  posted_playback_mode_ = snapshot.playback_mode;
+  posted_quality_ = snapshot.quality;
+  if ((snapshot.num_freeze_toggles - control_num_freeze_toggles_) & 1) {
+    ToggleFreeze();
+  }
+  control_num_freeze_toggles_ = snapshot.num_freeze_toggles;
+}
+
+void GranularProcessor::ApplyPostedSettings() {
+  PlaybackMode playback_mode = posted_playback_mode_;
+  if (playback_mode != control_playback_mode_) {
+    control_playback_mode_ = playback_mode;
+    set_playback_mode(playback_mode);
+  }
+  int32_t quality = posted_quality_;
+  if (quality != control_quality_) {
+    control_quality_ = quality;
+    set_quality(quality);
+  }
 }
 
 void GranularProcessor::ResetFilters() {
@@ -161,6 +204,10 @@ void GranularProcessor::Process(
     ShortFrame* output,
     size_t size) {
   // TIC
+  if (control_.Read()) {
+    ApplyControlSnapshot(control_.front());
+  }
+  
   if (bypass_) {
     copy(&input[0], &input[size], &output[0]);
     return;
@@ -368,6 +415,8 @@ bool GranularProcessor::LoadPersistentData(const uint32_t* data) {
 }
 
 void GranularProcessor::Prepare() {
+  ApplyPostedSettings();
+  
   bool playback_mode_changed = previous_playback_mode_ != playback_mode_;
   bool benign_change = previous_playback_mode_ != PLAYBACK_MODE_SPECTRAL
       && playback_mode_ != PLAYBACK_MODE_SPECTRAL
@@ -413,7 +462,9 @@ void GranularProcessor::Prepare() {
     diffuser_.Init(allocator.Allocate<float>(2048));
     reverb_.Init(allocator.Allocate<uint16_t>(16384));
     
-    size_t correlator_block_size = (kMaxWSOLASize / 32) + 2;
+    int32_t max_wsola_size = max_wsola_size_ ? max_wsola_size_ : kMaxWSOLASize;
+    CONSTRAIN(max_wsola_size, 2048, kLargestWSOLASize);
+    size_t correlator_block_size = (max_wsola_size / 32) + 2;
     uint32_t* correlator_data = allocator.Allocate<uint32_t>(
         correlator_block_size * 3);
     correlator_.Init(
@@ -424,7 +475,8 @@ void GranularProcessor::Prepare() {
     if (playback_mode_ == PLAYBACK_MODE_SPECTRAL) {
       phase_vocoder_.Init(
           buffer, buffer_size,
-          lut_sine_window_4096, 4096,
+          lut_sine_window_4096, kSpectralFftSize,
+          spectral_hop_ratio_, spectral_latency_,
           num_channels_, resolution(), sr);
     } else {
       for (int32_t i = 0; i < num_channels_; ++i) {
@@ -440,10 +492,10 @@ void GranularProcessor::Prepare() {
               tail_buffer_[i]);
         }
       }
-      int32_t num_grains = (num_channels_ == 1 ? 40 : 32) * \
-          (low_fidelity_ ? 23 : 16) >> 4;
+      int32_t num_grains = max_num_grains_ ? max_num_grains_ :
+          (num_channels_ == 1 ? 40 : 32) * (low_fidelity_ ? 23 : 16) >> 4;
       player_.Init(num_channels_, num_grains);
-      ws_player_.Init(&correlator_, num_channels_);
+      ws_player_.Init(&correlator_, num_channels_, max_wsola_size);
       looper_.Init(num_channels_);
     }
     reset_buffers_ = false;
@@ -458,7 +510,11 @@ void GranularProcessor::Prepare() {
     } else {
       ws_player_.LoadCorrelator(buffer_16_);
     }
-    correlator_.EvaluateSomeCandidates();
+    if (full_correlator_search_) {
+      correlator_.EvaluateAllCandidates();
+    } else {
+      correlator_.EvaluateSomeCandidates();
+    }
   }
 }
 
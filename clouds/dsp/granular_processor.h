@@ -42,12 +42,16 @@
 #include "clouds/dsp/looping_sample_player.h"
 #include "clouds/dsp/pvoc/phase_vocoder.h"
 #include "clouds/dsp/sample_rate_converter.h"
+#include "clouds/dsp/triple_buffer.h"
 #include "clouds/dsp/wsola_sample_player.h"
 
 namespace clouds {
 
 const int32_t kDownsamplingFactor = 2;
 
+// FFT size of the spectral mode.
+const size_t kSpectralFftSize = 4096;
+
 enum PlaybackMode {
   PLAYBACK_MODE_GRANULAR,
   PLAYBACK_MODE_STRETCH,
@@ -63,6 +67,16 @@ struct PersistentState {
   uint8_t spectral;
 };
 
+// Settings published by a control thread, picked up by the audio thread at
+// the next block boundary.
+struct ControlSnapshot {
+  Parameters parameters;
+  bool has_parameters;
+  PlaybackMode playback_mode;  // PLAYBACK_MODE_LAST if never posted.
+  int32_t quality;  // -1 if never posted.
+  uint32_t num_freeze_toggles;
+};
+
 // Data block as saved in one of the 4 sample memories.
 struct PersistentBlock {
   uint32_t tag;
@@ -104,6 +118,36 @@ class GranularProcessor {
     return parameters_.freeze;
   }
 
+  // Wait-free alternative to the setters above, for a control thread running
+  // concurrently with Process(). Each call publishes a complete snapshot of
+  // all the settings posted so far; Process() picks up the latest one at the
+  // beginning of the next block. Parameters and freeze are applied there.
+  // Playback mode and quality reallocate the buffers, so they are applied by
+  // the next call to Prepare(), in the thread running it. They are only
+  // applied when they differ from the previously posted value, so the
+  // settings restored by LoadPersistentData() are not overridden by a stale
+  // snapshot. Freeze is controlled exclusively through PostToggleFreeze().
+  inline void PostParameters(const Parameters& parameters) {
+    control_shadow_.parameters = parameters;
+    control_shadow_.has_parameters = true;
+    control_.Write(control_shadow_);
+  }
+  
+  inline void PostPlaybackMode(PlaybackMode playback_mode) {
+    control_shadow_.playback_mode = playback_mode;
+    control_.Write(control_shadow_);
+  }
+  
+  inline void PostQuality(int32_t quality) {
+    control_shadow_.quality = quality;
+    control_.Write(control_shadow_);
+  }
+  
+  inline void PostToggleFreeze() {
+    ++control_shadow_.num_freeze_toggles;
+    control_.Write(control_shadow_);
+  }
+
   inline void set_silence(bool silence) {
     silence_ = silence;
   }
@@ -137,6 +181,57 @@ class GranularProcessor {
     low_fidelity_ = low_fidelity;
   }
   
+  // Granular mode: maximum number of grains, 0 for the default (which
+  // depends on the quality setting).
+  inline void set_max_num_grains(int32_t max_num_grains) {
+    reset_buffers_ = reset_buffers_ || (
+        playback_mode_ == PLAYBACK_MODE_GRANULAR &&
+        max_num_grains != max_num_grains_);
+    max_num_grains_ = max_num_grains;
+  }
+  
+  // Stretch mode: maximum WSOLA window size, 0 for the default. Sizes above
+  // kMaxWSOLASize are best used with a full correlator search.
+  inline void set_max_wsola_size(int32_t max_wsola_size) {
+    reset_buffers_ = reset_buffers_ || (
+        playback_mode_ == PLAYBACK_MODE_STRETCH &&
+        max_wsola_size != max_wsola_size_);
+    max_wsola_size_ = max_wsola_size;
+  }
+  
+  // Stretch mode: when true, Prepare() completes the search for the next
+  // splice point in one call rather than spreading it over several blocks.
+  // Meant for hosts in which Prepare() runs in its own thread.
+  inline void set_full_correlator_search(bool full_correlator_search) {
+    full_correlator_search_ = full_correlator_search;
+  }
+  
+  // Spectral mode: hop size is fft_size / hop_ratio. The ratio is rounded
+  // down to a power of two between 2 and kSpectralFftSize. latency is the
+  // number of hops Prepare() can lag behind Process() before the output
+  // glitches. The analysis/synthesis buffers hold at most hop_ratio / 2 hops
+  // of latency: a larger value is reduced to that.
+  inline void set_spectral_hop_ratio(size_t hop_ratio) {
+    size_t power_of_two = 2;
+    while (power_of_two < kSpectralFftSize && power_of_two * 2 <= hop_ratio) {
+      power_of_two *= 2;
+    }
+    hop_ratio = power_of_two;
+    reset_buffers_ = reset_buffers_ || (
+        playback_mode_ == PLAYBACK_MODE_SPECTRAL &&
+        hop_ratio != spectral_hop_ratio_);
+    spectral_hop_ratio_ = hop_ratio;
+  }
+  
+  inline void set_spectral_latency(size_t latency) {
+    reset_buffers_ = reset_buffers_ || (
+        playback_mode_ == PLAYBACK_MODE_SPECTRAL &&
+        latency != spectral_latency_);
+    spectral_latency_ = latency;
+  }
+  
+  inline const PhaseVocoder& phase_vocoder() const { return phase_vocoder_; }
+  
   inline int32_t quality() const {
     int32_t quality = 0;
     if (num_channels_ == 1) quality |= 1;
@@ -159,12 +254,19 @@ class GranularProcessor {
   }
      
   void ResetFilters();
+  void ApplyControlSnapshot(const ControlSnapshot& snapshot);
+  void ApplyPostedSettings();
   void ProcessGranular(FloatFrame* input, FloatFrame* output, size_t size);
 
   PlaybackMode playback_mode_;
   PlaybackMode previous_playback_mode_;
   int32_t num_channels_;
   bool low_fidelity_;
+  int32_t max_num_grains_;
+  int32_t max_wsola_size_;
+  bool full_correlator_search_;
+  size_t spectral_hop_ratio_;
+  size_t spectral_latency_;
   
   bool silence_;
   bool bypass_;
@@ -207,6 +309,19 @@ class GranularProcessor {
   
   PersistentState persistent_state_;
   
+  // Written by the control thread only.
+  ControlSnapshot control_shadow_;
+  TripleBuffer<ControlSnapshot> control_;
+  // Playback mode and quality of the last snapshot, written by the audio
+  // thread for Prepare().
+  volatile PlaybackMode posted_playback_mode_;
+  volatile int32_t posted_quality_;
+  // Last values applied by Prepare() (playback mode and quality) and by the
+  // audio thread (freeze).
+  PlaybackMode control_playback_mode_;
+  int32_t control_quality_;
+  uint32_t control_num_freeze_toggles_;
+  
   DISALLOW_COPY_AND_ASSIGN(GranularProcessor);
 };
 
@@ -44,6 +44,11 @@
 
 #include "clouds/resources.h"
 
+#if defined(__SSE2__) || defined(__ARM_NEON__)
+  #define GRANULAR_SAMPLE_PLAYER_USE_SIMD
+  #include "clouds/dsp/grain_bank.h"
+#endif
+
 namespace clouds {
 
 const int32_t kMaxNumGrains = 64;
@@ -55,7 +60,16 @@ class GranularSamplePlayer {
   GranularSamplePlayer() { }
   ~GranularSamplePlayer() { }
   
+  // Above kMaxNumGrains, and on targets with a vector unit, grains are
+  // rendered by a GrainBank (high-density mode).
   void Init(int32_t num_channels, int32_t max_num_grains) {
+#ifdef GRANULAR_SAMPLE_PLAYER_USE_SIMD
+    CONSTRAIN(max_num_grains, 1, kMaxNumDenseGrains);
+    high_density_ = max_num_grains > kMaxNumGrains;
+    grain_bank_.Init();
+#else
+    CONSTRAIN(max_num_grains, 1, kMaxNumGrains);
+#endif  // GRANULAR_SAMPLE_PLAYER_USE_SIMD
     max_num_grains_ = max_num_grains;
     num_midfi_grains_ = 3 * max_num_grains / 4;
     gain_normalization_ = 1.0f;
@@ -83,6 +97,20 @@ class GranularSamplePlayer {
       grain_rate_phasor_ = -1000.0f;
     }
     
+#ifdef GRANULAR_SAMPLE_PLAYER_USE_SIMD
+    if (high_density_) {
+      PlayHighDensity(
+          buffer,
+          parameters,
+          p,
+          target_num_grains,
+          space_between_grains,
+          out,
+          size);
+      return;
+    }
+#endif  // GRANULAR_SAMPLE_PLAYER_USE_SIMD
+    
     // Build a list of available grains.
     int32_t num_available_grains = FillAvailableGrainsList();
     
@@ -143,8 +171,70 @@ class GranularSamplePlayer {
       }
     }
     
+    Normalize(parameters, max_num_grains_ - num_available_grains, out, size);
+  }
+  
+  inline int32_t num_active_grains() {
+#ifdef GRANULAR_SAMPLE_PLAYER_USE_SIMD
+    if (high_density_) {
+      return grain_bank_.num_grains();
+    }
+#endif  // GRANULAR_SAMPLE_PLAYER_USE_SIMD
+    int32_t num_active_grains = 0;
+    for (int32_t i = 0; i < max_num_grains_; ++i) {
+      num_active_grains += grains_[i].active() ? 1 : 0;
+    }
+    return num_active_grains;
+  }
+  
+ private:
+#ifdef GRANULAR_SAMPLE_PLAYER_USE_SIMD
+  template<Resolution resolution>
+  void PlayHighDensity(
+      const AudioBuffer<resolution>* buffer,
+      const Parameters& parameters,
+      float p,
+      float target_num_grains,
+      float space_between_grains,
+      float* out,
+      size_t size) {
+    bool seed_trigger = parameters.trigger;
+    for (size_t t = 0; t < size; ++t) {
+      grain_rate_phasor_ += 1.0f;
+      bool seed_probabilistic = Random::GetFloat() < p
+          && target_num_grains > num_grains_;
+      bool seed_deterministic = grain_rate_phasor_ >= space_between_grains;
+      bool seed = seed_probabilistic || seed_deterministic || seed_trigger;
+      if (grain_bank_.num_grains() < max_num_grains_ && seed) {
+        ScheduleGrain(
+            &grain_bank_,
+            parameters,
+            t,
+            buffer->size(),
+            buffer->head() - size + t,
+            GRAIN_QUALITY_MEDIUM);
+        grain_rate_phasor_ = 0.0f;
+        seed_trigger = false;
+      }
+    }
+    
+    int32_t active_grains = grain_bank_.num_grains();
+    std::fill(&out[0], &out[size * 2], 0.0f);
+    if (num_channels_ == 1) {
+      grain_bank_.OverlapAdd<1>(buffer, out, size);
+    } else {
+      grain_bank_.OverlapAdd<2>(buffer, out, size);
+    }
+    Normalize(parameters, active_grains, out, size);
+  }
+#endif  // GRANULAR_SAMPLE_PLAYER_USE_SIMD
+  
+  void Normalize(
+      const Parameters& parameters,
+      int32_t active_grains,
+      float* out,
+      size_t size) {
     // Compute normalization factor.
-    int32_t active_grains = max_num_grains_ - num_available_grains;
     SLOPE(num_grains_, static_cast<float>(active_grains), 0.9f, 0.2f);
 
     float gain_normalization = num_grains_ > 2.0f
@@ -163,7 +253,6 @@ class GranularSamplePlayer {
     }
   }
   
- private:
   int32_t FillAvailableGrainsList() {
     int32_t num_available_grains = 0;
     for (int32_t i = 0; i < max_num_grains_; ++i) {
@@ -175,8 +264,9 @@ class GranularSamplePlayer {
     return num_available_grains;
   }
   
+  template<typename G>
   void ScheduleGrain(
-      Grain* grain,
+      G* grain,
       const Parameters& parameters,
       int32_t pre_delay,
       int32_t buffer_size,
@@ -246,6 +336,10 @@ class GranularSamplePlayer {
   
   Grain grains_[kMaxNumGrains];
   int32_t available_grains_[kMaxNumGrains];
+#ifdef GRANULAR_SAMPLE_PLAYER_USE_SIMD
+  bool high_density_;
+  GrainBank grain_bank_;
+#endif  // GRANULAR_SAMPLE_PLAYER_USE_SIMD
   float envelope_buffer_[kMaxBlockSize];
   
   DISALLOW_COPY_AND_ASSIGN(GranularSamplePlayer);
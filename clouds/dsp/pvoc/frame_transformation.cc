@@ -36,12 +36,19 @@
 
 #include "clouds/dsp/frame.h"
 #include "clouds/dsp/parameters.h"
+#ifdef FRAME_TRANSFORMATION_USE_SIMD
+#include "clouds/dsp/simd.h"
+#endif  // FRAME_TRANSFORMATION_USE_SIMD
 
 namespace clouds {
 
 using namespace std;
 using namespace stmlib;
 
+#ifdef FRAME_TRANSFORMATION_USE_SIMD
+const int32_t kVectorSize = kSimdWidth;
+#endif  // FRAME_TRANSFORMATION_USE_SIMD
+
 void FrameTransformation::Init(
     float* buffer,
     int32_t fft_size,
@@ -109,7 +116,17 @@ void FrameTransformation::RectangularToPolar(float* fft_data) {
   float* real = &fft_data[0];
   float* imag = &fft_data[fft_size_ >> 1];
   float* magnitude = &fft_data[0];
-  for (int32_t i = 1; i < size_; ++i) {
+  int32_t i = 1;
+#ifdef FRAME_TRANSFORMATION_USE_SIMD
+  for (; i + kVectorSize <= size_; i += kVectorSize) {
+    Float4 m;
+    Int4 angle = FastAtan2r(Load(&imag[i]), Load(&real[i]), &m);
+    Store(&magnitude[i], m);
+    Store(&phases_delta_[i], angle - Load(&phases_[i]));
+    Store(&phases_[i], angle);
+  }
+#endif  // FRAME_TRANSFORMATION_USE_SIMD
+  for (; i < size_; ++i) {
     uint16_t angle = fast_atan2r(imag[i], real[i], &magnitude[i]);
     phases_delta_[i] = angle - phases_[i];
     phases_[i] = angle;
@@ -142,7 +159,18 @@ void FrameTransformation::PolarToRectangular(float* fft_data) {
   float* imag = &fft_data[fft_size_ >> 1];
   float* magnitude = &fft_data[0];
   uint32_t* angle = (uint32_t*) &fft_data[fft_size_ >> 1];
-  for (int32_t i = 1; i < size_; ++i) {
+  int32_t i = 1;
+#ifdef FRAME_TRANSFORMATION_USE_SIMD
+  for (; i + kVectorSize <= size_; i += kVectorSize) {
+    Int4 a;
+    memcpy(&a, &angle[i], sizeof(a));
+    a = (a & 0xffff) >> 6;
+    Float4 m = Load(&magnitude[i]);
+    Store(&real[i], m * Gather(&lut_sin[256], a));
+    Store(&imag[i], m * Gather(lut_sin, a));
+  }
+#endif  // FRAME_TRANSFORMATION_USE_SIMD
+  for (; i < size_; ++i) {
     fast_p2r(magnitude[i], angle[i], &real[i], &imag[i]);
   }
   for (int32_t i = size_; i < fft_size_ >> 1; ++i) {
@@ -212,7 +240,14 @@ void FrameTransformation::QuantizeMagnitudes(float* xf_polar, float amount) {
     float scale_down = 0.5f * SemitonesToRatio(
         -108.0f * (1.0f - amount * amount)) / float(fft_size_);
     float scale_up = 1.0f / scale_down;
-    for (int32_t i = 0.0f; i < size_; ++i) {
+    int32_t i = 0;
+#ifdef FRAME_TRANSFORMATION_USE_SIMD
+    for (; i + kVectorSize <= size_; i += kVectorSize) {
+      Float4 x = Load(&xf_polar[i]);
+      Store(&xf_polar[i], scale_up * ToFloat(ToInt(scale_down * x)));
+    }
+#endif  // FRAME_TRANSFORMATION_USE_SIMD
+    for (; i < size_; ++i) {
       xf_polar[i] = scale_up * static_cast<float>(
           static_cast<int32_t>(scale_down * xf_polar[i]));
     }
@@ -220,7 +255,16 @@ void FrameTransformation::QuantizeMagnitudes(float* xf_polar, float amount) {
     amount = (amount - 0.52f) * 2.0f;
     float norm = *std::max_element(&xf_polar[0], &xf_polar[size_]);
     float inv_norm = 1.0f / (norm + 0.0001f);
-    for (int32_t i = 1.0f; i < size_; ++i) {
+    int32_t i = 1;
+#ifdef FRAME_TRANSFORMATION_USE_SIMD
+    for (; i + kVectorSize <= size_; i += kVectorSize) {
+      Float4 x = Load(&xf_polar[i]) * inv_norm;
+      Float4 x_c = 1.0f - x;
+      Float4 warped = 4.0f * x * x_c * x_c * x_c;
+      Store(&xf_polar[i], (x + (warped - x) * amount) * norm);
+    }
+#endif  // FRAME_TRANSFORMATION_USE_SIMD
+    for (; i < size_; ++i) {
       float x = xf_polar[i] * inv_norm;
       float warped = 4.0f * x * (1.0f - x) * (1.0f - x) * (1.0f - x);
       xf_polar[i] = (x + (warped - x) * amount) * norm;
@@ -259,7 +303,17 @@ void FrameTransformation::WarpMagnitudes(
   float c = coefficients[2];
   float d = coefficients[3];
   
-  for (int32_t i = 1.0f; i < size_; ++i) {
+  int32_t i = 1;
+#ifdef FRAME_TRANSFORMATION_USE_SIMD
+  const Float4 ramp = { 1.0f, 2.0f, 3.0f, 4.0f };
+  for (; i + kVectorSize <= size_; i += kVectorSize) {
+    Float4 f = (ramp + static_cast<float>(i - 1)) * bin_width;
+    Float4 wf = (d + f * (c + f * (b + a * f))) * static_cast<float>(size_);
+    Store(&xf_polar[i], InterpolateLinear(source, wf));
+  }
+  f = static_cast<float>(i - 1) * bin_width;
+#endif  // FRAME_TRANSFORMATION_USE_SIMD
+  for (; i < size_; ++i) {
     f += bin_width;
     float wf = (d + f * (c + f * (b + a * f))) * size_;
     xf_polar[i] = Interpolate(source, wf, 1.0f);
@@ -277,7 +331,16 @@ void FrameTransformation::ShiftMagnitudes(
   } else if (pitch_ratio > 1.0f) {
     float index = 1.0f;
     float increment = 1.0f / pitch_ratio;
-    for (int32_t i = 1; i < size_; ++i) {
+    int32_t i = 1;
+#ifdef FRAME_TRANSFORMATION_USE_SIMD
+    const Float4 ramp = { 0.0f, 1.0f, 2.0f, 3.0f };
+    for (; i + kVectorSize <= size_; i += kVectorSize) {
+      Float4 indices = (ramp + static_cast<float>(i - 1)) * increment + 1.0f;
+      Store(&temp[i], InterpolateLinear(source, indices));
+    }
+    index += static_cast<float>(i - 1) * increment;
+#endif  // FRAME_TRANSFORMATION_USE_SIMD
+    for (; i < size_; ++i) {
       temp[i] = Interpolate(source, index, 1.0f);
       index += increment;
     }
@@ -285,7 +348,26 @@ void FrameTransformation::ShiftMagnitudes(
     fill(&temp[0], &temp[size_], 0.0f);
     float index = 1.0f;
     float increment = pitch_ratio;
-    for (int32_t i = 1; i < size_; ++i) {
+    int32_t i = 1;
+#ifdef FRAME_TRANSFORMATION_USE_SIMD
+    // Destination bins might collide, so only the computation of the
+    // indices and weights is vectorized.
+    const Float4 ramp = { 0.0f, 1.0f, 2.0f, 3.0f };
+    for (; i + kVectorSize <= size_; i += kVectorSize) {
+      Float4 indices = (ramp + static_cast<float>(i - 1)) * increment + 1.0f;
+      Int4 integral = ToInt(indices);
+      Float4 fractional = indices - ToFloat(integral);
+      Float4 s = Load(&source[i]);
+      Float4 weight_b = fractional * s;
+      Float4 weight_a = s - weight_b;
+      for (size_t j = 0; j < kSimdWidth; ++j) {
+        temp[integral[j]] += weight_a[j];
+        temp[integral[j] + 1] += weight_b[j];
+      }
+    }
+    index += static_cast<float>(i - 1) * increment;
+#endif  // FRAME_TRANSFORMATION_USE_SIMD
+    for (; i < size_; ++i) {
       MAKE_INTEGRAL_FRACTIONAL(index)
       temp[index_integral] += (1.0f - index_fractional) * source[i];
       temp[index_integral + 1] += index_fractional * source[i];
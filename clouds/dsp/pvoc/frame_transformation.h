@@ -35,6 +35,10 @@
 
 #include "clouds/resources.h"
 
+#if defined(__SSE2__) || defined(__ARM_NEON__)
+  #define FRAME_TRANSFORMATION_USE_SIMD
+#endif
+
 namespace clouds {
 
 const int32_t kMaxNumTextures = 7;
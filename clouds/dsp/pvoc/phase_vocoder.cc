@@ -42,13 +42,21 @@ void PhaseVocoder::Init(
     size_t* buffer_size,
     const float* large_window_lut,
     size_t largest_fft_size,
+    size_t hop_ratio,
+    size_t latency,
     int32_t num_channels,
     int32_t resolution,
     float sample_rate) {
   num_channels_ = num_channels;
 
   size_t fft_size = largest_fft_size;
-  size_t hop_ratio = 4;
+  hop_ratio = min(max(hop_ratio, size_t(2)), fft_size);
+  size_t hop_size = fft_size / hop_ratio;
+  
+  // The latency budget is limited by the size of the analysis/synthesis
+  // buffers, which are 1.5x the FFT size. With a hop ratio of at least 2, one
+  // hop always fits.
+  latency = min(max(latency, size_t(1)), (fft_size >> 1) / hop_size);
   
   BufferAllocator allocator_0(buffer[0], buffer_size[0]);
   BufferAllocator allocator_1(buffer[1], buffer_size[1]);
@@ -68,7 +76,8 @@ void PhaseVocoder::Init(
     stft_[i].Init(
         &fft_,
         fft_size,
-        fft_size / hop_ratio,
+        hop_size,
+        latency,
         fft_buffer,
         ifft_buffer,
         large_window_lut,
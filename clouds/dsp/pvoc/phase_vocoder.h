@@ -31,6 +31,8 @@
 
 #include "stmlib/stmlib.h"
 
+#include <algorithm>
+
 #include "stmlib/fft/shy_fft.h"
 
 #include "clouds/dsp/frame.h"
@@ -49,6 +51,7 @@ class PhaseVocoder {
   void Init(
       void** buffer, size_t* buffer_size,
       const float* large_window_lut, size_t largest_fft_size,
+      size_t hop_ratio, size_t latency,
       int32_t num_channels,
       int32_t resolution,
       float sample_rate);
@@ -60,6 +63,22 @@ class PhaseVocoder {
       size_t size);
   void Buffer();
   
+  inline size_t pending() const {
+    size_t pending = 0;
+    for (int32_t i = 0; i < num_channels_; ++i) {
+      pending = std::max(pending, stft_[i].pending());
+    }
+    return pending;
+  }
+  
+  inline size_t num_late_hops() const {
+    size_t num_late_hops = 0;
+    for (int32_t i = 0; i < num_channels_; ++i) {
+      num_late_hops += stft_[i].num_late_hops();
+    }
+    return num_late_hops;
+  }
+  
  private:
   FFT fft_;
   
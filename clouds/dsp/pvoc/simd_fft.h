@@ -0,0 +1,381 @@
+// Copyright 2014 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Real FFT using 4-lane float vectors. The real input is packed into a complex
+// sequence of half the size, transformed with a radix-4 Stockham (autosort)
+// FFT, and split into the spectrum of the real input. Real and imaginary parts
+// are stored in separate arrays, so that each butterfly pass works on 4
+// contiguous butterflies at once.
+//
+// Same interface and data layout as stmlib::ShyFFT: the real parts of the
+// bins 0 .. n/2 - 1 are stored in out[0 .. n/2 - 1], the imaginary parts in
+// out[n/2 + 1 .. n - 1]; out[n/2] holds the (real) Nyquist bin. Neither the
+// direct nor the inverse transform is normalized.
+
+#ifndef CLOUDS_DSP_PVOC_SIMD_FFT_H_
+#define CLOUDS_DSP_PVOC_SIMD_FFT_H_
+
+#include "stmlib/stmlib.h"
+
+#include <cmath>
+
+#include "clouds/dsp/simd.h"
+
+namespace clouds {
+
+template<size_t size>
+class SimdFFT {
+ public:
+  enum {
+    max_size = size
+  };
+
+  SimdFFT() { }
+  ~SimdFFT() { }
+  
+  void Init() {
+    num_passes_ = 0;
+    for (size_t t = size; t > 1; t >>= 1) {
+      ++num_passes_;
+    }
+    for (size_t i = 0; i < size; ++i) {
+      double t = 2.0 * M_PI * static_cast<double>(i) / \
+          static_cast<double>(size);
+      cos_[i] = cos(t);
+      sin_[i] = sin(t);
+    }
+  }
+  
+  inline void Direct(const float* input, float* output) {
+    Direct(input, output, num_passes_);
+  }
+
+  inline void Inverse(const float* input, float* output) {
+    Inverse(input, output, num_passes_);
+  }
+  
+  void Direct(const float* input, float* output, size_t num_passes) {
+    const size_t n = static_cast<size_t>(1) << num_passes;
+    const size_t m = n >> 1;
+    const size_t stride = size / n;
+    
+    for (size_t i = 0; i < m; ++i) {
+      re_[0][i] = input[2 * i];
+      im_[0][i] = input[2 * i + 1];
+    }
+    int32_t result = Transform<false>(m);
+    const float* zr = re_[result];
+    const float* zi = im_[result];
+    
+    // Z[k] = E[k] + i O[k], where E and O are the spectra of the even and odd
+    // samples. X[k] = E[k] + W^k O[k].
+    output[0] = zr[0] + zi[0];
+    output[m] = zr[0] - zi[0];
+    size_t k = 1;
+    for (; k + kSimdWidth <= m; k += kSimdWidth) {
+      Float4 ar = Load(&zr[k]);
+      Float4 ai = Load(&zi[k]);
+      Float4 br = Reverse(Load(&zr[m - k - 3]));
+      Float4 bi = -Reverse(Load(&zi[m - k - 3]));
+      Float4 wr = GatherCos(k * stride, stride);
+      Float4 wi = -GatherSin(k * stride, stride);
+      SplitDirect(ar, ai, br, bi, wr, wi, &output[k], &output[m + k]);
+    }
+    for (; k < m; ++k) {
+      float wr = cos_[k * stride];
+      float wi = -sin_[k * stride];
+      SplitDirect(
+          zr[k], zi[k], zr[m - k], -zi[m - k], wr, wi,
+          &output[k], &output[m + k]);
+    }
+  }
+  
+  void Inverse(const float* input, float* output, size_t num_passes) {
+    const size_t n = static_cast<size_t>(1) << num_passes;
+    const size_t m = n >> 1;
+    const size_t stride = size / n;
+    
+    // Inverse of the split: Z[k] = 2 E[k] + 2i O[k], so that the output is
+    // scaled by n, as with ShyFFT.
+    const float* xr = &input[0];
+    const float* xi = &input[m];
+    float* zr = re_[0];
+    float* zi = im_[0];
+    zr[0] = xr[0] + input[m];
+    zi[0] = xr[0] - input[m];
+    size_t k = 1;
+    for (; k + kSimdWidth <= m; k += kSimdWidth) {
+      Float4 ar = Load(&xr[k]);
+      Float4 ai = Load(&xi[k]);
+      Float4 br = Reverse(Load(&xr[m - k - 3]));
+      Float4 bi = -Reverse(Load(&xi[m - k - 3]));
+      Float4 wr = GatherCos(k * stride, stride);
+      Float4 wi = GatherSin(k * stride, stride);
+      SplitInverse(ar, ai, br, bi, wr, wi, &zr[k], &zi[k]);
+    }
+    for (; k < m; ++k) {
+      float wr = cos_[k * stride];
+      float wi = sin_[k * stride];
+      SplitInverse(
+          xr[k], xi[k], xr[m - k], -xi[m - k], wr, wi, &zr[k], &zi[k]);
+    }
+    
+    int32_t result = Transform<true>(m);
+    zr = re_[result];
+    zi = im_[result];
+    for (size_t i = 0; i < m; ++i) {
+      output[2 * i] = zr[i];
+      output[2 * i + 1] = zi[i];
+    }
+  }
+  
+ private:
+  inline Float4 GatherCos(size_t i, size_t stride) const {
+    Float4 x = { cos_[i], cos_[i + stride], cos_[i + 2 * stride],
+        cos_[i + 3 * stride] };
+    return x;
+  }
+
+  inline Float4 GatherSin(size_t i, size_t stride) const {
+    Float4 x = { sin_[i], sin_[i + stride], sin_[i + 2 * stride],
+        sin_[i + 3 * stride] };
+    return x;
+  }
+  
+  template<typename T>
+  static inline void SplitDirect(
+      T ar, T ai, T br, T bi, T wr, T wi,
+      float* out_r, float* out_i) {
+    // A = Z[k], B = conj(Z[m - k]); 2E = A + B; 2O = -i (A - B).
+    T er = ar + br;
+    T ei = ai + bi;
+    T or_ = ai - bi;
+    T oi = br - ar;
+    Write(out_r, (er + wr * or_ - wi * oi) * 0.5f);
+    Write(out_i, (ei + wr * oi + wi * or_) * 0.5f);
+  }
+  
+  template<typename T>
+  static inline void SplitInverse(
+      T ar, T ai, T br, T bi, T wr, T wi,
+      float* out_r, float* out_i) {
+    // A = X[k], B = conj(X[m - k]); Z = (A + B) + i W^-k (A - B).
+    T dr = ar - br;
+    T di = ai - bi;
+    T tr = wr * dr - wi * di;
+    T ti = wr * di + wi * dr;
+    Write(out_r, ar + br - ti);
+    Write(out_i, ai + bi + tr);
+  }
+  
+  static inline void Write(float* destination, float x) {
+    *destination = x;
+  }
+
+  static inline void Write(float* destination, Float4 x) {
+    Store(destination, x);
+  }
+  
+  // Radix-4 butterfly, followed by the twiddle factors of outputs 1, 2, 3.
+  template<bool inverse, typename T>
+  static inline void Butterfly(
+      T ar, T ai, T br, T bi, T cr, T ci, T dr, T di,
+      T w1r, T w1i, T w2r, T w2i, T w3r, T w3i,
+      T* yr, T* yi) {
+    T apc_r = ar + cr;
+    T apc_i = ai + ci;
+    T amc_r = ar - cr;
+    T amc_i = ai - ci;
+    T bpd_r = br + dr;
+    T bpd_i = bi + di;
+    // j (b - d) for the direct transform, -j (b - d) for the inverse.
+    T jbmd_r = inverse ? bi - di : di - bi;
+    T jbmd_i = inverse ? dr - br : br - dr;
+    
+    yr[0] = apc_r + bpd_r;
+    yi[0] = apc_i + bpd_i;
+    T t_r = amc_r - jbmd_r;
+    T t_i = amc_i - jbmd_i;
+    yr[1] = t_r * w1r - t_i * w1i;
+    yi[1] = t_r * w1i + t_i * w1r;
+    t_r = apc_r - bpd_r;
+    t_i = apc_i - bpd_i;
+    yr[2] = t_r * w2r - t_i * w2i;
+    yi[2] = t_r * w2i + t_i * w2r;
+    t_r = amc_r + jbmd_r;
+    t_i = amc_i + jbmd_i;
+    yr[3] = t_r * w3r - t_i * w3i;
+    yi[3] = t_r * w3i + t_i * w3r;
+  }
+  
+  // Complex FFT of size n of re_[0] + i im_[0]. Returns the index of the
+  // buffer holding the result.
+  template<bool inverse>
+  int32_t Transform(size_t n) {
+    const float sign = inverse ? 1.0f : -1.0f;
+    int32_t source = 0;
+    size_t s = 1;
+    size_t l = n;
+    
+    while (l >= 4) {
+      const size_t l4 = l >> 2;
+      const size_t stride = size / l;
+      const float* xr = re_[source];
+      const float* xi = im_[source];
+      float* yr = re_[1 - source];
+      float* yi = im_[1 - source];
+      
+      if (s == 1 && l4 >= kSimdWidth) {
+        // First pass: butterflies are vectorized across p, and the outputs
+        // are transposed.
+        for (size_t p = 0; p < l4; p += kSimdWidth) {
+          Float4 or_[4];
+          Float4 oi[4];
+          Butterfly<inverse>(
+              Load(&xr[p]), Load(&xi[p]),
+              Load(&xr[p + l4]), Load(&xi[p + l4]),
+              Load(&xr[p + 2 * l4]), Load(&xi[p + 2 * l4]),
+              Load(&xr[p + 3 * l4]), Load(&xi[p + 3 * l4]),
+              GatherCos(p * stride, stride),
+              GatherSin(p * stride, stride) * sign,
+              GatherCos(2 * p * stride, 2 * stride),
+              GatherSin(2 * p * stride, 2 * stride) * sign,
+              GatherCos(3 * p * stride, 3 * stride),
+              GatherSin(3 * p * stride, 3 * stride) * sign,
+              or_, oi);
+          for (size_t j = 0; j < kSimdWidth; ++j) {
+            for (size_t i = 0; i < 4; ++i) {
+              yr[4 * (p + j) + i] = or_[i][j];
+              yi[4 * (p + j) + i] = oi[i][j];
+            }
+          }
+        }
+      } else if (s >= kSimdWidth) {
+        // Following passes: butterflies are vectorized across q.
+        for (size_t p = 0; p < l4; ++p) {
+          Float4 w1r = Splat(cos_[p * stride]);
+          Float4 w1i = Splat(sign * sin_[p * stride]);
+          Float4 w2r = Splat(cos_[2 * p * stride]);
+          Float4 w2i = Splat(sign * sin_[2 * p * stride]);
+          Float4 w3r = Splat(cos_[3 * p * stride]);
+          Float4 w3i = Splat(sign * sin_[3 * p * stride]);
+          for (size_t q = 0; q < s; q += kSimdWidth) {
+            const size_t i = q + s * p;
+            const size_t o = q + s * 4 * p;
+            Float4 or_[4];
+            Float4 oi[4];
+            Butterfly<inverse>(
+                Load(&xr[i]), Load(&xi[i]),
+                Load(&xr[i + s * l4]), Load(&xi[i + s * l4]),
+                Load(&xr[i + 2 * s * l4]), Load(&xi[i + 2 * s * l4]),
+                Load(&xr[i + 3 * s * l4]), Load(&xi[i + 3 * s * l4]),
+                w1r, w1i, w2r, w2i, w3r, w3i,
+                or_, oi);
+            for (size_t j = 0; j < 4; ++j) {
+              Store(&yr[o + j * s], or_[j]);
+              Store(&yi[o + j * s], oi[j]);
+            }
+          }
+        }
+      } else {
+        // Transforms too small to be vectorized.
+        for (size_t p = 0; p < l4; ++p) {
+          float w1r = cos_[p * stride];
+          float w1i = sign * sin_[p * stride];
+          float w2r = cos_[2 * p * stride];
+          float w2i = sign * sin_[2 * p * stride];
+          float w3r = cos_[3 * p * stride];
+          float w3i = sign * sin_[3 * p * stride];
+          for (size_t q = 0; q < s; ++q) {
+            const size_t i = q + s * p;
+            const size_t o = q + s * 4 * p;
+            float or_[4];
+            float oi[4];
+            Butterfly<inverse>(
+                xr[i], xi[i],
+                xr[i + s * l4], xi[i + s * l4],
+                xr[i + 2 * s * l4], xi[i + 2 * s * l4],
+                xr[i + 3 * s * l4], xi[i + 3 * s * l4],
+                w1r, w1i, w2r, w2i, w3r, w3i,
+                or_, oi);
+            for (size_t j = 0; j < 4; ++j) {
+              yr[o + j * s] = or_[j];
+              yi[o + j * s] = oi[j];
+            }
+          }
+        }
+      }
+      l = l4;
+      s <<= 2;
+      source = 1 - source;
+    }
+    
+    if (l == 2) {
+      // Odd number of passes: last pass is radix-2.
+      const float* xr = re_[source];
+      const float* xi = im_[source];
+      float* yr = re_[1 - source];
+      float* yi = im_[1 - source];
+      size_t q = 0;
+      for (; q + kSimdWidth <= s; q += kSimdWidth) {
+        Float4 ar = Load(&xr[q]);
+        Float4 ai = Load(&xi[q]);
+        Float4 br = Load(&xr[q + s]);
+        Float4 bi = Load(&xi[q + s]);
+        Store(&yr[q], ar + br);
+        Store(&yi[q], ai + bi);
+        Store(&yr[q + s], ar - br);
+        Store(&yi[q + s], ai - bi);
+      }
+      for (; q < s; ++q) {
+        float ar = xr[q];
+        float ai = xi[q];
+        float br = xr[q + s];
+        float bi = xi[q + s];
+        yr[q] = ar + br;
+        yi[q] = ai + bi;
+        yr[q + s] = ar - br;
+        yi[q + s] = ai - bi;
+      }
+      source = 1 - source;
+    }
+    return source;
+  }
+  
+  size_t num_passes_;
+  
+  float cos_[size];
+  float sin_[size];
+  
+  float re_[2][size / 2];
+  float im_[2][size / 2];
+  
+  DISALLOW_COPY_AND_ASSIGN(SimdFFT);
+};
+
+}  // namespace clouds
+
+#endif  // CLOUDS_DSP_PVOC_SIMD_FFT_H_
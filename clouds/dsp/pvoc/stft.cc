@@ -42,6 +42,7 @@ void STFT::Init(
     FFT* fft,
     size_t fft_size,
     size_t hop_size,
+    size_t latency,
     float* fft_buffer,
     float* ifft_buffer,
     const float* window_lut,
@@ -49,11 +50,14 @@ void STFT::Init(
     Modifier* modifier) {
   fft_size_ = fft_size;
   hop_size_ = hop_size;
+  latency_ = latency ? latency : 1;
   fft_num_passes_ = 0;
   for (size_t t = fft_size; t > 1; t >>= 1) {
     ++fft_num_passes_;
   }
-  buffer_size_ = fft_size_ + hop_size_;
+  // The analysis and synthesis ring buffers hold latency_ extra hops: this
+  // is the time Buffer() has to transform a hop before it is played back.
+  buffer_size_ = fft_size_ + latency_ * hop_size_;
   
   fft_ = fft;
 #ifdef USE_ARM_FFT
@@ -79,12 +83,13 @@ void STFT::Init(
 
 void STFT::Reset() {
   buffer_ptr_ = 0;
-  process_ptr_ = (2 * hop_size_) % buffer_size_;
+  process_ptr_ = ((latency_ + 1) * hop_size_) % buffer_size_;
   block_size_ = 0;
   fill(&analysis_[0], &analysis_[buffer_size_], 0);
   fill(&synthesis_[0], &synthesis_[buffer_size_], 0);
   ready_ = 0;
   done_ = 0;
+  num_late_hops_ = 0;
 }
 
 void STFT::Process(
@@ -112,15 +117,42 @@ void STFT::Process(
     }
     if (block_size_ >= hop_size_) {
       block_size_ -= hop_size_;
+      // Make the captured samples visible before publishing the hop.
+      __sync_synchronize();
       ++ready_;
+      if (ready_ - done_ > latency_) {
+        ++num_late_hops_;
+      }
     }
   }
 }
 
 void STFT::Buffer() {
-  if (ready_ == done_) {
+  size_t pending = ready_ - done_;
+  if (!pending) {
     return;
   }
+  __sync_synchronize();
+  
+  if (pending > latency_) {
+    // Too late, the output of the oldest hops has already been played. Skip
+    // them, and clear the part of the synthesis buffer they would have
+    // written first (it still holds the output of the previous lap).
+    while (--pending) {
+      size_t destination_ptr = process_ptr_ + fft_size_ - hop_size_;
+      for (size_t i = 0; i < hop_size_; ++i) {
+        if (destination_ptr >= buffer_size_) {
+          destination_ptr -= buffer_size_;
+        }
+        synthesis_[destination_ptr++] = 0;
+      }
+      ++done_;
+      process_ptr_ += hop_size_;
+      if (process_ptr_ >= buffer_size_) {
+        process_ptr_ -= buffer_size_;
+      }
+    }
+  }
   
   // Copy block to FFT buffer and apply window.
   size_t source_ptr = process_ptr_;
@@ -200,6 +232,7 @@ void STFT::Buffer() {
     w += window_stride_;
   }
 
+  __sync_synchronize();
   ++done_;
   process_ptr_ += hop_size_;
   if (process_ptr_ >= buffer_size_) {
@@ -31,10 +31,19 @@
 
 #include "stmlib/stmlib.h"
 
+// FFT backend. Except for the CMSIS one, a backend provides Init(), and
+// Direct()/Inverse() with an optional number of passes, with the data layout
+// and scaling of stmlib::ShyFFT.
 // #define USE_ARM_FFT
 
+#if !defined(USE_ARM_FFT) && (defined(__SSE2__) || defined(__ARM_NEON__))
+  #define USE_SIMD_FFT
+#endif
+
 #ifdef USE_ARM_FFT
   #include <arm_math.h>
+#elif defined(USE_SIMD_FFT)
+  #include "clouds/dsp/pvoc/simd_fft.h"
 #else
   #include "stmlib/fft/shy_fft.h"
 #endif  // USE_ARM_FFT
@@ -46,6 +55,8 @@ struct Parameters;
 const size_t kMaxFftSize = 4096;
 #ifdef USE_ARM_FFT
   typedef arm_rfft_fast_instance_f32 FFT;
+#elif defined(USE_SIMD_FFT)
+  typedef SimdFFT<kMaxFftSize> FFT;
 #else
   typedef stmlib::ShyFFT<float, kMaxFftSize, stmlib::RotationPhasor> FFT;
 #endif  // USE_ARM_FFT
@@ -63,6 +74,7 @@ class STFT {
       FFT* fft,
       size_t fft_size,
       size_t hop_size,
+      size_t latency,
       float* fft_buffer,
       float* ifft_buffer,
       const float* window_lut,
@@ -80,11 +92,18 @@ class STFT {
 
   void Buffer();
   
+  // Number of hops captured by Process() and still waiting for Buffer().
+  inline size_t pending() const { return ready_ - done_; }
+
+  // Number of hops which were not transformed in time by Buffer().
+  inline size_t num_late_hops() const { return num_late_hops_; }
+  
  private:
   FFT* fft_;
   size_t fft_size_;
   size_t fft_num_passes_;
   size_t hop_size_;
+  size_t latency_;
   size_t buffer_size_;
   float* fft_in_;
   float* fft_out_;
@@ -101,8 +120,11 @@ class STFT {
   size_t process_ptr_;
   size_t block_size_;
   
-  size_t ready_;
-  size_t done_;
+  // Written by Process() and Buffer() respectively, which might run in
+  // different threads (or in an interrupt and in the main loop).
+  volatile size_t ready_;
+  volatile size_t done_;
+  size_t num_late_hops_;
   
   const Parameters* parameters_;
   
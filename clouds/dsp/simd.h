@@ -0,0 +1,192 @@
+// Copyright 2014 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// 4-lane float vectors, using the GCC vector extensions. This compiles to SSE
+// on x86 hosts, to NEON on ARMv7-A/ARMv8, and is lowered to scalar code on
+// targets without a vector unit (like the Cortex-M4).
+
+#ifndef CLOUDS_DSP_SIMD_H_
+#define CLOUDS_DSP_SIMD_H_
+
+#include "stmlib/stmlib.h"
+
+#include <cstring>
+
+namespace clouds {
+
+const size_t kSimdWidth = 4;
+
+typedef float Float4 __attribute__((vector_size(16)));
+typedef int32_t Int4 __attribute__((vector_size(16)));
+typedef uint32_t UInt4 __attribute__((vector_size(16)));
+typedef uint16_t UShort4 __attribute__((vector_size(8)));
+
+inline Float4 Splat(float x) {
+  return Float4() + x;
+}
+
+inline Float4 Load(const float* source) {
+  Float4 x;
+  memcpy(&x, source, sizeof(x));
+  return x;
+}
+
+inline void Store(float* destination, Float4 x) {
+  memcpy(destination, &x, sizeof(x));
+}
+
+inline Float4 Abs(Float4 x) {
+  return x < 0.0f ? -x : x;
+}
+
+// Truncation towards zero, like static_cast<int32_t>.
+inline Int4 ToInt(Float4 x) {
+  return __builtin_convertvector(x, Int4);
+}
+
+inline Float4 ToFloat(Int4 x) {
+  return __builtin_convertvector(x, Float4);
+}
+
+inline Int4 Load(const int32_t* source) {
+  Int4 x;
+  memcpy(&x, source, sizeof(x));
+  return x;
+}
+
+inline void Store(int32_t* destination, Int4 x) {
+  memcpy(destination, &x, sizeof(x));
+}
+
+inline UInt4 Load(const uint32_t* source) {
+  UInt4 x;
+  memcpy(&x, source, sizeof(x));
+  return x;
+}
+
+inline Int4 Load(const uint16_t* source) {
+  UShort4 x;
+  memcpy(&x, source, sizeof(x));
+  return __builtin_convertvector(x, Int4);
+}
+
+// Wraps around, like static_cast<uint16_t>.
+inline void Store(uint16_t* destination, Int4 x) {
+  UShort4 y = __builtin_convertvector(x, UShort4);
+  memcpy(destination, &y, sizeof(y));
+}
+
+inline Float4 Gather(const float* table, Int4 index) {
+  Float4 x = { table[index[0]], table[index[1]],
+      table[index[2]], table[index[3]] };
+  return x;
+}
+
+// Linear interpolation, like stmlib::Interpolate with a size of 1.0.
+inline Float4 InterpolateLinear(const float* table, Float4 index) {
+  Int4 integral = ToInt(index);
+  Float4 fractional = index - ToFloat(integral);
+  Float4 a = Gather(table, integral);
+  Float4 b = Gather(table, integral + 1);
+  return a + (b - a) * fractional;
+}
+
+// Carmack's approximation, with two Newton iterations.
+inline Float4 FastRsqrt(Float4 x) {
+  Int4 i = 0x5f3759df - (reinterpret_cast<Int4>(x) >> 1);
+  Float4 y = reinterpret_cast<Float4>(i);
+  Float4 half_x = x * 0.5f;
+  y = y * (1.5f - half_x * y * y);
+  y = y * (1.5f - half_x * y * y);
+  return y;
+}
+
+// Polar form of x + iy. The angle is returned as a 16-bit phase (0 to 65535
+// for a full turn), like stmlib::fast_atan2r.
+inline Int4 FastAtan2r(Float4 y, Float4 x, Float4* r) {
+  Float4 squared_magnitude = x * x + y * y;
+  *r = squared_magnitude * FastRsqrt(squared_magnitude);
+  
+  Float4 abs_x = Abs(x);
+  Float4 abs_y = Abs(y);
+  Int4 steep = abs_y > abs_x;
+  Float4 numerator = steep ? abs_x : abs_y;
+  Float4 denominator = steep ? abs_y : abs_x;
+  denominator = denominator == 0.0f ? Splat(1.0f) : denominator;
+  Float4 t = numerator / denominator;
+  Float4 t2 = t * t;
+  
+  // Abramowitz & Stegun 4.4.47, |error| < 1e-5 rad; scaled to turns.
+  const float k = 1.0f / (2.0f * 3.14159265358979f);
+  Float4 a = t * (0.9998660f * k + t2 * (-0.3302995f * k + t2 * (
+      0.1801410f * k + t2 * (-0.0851330f * k + t2 * 0.0208351f * k))));
+  a = steep ? 0.25f - a : a;
+  a = x < 0.0f ? 0.5f - a : a;
+  a = y < 0.0f ? 1.0f - a : a;
+  return ToInt(a * 65536.0f + 0.5f) & 0xffff;
+}
+
+inline Float4 Reverse(Float4 x) {
+  const Int4 reverse = { 3, 2, 1, 0 };
+  return __builtin_shuffle(x, reverse);
+}
+
+inline Float4 Min(Float4 a, Float4 b) {
+  return a < b ? a : b;
+}
+
+inline Float4 Max(Float4 a, Float4 b) {
+  return a > b ? a : b;
+}
+
+// Saturates to the int16_t range, like stmlib::Clip16.
+inline Int4 SaturateInt16(Int4 x) {
+  x = x < -32768 ? -32768 : x;
+  return x > 32767 ? 32767 : x;
+}
+
+inline float Sum(Float4 x) {
+  return (x[0] + x[1]) + (x[2] + x[3]);
+}
+
+// Number of bits set in each byte of each lane. SSE2 has no popcount
+// instruction, so this uses the usual bit-twiddling reduction. The final
+// horizontal sum is left to SumBytes(), so that up to 31 partial counts can be
+// accumulated before it.
+inline UInt4 PopCountBytes(UInt4 x) {
+  x = x - ((x >> 1) & 0x55555555);
+  x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+  return (x + (x >> 4)) & 0x0f0f0f0f;
+}
+
+inline UInt4 SumBytes(UInt4 x) {
+  x = (x & 0x00ff00ff) + ((x >> 8) & 0x00ff00ff);
+  return (x & 0xffff) + (x >> 16);
+}
+
+}  // namespace clouds
+
+#endif  // CLOUDS_DSP_SIMD_H_
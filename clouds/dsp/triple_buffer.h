@@ -0,0 +1,94 @@
+// Copyright 2014 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Wait-free triple buffer, for passing complete snapshots of a structure from
+// one writer thread to one reader thread. Each side owns one slot; the third
+// one is exchanged atomically, so neither side ever waits for the other, and
+// the reader always gets the latest complete snapshot.
+
+#ifndef CLOUDS_DSP_TRIPLE_BUFFER_H_
+#define CLOUDS_DSP_TRIPLE_BUFFER_H_
+
+#include "stmlib/stmlib.h"
+
+namespace clouds {
+
+template<typename T>
+class TripleBuffer {
+ public:
+  TripleBuffer() { }
+  ~TripleBuffer() { }
+  
+  void Init() {
+    back_ = 0;
+    shared_ = 1;
+    front_ = 2;
+  }
+  
+  // Writer side: copies a snapshot into the back slot and publishes it.
+  inline void Write(const T& value) {
+    slots_[back_] = value;
+    // Make the content of the slot visible before publishing it.
+    __sync_synchronize();
+    back_ = Exchange(back_ | kFresh) & kIndexMask;
+  }
+  
+  // Reader side: returns true if a new snapshot has been published since the
+  // last call, in which case front() points to it.
+  inline bool Read() {
+    if (!(shared_ & kFresh)) {
+      return false;
+    }
+    front_ = Exchange(front_) & kIndexMask;
+    return true;
+  }
+  
+  inline const T& front() const { return slots_[front_]; }
+  
+ private:
+  static const uint32_t kFresh = 4;
+  static const uint32_t kIndexMask = 3;
+  
+  inline uint32_t Exchange(uint32_t value) {
+    // Atomic exchange (xchg on x86, ldrex/strex on ARM), with acquire
+    // semantics.
+    return __sync_lock_test_and_set(&shared_, value);
+  }
+  
+  T slots_[3];
+  
+  uint32_t back_;
+  uint32_t front_;
+  
+  // Index of the slot in transit, and whether it holds an unread snapshot.
+  volatile uint32_t shared_;
+  
+  DISALLOW_COPY_AND_ASSIGN(TripleBuffer);
+};
+
+}  // namespace clouds
+
+#endif  // CLOUDS_DSP_TRIPLE_BUFFER_H_
@@ -47,7 +47,10 @@
 
 namespace clouds {
 
+// Default maximum window size, and upper bound for the larger windows that
+// can be used when the correlator search completes within one block.
 const int32_t kMaxWSOLASize = 4096;
+const int32_t kLargestWSOLASize = 16384;
 
 using namespace stmlib;
 
@@ -58,9 +61,11 @@ class WSOLASamplePlayer {
   
   void Init(
       Correlator* correlator,
-      int32_t num_channels) {
+      int32_t num_channels,
+      int32_t max_window_size) {
     correlator_ = correlator;
     num_channels_ = num_channels;
+    max_window_size_ = max_window_size;
 
     pitch_ = 0.0f;
     position_ = 0.0f;
@@ -74,7 +79,7 @@ class WSOLASamplePlayer {
     search_source_ = 0;
     search_target_ = 0;
     
-    window_size_ = kMaxWSOLASize / 2;
+    window_size_ = max_window_size_ / 2;
     env_phase_ = 0.0f;
     env_phase_increment_ = 0.5f;
     elapsed_ = 0;
@@ -174,7 +179,10 @@ class WSOLASamplePlayer {
       return;
     }
     float stride = window_size_ / 2048.0f;
-    CONSTRAIN(stride, 1.0f, 2.0f);
+    // Larger windows are decimated more, to keep the number of candidates
+    // (and the cost of the search) the same as with the default size.
+    float max_stride = max_window_size_ / 2048.0f;
+    CONSTRAIN(stride, 1.0f, max_stride);
     stride *= 65536.0f;
     int32_t increment = static_cast<int32_t>(
           stride * (next_pitch_ratio_ < 1.25f ? 1.25f : next_pitch_ratio_));
@@ -237,7 +245,8 @@ class WSOLASamplePlayer {
     next_pitch_ratio_ = pitch_ratio;
     
     float size_factor = SemitonesToRatio((size_factor_ - 1.0f) * 60.0f);
-    int32_t new_window_size = static_cast<int32_t>(size_factor * kMaxWSOLASize);
+    int32_t new_window_size = static_cast<int32_t>(
+        size_factor * max_window_size_);
     if (abs(new_window_size - window_size_) > 64) {
       int32_t error = (new_window_size - window_size_) >> 5;
       new_window_size = window_size_ + error;
@@ -266,6 +275,7 @@ class WSOLASamplePlayer {
   Window windows_[2];
 
   int32_t window_size_;
+  int32_t max_window_size_;
   int32_t num_channels_;
   
   float pitch_;
@@ -0,0 +1,84 @@
+// Copyright 2014 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Runs GranularProcessor::Prepare() in a worker thread.
+
+#include "clouds/test/async_processor.h"
+
+namespace clouds {
+
+bool AsyncProcessor::Start(GranularProcessor* processor) {
+  processor_ = processor;
+  processor_->Prepare();
+  
+  sem_init(&request_, 0, 0);
+  quit_ = false;
+  if (pthread_create(&worker_, NULL, &WorkerEntryPoint, this)) {
+    sem_destroy(&request_);
+    return false;
+  }
+  return true;
+}
+
+void AsyncProcessor::Stop() {
+  quit_ = true;
+  sem_post(&request_);
+  pthread_join(worker_, NULL);
+  sem_destroy(&request_);
+}
+
+/* static */
+void* AsyncProcessor::WorkerEntryPoint(void* processor) {
+  static_cast<AsyncProcessor*>(processor)->Worker();
+  return NULL;
+}
+
+void AsyncProcessor::Worker() {
+  while (true) {
+    sem_wait(&request_);
+    // Drain all pending hops before honoring a stop request, so that the
+    // last block written by Process() is transformed.
+    do {
+      processor_->Prepare();
+    } while (processor_->playback_mode() == PLAYBACK_MODE_SPECTRAL &&
+             processor_->phase_vocoder().pending());
+    if (quit_) {
+      break;
+    }
+  }
+}
+
+void AsyncProcessor::Process(
+    ShortFrame* input,
+    ShortFrame* output,
+    size_t size) {
+  processor_->Process(input, output, size);
+  // sem_post is lock-free, and does not enter the kernel when the worker is
+  // busy.
+  sem_post(&request_);
+}
+
+}  // namespace clouds
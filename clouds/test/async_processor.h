@@ -0,0 +1,82 @@
+// Copyright 2014 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Runs GranularProcessor::Prepare() in a worker thread, like the main loop of
+// the firmware does while Process() is called from the audio interrupt. In
+// spectral mode, this hands off the FFT/transform/IFFT of each hop to the
+// worker; the audio thread only copies samples in and out of the STFT buffers.
+// In stretch mode with set_full_correlator_search(true), the worker completes
+// the search for the next splice point within one block.
+// Host only - this is not built into the firmware.
+
+#ifndef CLOUDS_TEST_ASYNC_PROCESSOR_H_
+#define CLOUDS_TEST_ASYNC_PROCESSOR_H_
+
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "stmlib/stmlib.h"
+
+#include "clouds/dsp/granular_processor.h"
+
+namespace clouds {
+
+class AsyncProcessor {
+ public:
+  AsyncProcessor() { }
+  ~AsyncProcessor() { }
+  
+  // Calls Prepare() once synchronously, so that the buffers are allocated
+  // before the first call to Process(), then starts the worker.
+  bool Start(GranularProcessor* processor);
+  
+  // Waits for the worker to catch up and stops it. The worker must be stopped
+  // while the playback mode, quality or spectral settings are changed.
+  void Stop();
+  
+  // Called from the audio thread. Never blocks.
+  void Process(ShortFrame* input, ShortFrame* output, size_t size);
+  
+  inline size_t num_late_hops() const {
+    return processor_->phase_vocoder().num_late_hops();
+  }
+  
+ private:
+  static void* WorkerEntryPoint(void* processor);
+  void Worker();
+  
+  GranularProcessor* processor_;
+  
+  pthread_t worker_;
+  sem_t request_;
+  volatile bool quit_;
+  
+  DISALLOW_COPY_AND_ASSIGN(AsyncProcessor);
+};
+
+}  // namespace clouds
+
+#endif  // CLOUDS_TEST_ASYNC_PROCESSOR_H_
@@ -29,11 +29,18 @@
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
 #include <vector>
 #include <xmmintrin.h>
 
 #include "clouds/dsp/granular_processor.h"
+#include "clouds/dsp/pvoc/frame_transformation.h"
+#include "clouds/dsp/pvoc/simd_fft.h"
+#include "clouds/dsp/simd.h"
 #include "clouds/resources.h"
+#include "stmlib/dsp/atan.h"
+#include "stmlib/fft/shy_fft.h"
+#include "clouds/test/async_processor.h"
 
 using namespace clouds;
 using namespace std;
@@ -223,8 +230,610 @@ void TestGrainSize() {
   }
 }
 
+void TestAsyncSpectral() {
+  // Spectral mode with 4096-point FFTs and 512-sample hops. The audio thread
+  // is paced in real time, and the transforms run in a worker thread which
+  // can lag behind by up to 2 hops.
+  size_t duration = 10;
+
+  FILE* fp_out = fopen("clouds_spectral.wav", "wb");
+
+  size_t remaining_samples = kSampleRate * duration;
+  write_wav_header(fp_out, remaining_samples, 2);
+  
+  uint8_t large_buffer[118784];
+  uint8_t small_buffer[65536 - 128]; 
+  
+  GranularProcessor processor;
+  processor.Init(
+      &large_buffer[0], sizeof(large_buffer),
+      &small_buffer[0],sizeof(small_buffer));
+
+  processor.set_num_channels(2);
+  processor.set_low_fidelity(false);
+  processor.set_playback_mode(PLAYBACK_MODE_SPECTRAL);
+  processor.set_spectral_hop_ratio(8);
+  processor.set_spectral_latency(2);
+  
+  Parameters* p = processor.mutable_parameters();
+  p->gate = false;
+  p->trigger = false;
+  p->freeze = false;
+  p->position = 0.0f;
+  p->size = 0.5f;
+  p->pitch = 0.0f;
+  p->density = 0.5f;
+  p->texture = 0.5f;
+  p->feedback = 0.0f;
+  p->dry_wet = 1.0f;
+  p->reverb = 0.0f;
+  p->stereo_spread = 0.0f;
+  
+  AsyncProcessor async_processor;
+  if (!async_processor.Start(&processor)) {
+    printf("Could not start worker thread\n");
+    return;
+  }
+  
+  timespec block_duration;
+  block_duration.tv_sec = 0;
+  block_duration.tv_nsec = 1000000000 / kSampleRate * kBlockSize;
+  
+  float phase = 0.0f;
+  size_t max_pending = 0;
+  clock_t start = clock();
+  while (remaining_samples) {
+    ShortFrame input[kBlockSize];
+    ShortFrame output[kBlockSize];
+    for (size_t i = 0; i < kBlockSize; ++i) {
+      phase += 220.0f / kSampleRate;
+      if (phase >= 1.0f) {
+        phase -= 1.0f;
+      }
+      input[i].l = input[i].r = 16384.0f * sinf(phase * M_PI * 2);
+    }
+    async_processor.Process(input, output, kBlockSize);
+    max_pending = std::max(max_pending, processor.phase_vocoder().pending());
+    fwrite(output, sizeof(ShortFrame), kBlockSize, fp_out);
+    remaining_samples -= kBlockSize;
+    nanosleep(&block_duration, NULL);
+  }
+  async_processor.Stop();
+  clock_t end = clock();
+  
+  printf("Audio thread + worker: %.3fs CPU for %ds of audio\n",
+      static_cast<float>(end - start) / CLOCKS_PER_SEC,
+      static_cast<int>(duration));
+  printf("Max pending hops: %d, late hops: %d\n",
+      static_cast<int>(max_pending),
+      static_cast<int>(async_processor.num_late_hops()));
+  fclose(fp_out);
+}
+
+typedef ShyFFT<float, kMaxFftSize, RotationPhasor> ReferenceFFT;
+
+void TestFFT() {
+  // Compares the spectra computed by ShyFFT and SimdFFT with a DFT computed
+  // in double precision.
+  static ReferenceFFT shy_fft;
+  static SimdFFT<kMaxFftSize> simd_fft;
+  shy_fft.Init();
+  simd_fft.Init();
+  
+  static float input[kMaxFftSize];
+  static float shy_out[kMaxFftSize];
+  static float simd_out[kMaxFftSize];
+  static float round_trip[kMaxFftSize];
+  static double dft[kMaxFftSize];
+  
+  for (size_t num_passes = 3; num_passes <= 12; ++num_passes) {
+    size_t n = 1 << num_passes;
+    for (size_t i = 0; i < n; ++i) {
+      input[i] = Random::GetFloat() * 2.0f - 1.0f;
+    }
+    for (size_t k = 0; k < n / 2; ++k) {
+      double re = 0.0;
+      double im = 0.0;
+      for (size_t i = 0; i < n; ++i) {
+        double t = 2.0 * M_PI * static_cast<double>(k * i % n) / n;
+        re += input[i] * cos(t);
+        im -= input[i] * sin(t);
+      }
+      dft[k] = re;
+      dft[k + n / 2] = im;
+    }
+    
+    shy_fft.Direct(input, shy_out, num_passes);
+    simd_fft.Direct(input, simd_out, num_passes);
+    simd_fft.Inverse(simd_out, round_trip, num_passes);
+    
+    // Bin n / 2 holds the imaginary part of the DC bin (always 0) or the
+    // Nyquist bin, depending on the implementation. Skip it.
+    double shy_error = 0.0;
+    double simd_error = 0.0;
+    double round_trip_error = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+      if (i != n / 2) {
+        shy_error = max(shy_error, fabs(shy_out[i] - dft[i]));
+        simd_error = max(simd_error, fabs(simd_out[i] - dft[i]));
+      }
+      round_trip_error = max(
+          round_trip_error,
+          fabs(round_trip[i] / static_cast<double>(n) - input[i]));
+    }
+    printf("%4d\tShyFFT: %.3e\tSimdFFT: %.3e\tround trip: %.3e\n",
+        static_cast<int>(n),
+        shy_error / sqrt(n),
+        simd_error / sqrt(n),
+        round_trip_error);
+  }
+}
+
+void BenchmarkFFT() {
+  static ReferenceFFT shy_fft;
+  static SimdFFT<kMaxFftSize> simd_fft;
+  shy_fft.Init();
+  simd_fft.Init();
+  
+  // The inverse transform is not normalized: it is written to its own
+  // buffer, so that each iteration transforms the same finite input.
+  static float input[kMaxFftSize];
+  static float spectrum[kMaxFftSize];
+  static float output[kMaxFftSize];
+  for (size_t i = 0; i < kMaxFftSize; ++i) {
+    input[i] = Random::GetFloat() * 2.0f - 1.0f;
+  }
+  
+  for (size_t num_passes = 6; num_passes <= 12; ++num_passes) {
+    size_t n = 1 << num_passes;
+    size_t num_iterations = (1 << 22) / n;
+    
+    clock_t start = clock();
+    for (size_t i = 0; i < num_iterations; ++i) {
+      shy_fft.Direct(input, spectrum, num_passes);
+      shy_fft.Inverse(spectrum, output, num_passes);
+    }
+    clock_t shy_time = clock() - start;
+    
+    start = clock();
+    for (size_t i = 0; i < num_iterations; ++i) {
+      simd_fft.Direct(input, spectrum, num_passes);
+      simd_fft.Inverse(spectrum, output, num_passes);
+    }
+    clock_t simd_time = clock() - start;
+    
+    printf("%4d\tShyFFT: %.2fus\tSimdFFT: %.2fus\tx%.2f\n",
+        static_cast<int>(n),
+        1e6f * shy_time / CLOCKS_PER_SEC / num_iterations,
+        1e6f * simd_time / CLOCKS_PER_SEC / num_iterations,
+        static_cast<float>(shy_time) / simd_time);
+  }
+}
+
+void TestPolarConversion() {
+  // Vectorized rectangular to polar conversion, compared with stmlib's
+  // scalar approximation and with the exact values.
+  double max_magnitude_error = 0.0;
+  double max_angle_error = 0.0;
+  double max_scalar_angle_error = 0.0;
+  for (size_t i = 0; i < 100000; ++i) {
+    float x[4];
+    float y[4];
+    for (size_t j = 0; j < 4; ++j) {
+      x[j] = (Random::GetFloat() * 2.0f - 1.0f) * 1000.0f;
+      y[j] = (Random::GetFloat() * 2.0f - 1.0f) * 1000.0f;
+    }
+    Float4 magnitude;
+    Int4 angle = FastAtan2r(Load(y), Load(x), &magnitude);
+    for (size_t j = 0; j < 4; ++j) {
+      double r = sqrt(double(x[j]) * x[j] + double(y[j]) * y[j]);
+      double a = atan2(double(y[j]), double(x[j])) / (2.0 * M_PI) * 65536.0;
+      float scalar_magnitude;
+      uint16_t scalar_angle = fast_atan2r(y[j], x[j], &scalar_magnitude);
+      max_magnitude_error = max(
+          max_magnitude_error, fabs(magnitude[j] - r) / r);
+      max_angle_error = max(
+          max_angle_error,
+          fabs(static_cast<int16_t>(angle[j] - static_cast<int32_t>(a))));
+      max_scalar_angle_error = max(
+          max_scalar_angle_error,
+          fabs(static_cast<int16_t>(scalar_angle - static_cast<int32_t>(a))));
+    }
+  }
+  printf("Relative magnitude error: %.3e\n", max_magnitude_error);
+  printf("Angle error (1/65536 turn): %.1f (scalar: %.1f)\n",
+      max_angle_error,
+      max_scalar_angle_error);
+}
+
+void BenchmarkFrameTransformation() {
+  // Time spent in FrameTransformation::Process for each hop of a
+  // 4096-point STFT.
+  const size_t fft_size = 4096;
+  const size_t num_textures = 7;
+  const size_t texture_size = (fft_size >> 1) - kHighFrequencyTruncation;
+  static float texture_buffer[num_textures * texture_size];
+  static float fft_out[fft_size];
+  static float ifft_in[fft_size];
+  
+  FrameTransformation transformation;
+  transformation.Init(texture_buffer, fft_size, num_textures);
+  
+  Parameters p;
+  memset(&p, 0, sizeof(p));
+  p.position = 0.3f;
+  p.pitch = 5.0f;
+  p.spectral.quantization = 0.8f;
+  p.spectral.refresh_rate = 0.5f;
+  p.spectral.phase_randomization = 0.1f;
+  p.spectral.warp = 0.3f;
+  
+  const size_t num_frames = 2000;
+  clock_t start = clock();
+  for (size_t i = 0; i < num_frames; ++i) {
+    for (size_t j = 0; j < fft_size; ++j) {
+      fft_out[j] = (Random::GetFloat() - 0.5f) * 100.0f;
+    }
+    transformation.Process(p, fft_out, ifft_in);
+  }
+  clock_t end = clock();
+  printf("%.2fus per frame\n",
+      1e6f * (end - start) / CLOCKS_PER_SEC / num_frames);
+}
+
+void BenchmarkGrainDensity() {
+  // Number of grains a single core can render in real time, for different
+  // grain caps. Above kMaxNumGrains, the high-density mode is used.
+  const int32_t buffer_size = 65536;
+  static int16_t samples[2][buffer_size];
+  static int16_t tail[2][kCrossFadeSize];
+  AudioBuffer<RESOLUTION_16_BIT> buffer[2];
+  for (int32_t i = 0; i < 2; ++i) {
+    buffer[i].Init(samples[i], buffer_size, tail[i]);
+    for (int32_t j = 0; j < buffer_size; ++j) {
+      buffer[i].Write(Random::GetFloat() - 0.5f);
+    }
+  }
+  
+  Parameters p;
+  memset(&p, 0, sizeof(p));
+  p.position = 0.5f;
+  p.size = 0.5f;
+  p.pitch = 3.0f;
+  p.stereo_spread = 0.5f;
+  p.granular.overlap = 1.0f;
+  p.granular.window_shape = 0.7f;
+  
+  const int32_t caps[] = { 64, 256, 512, 1024 };
+  for (size_t i = 0; i < sizeof(caps) / sizeof(caps[0]); ++i) {
+    static GranularSamplePlayer player;
+    player.Init(2, caps[i]);
+    
+    const size_t num_blocks = kSampleRate * 10 / kBlockSize;
+    float out[kBlockSize * 2];
+    double total_grains = 0.0;
+    clock_t start = clock();
+    for (size_t j = 0; j < num_blocks; ++j) {
+      player.Play(buffer, p, out, kBlockSize);
+      total_grains += player.num_active_grains();
+    }
+    clock_t end = clock();
+    
+    double cpu_time = static_cast<double>(end - start) / CLOCKS_PER_SEC;
+    double load = cpu_time / 10.0;
+    double average_grains = total_grains / num_blocks;
+    printf("cap %4d\t%.1f grains\t%.1f%% CPU\t%.0f grains per core\n",
+        caps[i],
+        average_grains,
+        load * 100.0,
+        average_grains / load);
+  }
+}
+
+struct ControlThreadState {
+  GranularProcessor* processor;
+  volatile bool done;
+  int32_t num_toggles;
+};
+
+void* ControlThread(void* arg) {
+  ControlThreadState* state = static_cast<ControlThreadState*>(arg);
+  Parameters parameters;
+  memset(&parameters, 0, sizeof(parameters));
+  for (int32_t i = 0; i < 200000; ++i) {
+    // All the fields of a snapshot have the same value, so a torn read is
+    // easy to detect.
+    float value = static_cast<float>(i % 1000) / 1000.0f;
+    parameters.position = value;
+    parameters.size = value;
+    parameters.pitch = value;
+    parameters.density = value;
+    parameters.texture = value;
+    parameters.stereo_spread = value;
+    parameters.feedback = value;
+    parameters.reverb = value;
+    parameters.dry_wet = value;
+    state->processor->PostParameters(parameters);
+    if (i % 997 == 0) {
+      state->processor->PostToggleFreeze();
+      ++state->num_toggles;
+    }
+  }
+  state->processor->PostPlaybackMode(PLAYBACK_MODE_LOOPING_DELAY);
+  __sync_synchronize();
+  state->done = true;
+  return NULL;
+}
+
+void TestControlChannel() {
+  uint8_t large_buffer[118784];
+  uint8_t small_buffer[65536 - 128]; 
+  
+  GranularProcessor processor;
+  processor.Init(
+      &large_buffer[0], sizeof(large_buffer),
+      &small_buffer[0],sizeof(small_buffer));
+  processor.set_playback_mode(PLAYBACK_MODE_GRANULAR);
+  processor.set_quality(0);
+  processor.set_freeze(false);
+  processor.Prepare();
+  
+  ShortFrame input[kBlockSize];
+  ShortFrame output[kBlockSize];
+  memset(input, 0, sizeof(input));
+  
+  // Changing the quality resets the buffers and unfreezes, so do it before
+  // the control thread starts toggling freeze.
+  processor.PostQuality(3);
+  processor.Process(input, output, kBlockSize);
+  processor.Prepare();
+
+  ControlThreadState state;
+  state.processor = &processor;
+  state.done = false;
+  state.num_toggles = 0;
+  
+  pthread_t thread;
+  if (pthread_create(&thread, NULL, &ControlThread, &state)) {
+    printf("Could not start control thread\n");
+    return;
+  }
+  
+  int32_t num_blocks = 0;
+  int32_t num_torn = 0;
+  bool done = false;
+  while (!done) {
+    // Check once more after the control thread has finished, to pick up its
+    // last snapshot.
+    done = state.done;
+    processor.Process(input, output, kBlockSize);
+    processor.Prepare();
+    const Parameters& p = processor.parameters();
+    if (p.size != p.position || p.pitch != p.position ||
+        p.density != p.position || p.texture != p.position ||
+        p.stereo_spread != p.position || p.feedback != p.position ||
+        p.reverb != p.position || p.dry_wet != p.position) {
+      ++num_torn;
+    }
+    ++num_blocks;
+  }
+  pthread_join(thread, NULL);
+  
+  printf("%d blocks, %d torn snapshots\n", num_blocks, num_torn);
+  printf("Freeze: %d (expected %d)\n",
+      processor.frozen(), state.num_toggles & 1);
+  printf("Playback mode: %d (expected %d), quality: %d (expected %d)\n",
+      processor.playback_mode(), PLAYBACK_MODE_LOOPING_DELAY,
+      processor.quality(), 3);
+}
+
+void TestCorrelator() {
+  // Compares the one-pass search with the candidate-by-candidate search, on
+  // random data with a known splice point.
+  const int32_t size = 2048;
+  const int32_t num_words = size / 32;
+  static uint32_t source[num_words + 2];
+  static uint32_t destination[2 * num_words + 2];
+  
+  Correlator correlator;
+  correlator.Init(source, destination);
+  
+  const int32_t num_searches = 200;
+  int32_t num_mismatches = 0;
+  double incremental_time = 0.0;
+  double one_pass_time = 0.0;
+  for (int32_t n = 0; n < num_searches; ++n) {
+    for (int32_t i = 0; i < 2 * num_words + 2; ++i) {
+      destination[i] = Random::GetWord();
+    }
+    // Copy a shifted excerpt of the destination into the source, with some
+    // noise.
+    int32_t match = Random::GetWord() % size;
+    for (int32_t i = 0; i < num_words; ++i) {
+      int32_t bit = match + i * 32;
+      uint32_t word = destination[bit >> 5] << (bit & 0x1f);
+      if (bit & 0x1f) {
+        word |= destination[(bit >> 5) + 1] >> (32 - (bit & 0x1f));
+      }
+      source[i] = word ^ (Random::GetWord() & Random::GetWord());
+    }
+    
+    correlator.StartSearch(size, 0, 1 << 16);
+    clock_t start = clock();
+    while (!correlator.done()) {
+      correlator.EvaluateNextCandidate();
+    }
+    incremental_time += clock() - start;
+    int32_t incremental_match = correlator.best_match();
+    
+    correlator.StartSearch(size, 0, 1 << 16);
+    start = clock();
+    correlator.EvaluateAllCandidates();
+    one_pass_time += clock() - start;
+    int32_t one_pass_match = correlator.best_match();
+    
+    if (incremental_match != one_pass_match || one_pass_match != match) {
+      ++num_mismatches;
+    }
+  }
+  printf("Mismatches: %d / %d\n", num_mismatches, num_searches);
+  printf("Incremental: %.1fus, one pass: %.1fus per search\n",
+      1e6 * incremental_time / CLOCKS_PER_SEC / num_searches,
+      1e6 * one_pass_time / CLOCKS_PER_SEC / num_searches);
+}
+
+// The reverb of clouds::Reverb, processed sample by sample as it was before
+// the block-wise FxEngine processing.
+class SampleBySampleReverb {
+ public:
+  typedef FxEngine<16384, FORMAT_12_BIT> E;
+  
+  void Init(uint16_t* buffer) {
+    engine_.Init(buffer);
+    engine_.SetLFOFrequency(LFO_1, 0.5f / 32000.0f);
+    engine_.SetLFOFrequency(LFO_2, 0.3f / 32000.0f);
+    lp_decay_1_ = lp_decay_2_ = 0.0f;
+  }
+  
+  void Process(
+      FloatFrame* in_out, size_t size,
+      float amount, float gain, float krt, float kap, float klp) {
+    typedef E::Reserve<113,
+      E::Reserve<162,
+      E::Reserve<241,
+      E::Reserve<399,
+      E::Reserve<1653,
+      E::Reserve<2038,
+      E::Reserve<3411,
+      E::Reserve<1913,
+      E::Reserve<1663,
+      E::Reserve<4782> > > > > > > > > > Memory;
+    E::DelayLine<Memory, 0> ap1;
+    E::DelayLine<Memory, 1> ap2;
+    E::DelayLine<Memory, 2> ap3;
+    E::DelayLine<Memory, 3> ap4;
+    E::DelayLine<Memory, 4> dap1a;
+    E::DelayLine<Memory, 5> dap1b;
+    E::DelayLine<Memory, 6> del1;
+    E::DelayLine<Memory, 7> dap2a;
+    E::DelayLine<Memory, 8> dap2b;
+    E::DelayLine<Memory, 9> del2;
+    E::Context c;
+    float lp_1 = lp_decay_1_;
+    float lp_2 = lp_decay_2_;
+    while (size--) {
+      float wet;
+      float apout = 0.0f;
+      engine_.Start(&c);
+      c.Interpolate(ap1, 10.0f, LFO_1, 60.0f, 1.0f);
+      c.Write(ap1, 100, 0.0f);
+      c.Read(in_out->l + in_out->r, gain);
+      c.Read(ap1 TAIL, kap);
+      c.WriteAllPass(ap1, -kap);
+      c.Read(ap2 TAIL, kap);
+      c.WriteAllPass(ap2, -kap);
+      c.Read(ap3 TAIL, kap);
+      c.WriteAllPass(ap3, -kap);
+      c.Read(ap4 TAIL, kap);
+      c.WriteAllPass(ap4, -kap);
+      c.Write(apout);
+      c.Load(apout);
+      c.Interpolate(del2, 4680.0f, LFO_2, 100.0f, krt);
+      c.Lp(lp_1, klp);
+      c.Read(dap1a TAIL, -kap);
+      c.WriteAllPass(dap1a, kap);
+      c.Read(dap1b TAIL, kap);
+      c.WriteAllPass(dap1b, -kap);
+      c.Write(del1, 2.0f);
+      c.Write(wet, 0.0f);
+      in_out->l += (wet - in_out->l) * amount;
+      c.Load(apout);
+      c.Read(del1 TAIL, krt);
+      c.Lp(lp_2, klp);
+      c.Read(dap2a TAIL, kap);
+      c.WriteAllPass(dap2a, -kap);
+      c.Read(dap2b TAIL, -kap);
+      c.WriteAllPass(dap2b, kap);
+      c.Write(del2, 2.0f);
+      c.Write(wet, 0.0f);
+      in_out->r += (wet - in_out->r) * amount;
+      ++in_out;
+    }
+    lp_decay_1_ = lp_1;
+    lp_decay_2_ = lp_2;
+  }
+  
+ private:
+  E engine_;
+  float lp_decay_1_;
+  float lp_decay_2_;
+};
+
+void BenchmarkReverb() {
+  // Compares the block-wise reverb with the sample-by-sample one, on a minute
+  // of noise bursts.
+  static uint16_t block_buffer[16384];
+  static uint16_t reference_buffer[16384];
+  Reverb reverb;
+  SampleBySampleReverb reference;
+  reverb.Init(block_buffer);
+  reference.Init(reference_buffer);
+  
+  const float amount = 0.5f;
+  const float gain = 0.2f;
+  const float time = 0.9f;
+  const float diffusion = 0.7f;
+  const float lp = 0.8f;
+  reverb.set_amount(amount);
+  reverb.set_input_gain(gain);
+  reverb.set_time(time);
+  reverb.set_diffusion(diffusion);
+  reverb.set_lp(lp);
+  
+  const size_t num_samples = kSampleRate * 60;
+  vector<FloatFrame> block(num_samples);
+  for (size_t i = 0; i < num_samples; ++i) {
+    float noise = (i % 32000) < 3200 ? Random::GetFloat() - 0.5f : 0.0f;
+    block[i].l = noise;
+    block[i].r = -noise;
+  }
+  vector<FloatFrame> reference_block(block);
+  
+  clock_t start = clock();
+  for (size_t i = 0; i < num_samples; i += kBlockSize) {
+    reverb.Process(&block[i], kBlockSize);
+  }
+  clock_t block_time = clock() - start;
+  
+  start = clock();
+  for (size_t i = 0; i < num_samples; i += kBlockSize) {
+    reference.Process(
+        &reference_block[i], kBlockSize, amount, gain, time, diffusion, lp);
+  }
+  clock_t reference_time = clock() - start;
+  
+  float max_error = 0.0f;
+  for (size_t i = 0; i < num_samples; ++i) {
+    max_error = max(max_error, fabsf(block[i].l - reference_block[i].l));
+    max_error = max(max_error, fabsf(block[i].r - reference_block[i].r));
+  }
+  printf("Max error: %g\n", max_error);
+  printf("Sample by sample: %.3fs, block-wise: %.3fs for 60s of audio\n",
+      static_cast<float>(reference_time) / CLOCKS_PER_SEC,
+      static_cast<float>(block_time) / CLOCKS_PER_SEC);
+}
+
 int main(void) {
   _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
   TestDSP();
   // TestGrainSize();
+  // TestAsyncSpectral();
+  // TestFFT();
+  // BenchmarkFFT();
+  // TestPolarConversion();
+  // BenchmarkFrameTransformation();
+  // BenchmarkGrainDensity();
+  // TestControlChannel();
+  // TestCorrelator();
+  // BenchmarkReverb();
 }
@@ -34,6 +34,7 @@
 #include "stmlib/dsp/units.h"
 
 #include "elements/dsp/dsp.h"
+#include "elements/dsp/simd.h"
 #include "elements/resources.h"
 
 namespace elements {
@@ -53,6 +54,7 @@ void Exciter::Init() {
   particle_state_ = 0.5f;
   damping_ = 0.0f;
   signature_ = 0.0f;
+  sample_bank_ = NULL;
 }
 
 float Exciter::GetPulseAmplitude(float cutoff) {
@@ -84,6 +86,10 @@ void Exciter::Process(const uint8_t flags, float* out, size_t size) {
 
 void Exciter::ProcessGranularSamplePlayer(
     const uint8_t flags, float* out, size_t size) {
+  if (sample_bank_) {
+    ProcessDecodedGranularSamplePlayer(flags, out, size);
+    return;
+  }
   const uint32_t restart_prob = uint32_t(0.01f * 4294967296.0f);
   const uint32_t restart_point = uint32_t(parameter_ * 32767.0f) << 17;
   const uint32_t phase_increment = static_cast<uint32_t>(
@@ -109,6 +115,10 @@ void Exciter::ProcessGranularSamplePlayer(
 
 void Exciter::ProcessSamplePlayer(
     const uint8_t flags, float* out, size_t size) {
+  if (sample_bank_) {
+    ProcessDecodedSamplePlayer(flags, out, size);
+    return;
+  }
   float index = (1.0f - parameter_) * 8.0f;
   MAKE_INTEGRAL_FRACTIONAL(index);
   if (index_integral == 8) {
@@ -165,6 +175,147 @@ void Exciter::ProcessSamplePlayer(
   damp_state_ = damp;
 }
 
+// Same as ProcessGranularSamplePlayer, reading the noise sample from the
+// bank. This one is not vectorized: the random restarts have to be drawn
+// sample by sample, and they dominate the cost.
+void Exciter::ProcessDecodedGranularSamplePlayer(
+    const uint8_t flags, float* out, size_t size) {
+  const uint32_t restart_prob = uint32_t(0.01f * 4294967296.0f);
+  const uint32_t restart_point = uint32_t(parameter_ * 32767.0f) << 17;
+  const uint32_t phase_increment = static_cast<uint32_t>(
+      131072.0f * SemitonesToRatio(72.0f * timbre_ - 60.0f));
+  const float* base = &sample_bank_->noise_sample()[static_cast<size_t>(
+      signature_ * 8192.0f)];
+  
+  uint32_t phase = phase_;
+  while (size--) {
+    uint32_t phase_integral = phase >> 17;
+    float phase_fractional = static_cast<float>(phase & 0x1ffff) / 131072.0f;
+    float a = base[phase_integral];
+    float b = base[phase_integral + 1];
+    *out++ = a + (b - a) * phase_fractional;
+    phase += phase_increment;
+    if (Random::GetWord() < restart_prob) {
+      phase = restart_point;
+    }
+  }
+  phase_ = phase;
+  damping_ = 0.0f;
+}
+
+// Reads 4 pairs of consecutive samples, for 4 consecutive phase increments.
+static inline void ReadSamples(
+    const float* sample,
+    uint32_t phase,
+    uint32_t phase_increment,
+    Float4* a,
+    Float4* b) {
+  float a_[kSimdWidth];
+  float b_[kSimdWidth];
+  for (size_t i = 0; i < kSimdWidth; ++i) {
+    uint32_t phase_integral = phase >> 16;
+    a_[i] = sample[phase_integral];
+    b_[i] = sample[phase_integral + 1];
+    phase += phase_increment;
+  }
+  *a = Load(a_);
+  *b = Load(b_);
+}
+
+// Same as ProcessSamplePlayer, reading the samples from the bank, which can
+// hold any number of samples. Once both samples are over, the phase no
+// longer moves and the output is silent; until then, the phase moves by a
+// fixed increment, so 4 samples can be interpolated and crossfaded at once.
+void Exciter::ProcessDecodedSamplePlayer(
+    const uint8_t flags, float* out, size_t size) {
+  const int32_t last_sample = sample_bank_->num_samples() - 1;
+  float index = (1.0f - parameter_) * static_cast<float>(last_sample);
+  MAKE_INTEGRAL_FRACTIONAL(index);
+  if (index_integral == last_sample) {
+    index_integral = last_sample - 1;
+    index_fractional = 1.0f;
+  }
+  
+  const float* sample_1 = sample_bank_->sample(index_integral);
+  const float* sample_2 = sample_bank_->sample(index_integral + 1);
+  const uint32_t length_1 = sample_bank_->sample_size(index_integral);
+  const uint32_t length_2 = sample_bank_->sample_size(index_integral + 1);
+  const uint32_t length = max(length_1, length_2);
+  const uint32_t phase_increment = static_cast<uint32_t>(
+      65536.0f * SemitonesToRatio(72.0f * timbre_ - 36.0f + 7.0f));
+  
+  float damp = damp_state_;
+  uint32_t phase = phase_;
+
+  if (flags & EXCITER_FLAG_RISING_EDGE) {
+    damp = 0.0f;
+    phase = 0;
+  }
+  if (!(flags & EXCITER_FLAG_GATE)) {
+    damp = 1.0f - 0.95f * (1.0f - damp);
+  }
+  
+  const Float4 crossfade = Splat(index_fractional);
+  const Int4 lane_offset = { 0, 1, 2, 3 };
+  while (size) {
+    uint32_t phase_integral = phase >> 16;
+    if (phase_integral >= length) {
+      fill(&out[0], &out[size], 0.0f);
+      break;
+    }
+    
+    // 4 samples at once, as long as each sample is either playing or over
+    // for all of them.
+    uint64_t last_phase = phase +
+        static_cast<uint64_t>(kSimdWidth - 1) * phase_increment;
+    uint64_t last_phase_integral = last_phase >> 16;
+    bool uniform_1 = last_phase_integral < length_1 ||
+        phase_integral >= length_1;
+    bool uniform_2 = last_phase_integral < length_2 ||
+        phase_integral >= length_2;
+    if (size >= kSimdWidth && last_phase_integral < length &&
+        uniform_1 && uniform_2) {
+      Float4 a_1 = Splat(0.0f), b_1 = a_1, a_2 = a_1, b_2 = a_1;
+      if (phase_integral < length_1) {
+        ReadSamples(sample_1, phase, phase_increment, &a_1, &b_1);
+      }
+      if (phase_integral < length_2) {
+        ReadSamples(sample_2, phase, phase_increment, &a_2, &b_2);
+      }
+      Int4 phase_fractional = (Int4() + static_cast<int32_t>(phase) +
+          lane_offset * static_cast<int32_t>(phase_increment)) & 0xffff;
+      Float4 t = ToFloat(phase_fractional) * (1.0f / 65536.0f);
+      Float4 s_1 = a_1 + (b_1 - a_1) * t;
+      Float4 s_2 = a_2 + (b_2 - a_2) * t;
+      Store(out, s_1 + (s_2 - s_1) * crossfade);
+      phase += kSimdWidth * phase_increment;
+      out += kSimdWidth;
+      size -= kSimdWidth;
+      continue;
+    }
+    
+    float phase_fractional = static_cast<float>(phase & 0xffff) / 65536.0f;
+    float s_1 = 0.0f;
+    float s_2 = 0.0f;
+    if (phase_integral < length_1) {
+      float a = sample_1[phase_integral];
+      float b = sample_1[phase_integral + 1];
+      s_1 = a + (b - a) * phase_fractional;
+    }
+    if (phase_integral < length_2) {
+      float a = sample_2[phase_integral];
+      float b = sample_2[phase_integral + 1];
+      s_2 = a + (b - a) * phase_fractional;
+    }
+    phase += phase_increment;
+    *out++ = s_1 + (s_2 - s_1) * index_fractional;
+    --size;
+  }
+  phase_ = phase;
+  damping_ = damp * (parameter_ >= 0.8f ? parameter_ * 5.0f - 4.0f : 0.0f);
+  damp_state_ = damp;
+}
+
 void Exciter::ProcessMallet(const uint8_t flags, float* out, size_t size) {
   fill(&out[0], &out[size], 0.0f);
   if (flags & EXCITER_FLAG_RISING_EDGE) {
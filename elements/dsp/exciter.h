@@ -34,6 +34,8 @@
 #include "stmlib/dsp/filter.h"
 #include "stmlib/utils/random.h"
 
+#include "elements/dsp/exciter_sample_bank.h"
+
 namespace elements {
 
 enum ExciterModel {
@@ -77,6 +79,12 @@ class Exciter {
     timbre_ = timbre;
   }
   
+  // When set, the sample players read the samples from this bank instead
+  // of decoding the ROM on every read. The firmware leaves it unset.
+  inline void set_sample_bank(const ExciterSampleBank* sample_bank) {
+    sample_bank_ = sample_bank;
+  }
+  
   inline void set_meta(float meta, ExciterModel first, ExciterModel last) {
     meta *= static_cast<float>(last - first + 1);
     MAKE_INTEGRAL_FRACTIONAL(meta);
@@ -104,6 +112,8 @@ class Exciter {
   
  private:
   float GetPulseAmplitude(float cutoff);
+  void ProcessDecodedGranularSamplePlayer(const uint8_t, float*, size_t);
+  void ProcessDecodedSamplePlayer(const uint8_t, float*, size_t);
 
   inline float RandomSample() const {
     return static_cast<float>(stmlib::Random::GetWord()) / 4294967296.0f;
@@ -123,6 +133,8 @@ class Exciter {
   uint32_t delay_;
   uint32_t plectrum_delay_;
   
+  const ExciterSampleBank* sample_bank_;
+  
   static ProcessFn fn_table_[];
   
   DISALLOW_COPY_AND_ASSIGN(Exciter);
@@ -0,0 +1,82 @@
+// Copyright 2014 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Exciter samples decoded to float.
+
+#include "elements/dsp/exciter_sample_bank.h"
+
+namespace elements {
+
+bool ExciterSampleBank::Init(float* storage, size_t storage_size) {
+  return Init(
+      smp_sample_data,
+      smp_boundaries,
+      SMP_BOUNDARIES_SIZE - 1,
+      smp_noise_sample,
+      SMP_NOISE_SAMPLE_SIZE,
+      storage,
+      storage_size);
+}
+
+bool ExciterSampleBank::Init(
+    const int16_t* sample_data,
+    const size_t* boundaries,
+    size_t num_samples,
+    const int16_t* noise_sample,
+    size_t noise_sample_size,
+    float* storage,
+    size_t storage_size) {
+  num_samples_ = 0;
+  const size_t sample_data_size = boundaries[num_samples] - boundaries[0];
+  if (num_samples < 2 || num_samples > kMaxExciterSamples ||
+      noise_sample_size < kMinExciterNoiseSampleSize ||
+      sample_data_size + noise_sample_size > storage_size) {
+    return false;
+  }
+  
+  // Same scaling as the players: 1/65536 for the samples (the sum of two
+  // channels), 1/32768 for the noise.
+  for (size_t i = 0; i < sample_data_size; ++i) {
+    storage[i] = static_cast<float>(sample_data[boundaries[0] + i]) / 65536.0f;
+  }
+  for (size_t i = 0; i < num_samples; ++i) {
+    if (boundaries[i + 1] <= boundaries[i] ||
+        boundaries[i + 1] - boundaries[i] - 1 > kMaxExciterSampleSize) {
+      return false;
+    }
+    sample_[i] = &storage[boundaries[i] - boundaries[0]];
+    sample_size_[i] = boundaries[i + 1] - boundaries[i] - 1;
+  }
+  storage += sample_data_size;
+  for (size_t i = 0; i < noise_sample_size; ++i) {
+    storage[i] = static_cast<float>(noise_sample[i]) / 32768.0f;
+  }
+  noise_sample_ = storage;
+  num_samples_ = num_samples;
+  return true;
+}
+
+}  // namespace elements
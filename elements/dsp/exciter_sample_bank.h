@@ -0,0 +1,110 @@
+// Copyright 2014 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Exciter samples decoded to float.
+
+#ifndef ELEMENTS_DSP_EXCITER_SAMPLE_BANK_H_
+#define ELEMENTS_DSP_EXCITER_SAMPLE_BANK_H_
+
+#include "stmlib/stmlib.h"
+
+#include "elements/resources.h"
+
+namespace elements {
+
+const size_t kMaxExciterSamples = 64;
+
+// The sample players keep their position in the sample as a 16.16 phase,
+// also handled as a signed integer by the vectorized player, so a sample
+// cannot be longer than this many frames (not counting the interpolation
+// tail).
+const size_t kMaxExciterSampleSize = 32767;
+
+// The granular sample player reads up to 32768 samples after a start point
+// chosen among the first 8192 samples.
+const size_t kMinExciterNoiseSampleSize = 8192 + 32768 + 1;
+
+// Number of floats to provide to ExciterSampleBank::Init() for the samples
+// stored in ROM.
+const size_t kExciterSampleBankRomSize =
+    SMP_SAMPLE_DATA_SIZE + SMP_NOISE_SAMPLE_SIZE;
+
+// The samples used by the sample players, converted once to floats (scaled
+// like the output of the players), so that the players do not have to
+// convert them on every read. A bank can also be filled with a sample pack
+// other than the one in ROM, with any number of samples. The bank is
+// immutable once initialized, and can be shared by any number of exciters
+// used from any number of threads. The ROM samples take about 660kB as
+// floats, so this is for hosts only.
+class ExciterSampleBank {
+ public:
+  ExciterSampleBank() : num_samples_(0) { }
+  ~ExciterSampleBank() { }
+  
+  // Decodes the samples stored in ROM into storage, which must hold
+  // kExciterSampleBankRomSize floats.
+  bool Init(float* storage, size_t storage_size);
+  
+  // Decodes a sample pack with the same layout as the ROM: the samples are
+  // concatenated in sample_data, sample i spanning from boundaries[i] to
+  // boundaries[i + 1] - 1 (the last sample of each being an interpolation
+  // tail). Returns false if storage is too small, if there are too many or
+  // too few samples, if a sample is empty or longer than
+  // kMaxExciterSampleSize, or if the noise sample is too short.
+  bool Init(
+      const int16_t* sample_data,
+      const size_t* boundaries,
+      size_t num_samples,
+      const int16_t* noise_sample,
+      size_t noise_sample_size,
+      float* storage,
+      size_t storage_size);
+  
+  inline size_t num_samples() const { return num_samples_; }
+  
+  inline const float* sample(size_t index) const {
+    return sample_[index];
+  }
+  
+  // Number of samples that can be read, not counting the interpolation tail.
+  inline size_t sample_size(size_t index) const {
+    return sample_size_[index];
+  }
+  
+  inline const float* noise_sample() const { return noise_sample_; }
+  
+ private:
+  size_t num_samples_;
+  const float* sample_[kMaxExciterSamples];
+  size_t sample_size_[kMaxExciterSamples];
+  const float* noise_sample_;
+  
+  DISALLOW_COPY_AND_ASSIGN(ExciterSampleBank);
+};
+
+}  // namespace elements
+
+#endif  // ELEMENTS_DSP_EXCITER_SAMPLE_BANK_H_
@@ -53,21 +53,23 @@ class Diffuser {
     E::DelayLine<Memory, 1> ap2;
     E::DelayLine<Memory, 2> ap3;
     E::DelayLine<Memory, 3> ap4;
-    E::Context c;
+    E::BlockContext c;
     const float kap = 0.625f;
-    while (size--) {
-      engine_.Start(&c);
-      c.Read(*in_out);
-      c.Read(ap1 TAIL, kap);
-      c.WriteAllPass(ap1, -kap);
-      c.Read(ap2 TAIL, kap);
-      c.WriteAllPass(ap2, -kap);
-      c.Read(ap3 TAIL, kap);
-      c.WriteAllPass(ap3, -kap);
-      c.Read(ap4 TAIL, kap);
-      c.WriteAllPass(ap4, -kap);
-      c.Write(*in_out, 0.0f);
-      ++in_out;
+    // All delay lines are longer than a block, so they can be processed one
+    // block at a time. The end of AP4 is adjacent to the beginning of AP1 in
+    // the circular buffer, so it is read before AP1 is written.
+    float ap4_tail[E::max_block_size];
+    while (size) {
+      size_t block_size = std::min(
+          size, static_cast<size_t>(E::max_block_size));
+      engine_.StartBlock(&c, block_size);
+      c.Read(ap4 TAIL, ap4_tail);
+      c.AllPass(ap1, kap, in_out);
+      c.AllPass(ap2, kap, in_out);
+      c.AllPass(ap3, kap, in_out);
+      c.AllPass(ap4, kap, ap4_tail, in_out);
+      in_out += block_size;
+      size -= block_size;
     }
   }
   
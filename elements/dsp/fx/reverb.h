@@ -46,6 +46,7 @@ class Reverb {
     engine_.SetLFOFrequency(LFO_2, 0.3f / 32000.0f);
     lp_ = 0.7f;
     diffusion_ = 0.625f;
+    lp_decay_1_ = lp_decay_2_ = 0.0f;
   }
   
   void Process(float* left, float* right, size_t size) {
@@ -53,6 +54,9 @@ class Reverb {
     // (4 AP diffusers on the input, then a loop of 2x 2AP+1Delay).
     // Modulation is applied in the loop of the first diffuser AP for additional
     // smearing; and to the two long delays for a slow shimmer/chorus effect.
+    //
+    // The delay lines are processed one block at a time. The smearing of AP1
+    // reads samples written 10 samples earlier, which bounds the block size.
     typedef E::Reserve<150,
       E::Reserve<214,
       E::Reserve<319,
@@ -73,7 +77,7 @@ class Reverb {
     E::DelayLine<Memory, 7> dap2a;
     E::DelayLine<Memory, 8> dap2b;
     E::DelayLine<Memory, 9> del2;
-    E::Context c;
+    E::BlockContext c;
 
     const float kap = diffusion_;
     const float klp = lp_;
@@ -83,57 +87,61 @@ class Reverb {
 
     float lp_1 = lp_decay_1_;
     float lp_2 = lp_decay_2_;
+    
+    float apout[kBlockSize];
+    float x[kBlockSize];
+    float tap[kBlockSize];
 
-    while (size--) {
-      float wet;
-      float apout = 0.0f;
-      engine_.Start(&c);
+    while (size) {
+      size_t block_size = std::min(size, static_cast<size_t>(kBlockSize));
+      engine_.StartBlock(&c, block_size);
       
       // Smear AP1 inside the loop.
-      c.Interpolate(ap1, 10.0f, LFO_1, 80.0f, 1.0f);
-      c.Write(ap1, 100, 0.0f);
+      c.Interpolate(ap1, 10.0f, LFO_1, 80.0f, tap);
+      c.Write(ap1, 100, tap);
+      
+      for (size_t i = 0; i < block_size; ++i) {
+        apout[i] = (left[i] + right[i]) * gain;
+      }
       
-      c.Read(*left + *right, gain);
-
       // Diffuse through 4 allpasses.
-      c.Read(ap1 TAIL, kap);
-      c.WriteAllPass(ap1, -kap);
-      c.Read(ap2 TAIL, kap);
-      c.WriteAllPass(ap2, -kap);
-      c.Read(ap3 TAIL, kap);
-      c.WriteAllPass(ap3, -kap);
-      c.Read(ap4 TAIL, kap);
-      c.WriteAllPass(ap4, -kap);
-      c.Write(apout);
+      c.AllPass(ap1, kap, apout);
+      c.AllPass(ap2, kap, apout);
+      c.AllPass(ap3, kap, apout);
+      c.AllPass(ap4, kap, apout);
       
       // Main reverb loop.
-      c.Load(apout);
-      c.Interpolate(del2, 6211.0f, LFO_2, 100.0f, krt);
-      c.Lp(lp_1, klp);
-      c.Read(dap1a TAIL, -kap);
-      c.WriteAllPass(dap1a, kap);
-      c.Read(dap1b TAIL, kap);
-      c.WriteAllPass(dap1b, -kap);
-      c.Write(del1, 2.0f);
-      c.Write(wet, 0.0f);
+      c.Interpolate(del2, 6211.0f, LFO_2, 100.0f, tap);
+      for (size_t i = 0; i < block_size; ++i) {
+        x[i] = apout[i] + tap[i] * krt;
+        lp_1 += klp * (x[i] - lp_1);
+        x[i] = lp_1;
+      }
+      c.AllPass(dap1a, -kap, x);
+      c.AllPass(dap1b, kap, x);
+      c.Write(del1, x);
+      for (size_t i = 0; i < block_size; ++i) {
+        float wet = x[i] * 2.0f;
+        left[i] += (wet - left[i]) * amount;
+      }
 
-      *left += (wet - *left) * amount;
-
-      c.Load(apout);
-      // c.Interpolate(del1, 4450.0f, LFO_1, 50.0f, krt);
-      c.Read(del1 TAIL, krt);
-      c.Lp(lp_2, klp);
-      c.Read(dap2a TAIL, kap);
-      c.WriteAllPass(dap2a, -kap);
-      c.Read(dap2b TAIL, -kap);
-      c.WriteAllPass(dap2b, kap);
-      c.Write(del2, 2.0f);
-      c.Write(wet, 0.0f);
-
-      *right += (wet - *right) * amount;
+      c.Read(del1 TAIL, tap);
+      for (size_t i = 0; i < block_size; ++i) {
+        x[i] = apout[i] + tap[i] * krt;
+        lp_2 += klp * (x[i] - lp_2);
+        x[i] = lp_2;
+      }
+      c.AllPass(dap2a, kap, x);
+      c.AllPass(dap2b, -kap, x);
+      c.Write(del2, x);
+      for (size_t i = 0; i < block_size; ++i) {
+        float wet = x[i] * 2.0f;
+        right[i] += (wet - right[i]) * amount;
+      }
       
-      ++left;
-      ++right;
+      left += block_size;
+      right += block_size;
+      size -= block_size;
     }
     
     lp_decay_1_ = lp_1;
@@ -161,6 +169,10 @@ class Reverb {
   }
   
  private:
+  enum {
+    kBlockSize = 8
+  };
+  
   typedef FxEngine<32768, FORMAT_16_BIT> E;
   E engine_;
   
@@ -82,6 +82,13 @@ class Part {
   inline ResonatorModel resonator_model() const { return resonator_model_; }
   inline void set_resonator_model(ResonatorModel r) { resonator_model_ = r; }
   
+  // Host only: reads the exciter samples from a decoded bank.
+  inline void set_sample_bank(const ExciterSampleBank* sample_bank) {
+    for (size_t i = 0; i < kNumVoices; ++i) {
+      voice_[i].set_sample_bank(sample_bank);
+    }
+  }
+  
  private:
   Patch patch_;
   Voice voice_[kNumVoices];
@@ -50,6 +50,16 @@ void Resonator::Init() {
     f_bow_[i].Init();
     d_bow_[i].Init();
   }
+#ifdef RESONATOR_USE_SIMD
+  for (size_t i = 0; i < kMaxModeVectors; ++i) {
+    state_1_[i] = Float4();
+    state_2_[i] = Float4();
+  }
+  for (size_t i = 0; i < kMaxBowedModeVectors; ++i) {
+    bow_state_1_[i] = Float4();
+    bow_state_2_[i] = Float4();
+  }
+#endif  // RESONATOR_USE_SIMD
   
   set_frequency(220.0f / kSampleRate);
   set_geometry(0.25f);
@@ -60,6 +70,8 @@ void Resonator::Init() {
   set_resolution(kMaxModes);
   
   bow_signal_ = 0.0f;
+  lfo_phase_ = 0.0f;
+  clock_divider_ = 0;
 }
 
 size_t Resonator::ComputeFilters() {
@@ -125,6 +137,16 @@ void Resonator::Process(
     float* center,
     float* sides,
     size_t size) {
+  Process<kResonatorBackend>(bow_strength, in, center, sides, size);
+}
+
+template<>
+void Resonator::Process<RESONATOR_BACKEND_SCALAR>(
+    const float* bow_strength,
+    const float* in,
+    float* center,
+    float* sides,
+    size_t size) {
   size_t num_modes = ComputeFilters();
   size_t num_banded_wg = min(kMaxBowedModes, num_modes);
   // Linearly interpolate position. This parameter is extremely sensitive to
@@ -185,4 +207,194 @@ void Resonator::Process(
   }
 }
 
+#ifdef RESONATOR_USE_SIMD
+
+// Mode amplitudes follow the recurrence of CosineOscillator,
+// u[n + 1] = c u[n] - u[n - 1], with u[-n] = u[n] (+ 0.5 offset). With 4 modes
+// per vector, the recurrence becomes u[n + 4] = c4 u[n] - u[n - 4], with
+// c4 = c^4 - 4c^2 + 2; and it is split into two interleaved chains, for the
+// even and odd vectors, with u[n + 8] = c8 u[n] - u[n - 8], c8 = c4^2 - 2, to
+// halve its latency.
+struct ModeAmplitudes {
+  void Init(float position) {
+    CosineOscillator oscillator;
+    oscillator.Init<COSINE_OSCILLATOR_APPROXIMATE>(position);
+    oscillator.Start();
+    float u[kSimdWidth + 1];
+    u[0] = oscillator.Next() - 0.5f;
+    u[1] = oscillator.Next() - 0.5f;
+    const float c = 4.0f * u[1];
+    for (size_t i = 2; i <= kSimdWidth; ++i) {
+      u[i] = c * u[i - 1] - u[i - 2];
+    }
+    const float c2 = c * c;
+    const float c4 = c2 * c2 - 4.0f * c2 + 2.0f;
+    c8 = Splat(c4 * c4 - 2.0f);
+    
+    const Float4 u_0 = { u[0], u[1], u[2], u[3] };
+    const Float4 u_minus_4 = { u[4], u[3], u[2], u[1] };
+    even = u_0;
+    odd = c4 * u_0 - u_minus_4;
+    even_previous = c4 * u_minus_4 - u_0;
+    odd_previous = u_minus_4;
+  }
+  
+  inline void Next() {
+    const Float4 even_next = c8 * even - even_previous;
+    const Float4 odd_next = c8 * odd - odd_previous;
+    even_previous = even;
+    odd_previous = odd;
+    even = even_next;
+    odd = odd_next;
+  }
+  
+  Float4 c8;
+  Float4 even;
+  Float4 even_previous;
+  Float4 odd;
+  Float4 odd_previous;
+};
+
+template<>
+void Resonator::Process<RESONATOR_BACKEND_SIMD>(
+    const float* bow_strength,
+    const float* in,
+    float* center,
+    float* sides,
+    size_t size) {
+  const size_t num_modes = ComputeFilters();
+  const size_t num_banded_wg = min(kMaxBowedModes, num_modes);
+  
+  // The modes are processed by groups of 8 (2 vectors).
+  const size_t num_vectors = (num_modes + 2 * kSimdWidth - 1) /
+      (2 * kSimdWidth) * 2;
+  
+  // Gather the coefficients computed by ComputeFilters() into vectors.
+  Float4 g[kMaxModeVectors];
+  Float4 r_plus_g[kMaxModeVectors];
+  Float4 h[kMaxModeVectors];
+  Float4 active[kMaxModeVectors];
+  for (size_t i = 0; i < num_vectors; ++i) {
+    for (size_t j = 0; j < kSimdWidth; ++j) {
+      const size_t mode = i * kSimdWidth + j;
+      const Svf& f = f_[mode];
+      g[i][j] = f.g();
+      r_plus_g[i][j] = f.r() + f.g();
+      h[i][j] = f.h();
+      active[i][j] = mode < num_modes ? 1.0f : 0.0f;
+    }
+  }
+  Float4 bow_g[kMaxBowedModeVectors];
+  Float4 bow_r[kMaxBowedModeVectors];
+  Float4 bow_r_plus_g[kMaxBowedModeVectors];
+  Float4 bow_h[kMaxBowedModeVectors];
+  Float4 bow_gain[kMaxBowedModeVectors];
+  for (size_t i = 0; i < kMaxBowedModeVectors; ++i) {
+    for (size_t j = 0; j < kSimdWidth; ++j) {
+      const size_t mode = i * kSimdWidth + j;
+      const Svf& f = f_bow_[mode];
+      bow_g[i][j] = f.g();
+      bow_r[i][j] = f.r();
+      bow_r_plus_g[i][j] = f.r() + f.g();
+      bow_h[i][j] = f.h();
+      bow_gain[i][j] = mode < num_banded_wg ? 8.0f : 0.0f;
+    }
+  }
+  
+  Float4 state_1[kMaxModeVectors];
+  Float4 state_2[kMaxModeVectors];
+  Float4 bow_state_1[kMaxBowedModeVectors];
+  Float4 bow_state_2[kMaxBowedModeVectors];
+  copy(&state_1_[0], &state_1_[num_vectors], &state_1[0]);
+  copy(&state_2_[0], &state_2_[num_vectors], &state_2[0]);
+  copy(&bow_state_1_[0], &bow_state_1_[kMaxBowedModeVectors], &bow_state_1[0]);
+  copy(&bow_state_2_[0], &bow_state_2_[kMaxBowedModeVectors], &bow_state_2[0]);
+  
+  float position_increment = (position_ - previous_position_) / size;
+  while (size--) {
+    lfo_phase_ += modulation_frequency_;
+    if (lfo_phase_ >= 1.0f) {
+      lfo_phase_ -= 1.0f;
+    }
+    previous_position_ += position_increment;
+    float lfo = lfo_phase_ > 0.5f ? 1.0f - lfo_phase_ : lfo_phase_;
+    
+    ModeAmplitudes amplitudes;
+    ModeAmplitudes aux_amplitudes;
+    amplitudes.Init(previous_position_);
+    aux_amplitudes.Init(modulation_offset_ + lfo);
+    
+    // The bowed modes use the amplitudes of the first 8 modes.
+    const Float4 bow_amplitude[kMaxBowedModeVectors] = {
+      amplitudes.even + 0.5f,
+      amplitudes.odd + 0.5f
+    };
+    
+    // Render normal modes.
+    float input = *in++ * 0.125f;
+    const Float4 input_4 = Splat(input);
+    Float4 sum_center = Float4();
+    Float4 sum_side = Float4();
+    for (size_t i = 0; i < num_vectors; i += 2) {
+      Float4 bp[2];
+      for (size_t j = 0; j < 2; ++j) {
+        const size_t v = i + j;
+        Float4 hp = (input_4 - r_plus_g[v] * state_1[v] - state_2[v]) * h[v];
+        bp[j] = g[v] * hp + state_1[v];
+        state_1[v] = g[v] * hp + bp[j];
+        Float4 lp = g[v] * bp[j] + state_2[v];
+        state_2[v] = g[v] * bp[j] + lp;
+        bp[j] *= active[v];
+      }
+      sum_center += bp[0] * (amplitudes.even + 0.5f);
+      sum_center += bp[1] * (amplitudes.odd + 0.5f);
+      sum_side += bp[0] * (aux_amplitudes.even + 0.5f);
+      sum_side += bp[1] * (aux_amplitudes.odd + 0.5f);
+      amplitudes.Next();
+      aux_amplitudes.Next();
+    }
+    float center_modes = Sum(sum_center);
+    *sides++ = Sum(sum_side) - center_modes;
+    
+    // Render bowed modes. The delay lines are read and written one by one,
+    // their filters 4 at a time.
+    float delayed[kMaxBowedModes];
+    float bow_signal = 0.0f;
+    for (size_t i = 0; i < kMaxBowedModes; ++i) {
+      delayed[i] = 0.0f;
+      if (i < num_banded_wg) {
+        delayed[i] = 0.99f * d_bow_[i].Read();
+        bow_signal += delayed[i];
+      }
+    }
+    const Float4 bow_input = Splat(input + bow_signal_);
+    Float4 sum_bowed = Float4();
+    float filtered[kMaxBowedModes];
+    for (size_t i = 0; i < kMaxBowedModeVectors; ++i) {
+      Float4 x = bow_input + Load(&delayed[i * kSimdWidth]);
+      Float4 hp = (x - bow_r_plus_g[i] * bow_state_1[i] - bow_state_2[i]) *
+          bow_h[i];
+      Float4 bp = bow_g[i] * hp + bow_state_1[i];
+      bow_state_1[i] = bow_g[i] * hp + bp;
+      Float4 lp = bow_g[i] * bp + bow_state_2[i];
+      bow_state_2[i] = bow_g[i] * bp + lp;
+      bp *= bow_r[i];
+      Store(&filtered[i * kSimdWidth], bp);
+      sum_bowed += bp * bow_amplitude[i] * bow_gain[i];
+    }
+    for (size_t i = 0; i < num_banded_wg; ++i) {
+      d_bow_[i].Write(filtered[i]);
+    }
+    bow_signal_ = BowTable(bow_signal, *bow_strength++);
+    *center++ = center_modes + Sum(sum_bowed);
+  }
+  
+  copy(&state_1[0], &state_1[num_vectors], &state_1_[0]);
+  copy(&state_2[0], &state_2[num_vectors], &state_2_[0]);
+  copy(&bow_state_1[0], &bow_state_1[kMaxBowedModeVectors], &bow_state_1_[0]);
+  copy(&bow_state_2[0], &bow_state_2[kMaxBowedModeVectors], &bow_state_2_[0]);
+}
+
+#endif  // RESONATOR_USE_SIMD
+
 }  // namespace elements
@@ -35,14 +35,34 @@
 #include <algorithm>
 
 #include "elements/dsp/dsp.h"
+#include "elements/dsp/simd.h"
 #include "stmlib/dsp/filter.h"
 #include "stmlib/dsp/delay_line.h"
 
+// On hosts with a vector unit, the modes are processed 4 at a time. The scalar
+// code is kept as the reference implementation.
+#if defined(__SSE2__) || defined(__ARM_NEON__)
+  #define RESONATOR_USE_SIMD
+#endif  // __SSE2__ || __ARM_NEON__
+
 namespace elements {
 
 const size_t kMaxModes = 64;
 const size_t kMaxBowedModes = 8;
 const size_t kMaxDelayLineSize = 1024;
+const size_t kMaxModeVectors = kMaxModes / kSimdWidth;
+const size_t kMaxBowedModeVectors = kMaxBowedModes / kSimdWidth;
+
+enum ResonatorBackend {
+  RESONATOR_BACKEND_SCALAR,
+  RESONATOR_BACKEND_SIMD
+};
+
+#ifdef RESONATOR_USE_SIMD
+const ResonatorBackend kResonatorBackend = RESONATOR_BACKEND_SIMD;
+#else
+const ResonatorBackend kResonatorBackend = RESONATOR_BACKEND_SCALAR;
+#endif  // RESONATOR_USE_SIMD
 
 class Resonator {
  public:
@@ -50,6 +70,15 @@ class Resonator {
   ~Resonator() { }
   
   void Init();
+  
+  void Process(
+      const float* bow_strength,
+      const float* in,
+      float* center,
+      float* sides,
+      size_t size);
+  
+  template<ResonatorBackend backend>
   void Process(
       const float* bow_strength,
       const float* in,
@@ -124,11 +153,38 @@ class Resonator {
   stmlib::Svf f_bow_[kMaxBowedModes];
   stmlib::DelayLine<float, kMaxDelayLineSize> d_bow_[kMaxBowedModes];
   
+#ifdef RESONATOR_USE_SIMD
+  // Filter state for the vectorized implementation, 4 modes per vector. The
+  // delay lines of the bowed modes are shared with the scalar code.
+  Float4 state_1_[kMaxModeVectors];
+  Float4 state_2_[kMaxModeVectors];
+  Float4 bow_state_1_[kMaxBowedModeVectors];
+  Float4 bow_state_2_[kMaxBowedModeVectors];
+#endif  // RESONATOR_USE_SIMD
+  
   size_t clock_divider_;
   
   DISALLOW_COPY_AND_ASSIGN(Resonator);
 };
 
+template<>
+void Resonator::Process<RESONATOR_BACKEND_SCALAR>(
+    const float* bow_strength,
+    const float* in,
+    float* center,
+    float* sides,
+    size_t size);
+
+#ifdef RESONATOR_USE_SIMD
+template<>
+void Resonator::Process<RESONATOR_BACKEND_SIMD>(
+    const float* bow_strength,
+    const float* in,
+    float* center,
+    float* sides,
+    size_t size);
+#endif  // RESONATOR_USE_SIMD
+
 }  // namespace elements
 
 #endif  // ELEMENTS_DSP_RESONATOR_H_
@@ -45,6 +45,14 @@ void Voice::Init() {
   strike_.Init();
   diffuser_.Init(diffuser_buffer_);
   
+  resonator_backend_ = kResonatorBackend;
+#ifdef RESONATOR_USE_SIMD
+  // The vectorized resonator runs all the modes faster than the scalar one
+  // runs 52.
+  resonator_resolution_ = kMaxModes;
+#else
+  resonator_resolution_ = 52;  // Runs with 56 extremely tightly.
+#endif  // RESONATOR_USE_SIMD
   ResetResonator();
 
   bow_.set_model(EXCITER_MODEL_FLOW);
@@ -70,7 +78,7 @@ void Voice::ResetResonator() {
     string_[i].Init(true);
   }
   dc_blocker_.Init(1.0f - 10.0f / kSampleRate);
-  resonator_.set_resolution(52);  // Runs with 56 extremely tightly.
+  resonator_.set_resolution(resonator_resolution_);
 }
 
 float chords[11][5] = {
@@ -219,7 +227,12 @@ void Voice::Process(
     resonator_.set_modulation_offset(patch.resonator_modulation_offset);
 
     // Process through resonator.
-    resonator_.Process(bow_strength_buffer_, raw, center, sides, size);
+    if (resonator_backend_ == RESONATOR_BACKEND_SCALAR) {
+      resonator_.Process<RESONATOR_BACKEND_SCALAR>(
+          bow_strength_buffer_, raw, center, sides, size);
+    } else {
+      resonator_.Process(bow_strength_buffer_, raw, center, sides, size);
+    }
   } else {
     size_t num_notes = resonator_model_ == RESONATOR_MODEL_STRING
         ? 1
@@ -78,6 +78,21 @@ class Voice {
   void set_resonator_model(ResonatorModel resonator_model) {
     resonator_model_ = resonator_model;
   }
+  // By default, the modal resonator runs all the modes on hosts with a vector
+  // unit, and 52 modes with the scalar backend otherwise. Both can be changed
+  // to compare their cost.
+  void set_resonator_backend(ResonatorBackend resonator_backend) {
+    resonator_backend_ = resonator_backend;
+  }
+  void set_resonator_resolution(size_t resonator_resolution) {
+    resonator_resolution_ = resonator_resolution;
+    resonator_.set_resolution(resonator_resolution);
+  }
+  void set_sample_bank(const ExciterSampleBank* sample_bank) {
+    bow_.set_sample_bank(sample_bank);
+    blow_.set_sample_bank(sample_bank);
+    strike_.set_sample_bank(sample_bank);
+  }
   
  private:
   void ResetResonator();
@@ -121,6 +136,8 @@ class Voice {
   bool previous_gate_;
   
   ResonatorModel resonator_model_;
+  ResonatorBackend resonator_backend_;
+  size_t resonator_resolution_;
   float chord_index_;
   
   DISALLOW_COPY_AND_ASSIGN(Voice);
@@ -13,16 +13,21 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <cstring>
 #include <cstdlib>
+#include <ctime>
 #include <xmmintrin.h>
 
+#include "stmlib/dsp/units.h"
+
 #include "elements/dsp/exciter.h"
 #include "elements/dsp/part.h"
 #include "elements/dsp/resonator.h"
 #include "elements/dsp/voice.h"
+#include "elements/test/exciter_sample_pack.h"
 
 using namespace elements;
 using namespace stmlib;
@@ -490,6 +495,229 @@ void TestFilterAccuracy() {
   }
 }
 
+void RenderSamplePlayer(
+    ExciterModel model,
+    const ExciterSampleBank* bank,
+    float* out,
+    size_t num_blocks) {
+  Exciter exciter;
+  exciter.Init();
+  exciter.set_model(model);
+  exciter.set_sample_bank(bank);
+  Random::Seed(0x21);
+  for (size_t i = 0; i < num_blocks; ++i) {
+    // Sweep the parameters, with notes of varying length.
+    float ramp = static_cast<float>(i % 4096) / 4096.0f;
+    exciter.set_parameter(ramp);
+    exciter.set_timbre(static_cast<float>((i * 7) % 1000) / 1000.0f);
+    exciter.set_signature(static_cast<float>((i * 13) % 1000) / 1000.0f);
+    uint8_t flags = 0;
+    size_t note_length = 64 + (i / 64) % 512;
+    if (i % note_length < note_length / 2) flags |= EXCITER_FLAG_GATE;
+    if (i % note_length == 0) flags |= EXCITER_FLAG_RISING_EDGE;
+    exciter.Process(flags, out, kAudioBlockSize);
+    out += kAudioBlockSize;
+  }
+}
+
+void CompareExciterSamplePlayers() {
+  const size_t num_blocks = ::kSampleRate * 60 / kAudioBlockSize;
+  const size_t num_samples = num_blocks * kAudioBlockSize;
+  float* rom = new float[num_samples];
+  float* decoded = new float[num_samples];
+  memset(rom, 0, num_samples * sizeof(float));
+  memset(decoded, 0, num_samples * sizeof(float));
+  
+  ExciterSamplePack pack;
+  if (!pack.Load("elements/samples")) {
+    printf("Could not load elements/samples\n");
+  }
+  
+  const ExciterModel models[] = {
+    EXCITER_MODEL_GRANULAR_SAMPLE_PLAYER,
+    EXCITER_MODEL_SAMPLE_PLAYER
+  };
+  const ExciterSampleBank* banks[] = {
+    SharedExciterSampleBank(),
+    pack.bank()
+  };
+  for (size_t i = 0; i < 2; ++i) {
+    clock_t start = clock();
+    RenderSamplePlayer(models[i], NULL, rom, num_blocks);
+    float rom_time = static_cast<float>(clock() - start) / CLOCKS_PER_SEC;
+    for (size_t j = 0; j < 2; ++j) {
+      if (!banks[j] || !banks[j]->num_samples()) {
+        continue;
+      }
+      start = clock();
+      RenderSamplePlayer(models[i], banks[j], decoded, num_blocks);
+      float bank_time = static_cast<float>(clock() - start) / CLOCKS_PER_SEC;
+      size_t num_errors = 0;
+      for (size_t k = 0; k < num_samples; ++k) {
+        num_errors += rom[k] != decoded[k] ? 1 : 0;
+      }
+      printf("Model %d, %s:\trom: %.3fs\tbank: %.3fs\t%d samples differ\n",
+          static_cast<int>(models[i]),
+          j == 0 ? "rom bank" : "elements/samples",
+          rom_time,
+          bank_time,
+          static_cast<int>(num_errors));
+    }
+  }
+  delete[] rom;
+  delete[] decoded;
+}
+
+void CompareResonatorBackends() {
+#ifdef RESONATOR_USE_SIMD
+  const size_t kDuration = 10;
+  const size_t resolutions[] = { 24, 52, kMaxModes };
+  
+  for (size_t k = 0; k < 3; ++k) {
+    Resonator scalar;
+    Resonator simd;
+    Resonator* resonators[2] = { &scalar, &simd };
+    double time[2] = { 0.0, 0.0 };
+    float max_error = 0.0f;
+    float max_value = 0.0f;
+    
+    for (size_t r = 0; r < 2; ++r) {
+      resonators[r]->Init();
+      resonators[r]->set_resolution(resolutions[k]);
+    }
+    
+    for (uint32_t i = 0; i < ::kSampleRate * kDuration;
+         i += kAudioBlockSize) {
+      float in[kAudioBlockSize];
+      float bow_strength[kAudioBlockSize];
+      float center[2][kAudioBlockSize];
+      float sides[2][kAudioBlockSize];
+      // Strikes, then bowing in the second half.
+      float t = static_cast<float>(i) / (::kSampleRate * kDuration);
+      for (size_t j = 0; j < kAudioBlockSize; ++j) {
+        in[j] = (i + j) % 12000 == 0 ? 1.0f : 0.0f;
+        bow_strength[j] = t > 0.5f ? 0.5f + 0.5f * t : 0.0f;
+      }
+      for (size_t r = 0; r < 2; ++r) {
+        Resonator* resonator = resonators[r];
+        resonator->set_frequency(SemitonesToRatio(-24.0f + 48.0f * t) * 0.01f);
+        resonator->set_geometry(t);
+        resonator->set_brightness(0.3f + 0.5f * t);
+        resonator->set_damping(0.6f);
+        resonator->set_position(0.2f + 0.6f * t);
+        resonator->set_modulation_frequency(0.5f / ::kSampleRate);
+        resonator->set_modulation_offset(0.1f);
+        clock_t start = clock();
+        if (r == 0) {
+          resonator->Process<RESONATOR_BACKEND_SCALAR>(
+              bow_strength, in, center[r], sides[r], kAudioBlockSize);
+        } else {
+          resonator->Process<RESONATOR_BACKEND_SIMD>(
+              bow_strength, in, center[r], sides[r], kAudioBlockSize);
+        }
+        time[r] += clock() - start;
+      }
+      for (size_t j = 0; j < kAudioBlockSize; ++j) {
+        max_error = std::max(max_error, fabsf(center[0][j] - center[1][j]));
+        max_error = std::max(max_error, fabsf(sides[0][j] - sides[1][j]));
+        max_value = std::max(max_value, fabsf(center[0][j]));
+      }
+    }
+    printf(
+        "%d modes:\tscalar: %.2fx realtime\tsimd: %.2fx realtime"
+        "\terror: %g (peak %g)\n",
+        static_cast<int>(resolutions[k]),
+        kDuration / (time[0] / CLOCKS_PER_SEC),
+        kDuration / (time[1] / CLOCKS_PER_SEC),
+        max_error,
+        max_value);
+  }
+#endif  // RESONATOR_USE_SIMD
+}
+
+// Real-time factor of a voice with the patch of BenchmarkResonatorModels(),
+// gated on and off every second.
+double BenchmarkVoice(const Patch& p, Voice* voice) {
+  const size_t kDuration = 10;
+  float silence[kMaxBlockSize];
+  float raw[kMaxBlockSize];
+  float center[kMaxBlockSize];
+  float sides[kMaxBlockSize];
+  std::fill(&silence[0], &silence[kMaxBlockSize], 0.0f);
+  
+  clock_t start = clock();
+  for (uint32_t i = 0; i < ::kSampleRate * kDuration; i += kMaxBlockSize) {
+    bool gate = (i % (::kSampleRate * 2)) < ::kSampleRate;
+    voice->Process(
+        p,
+        220.0f / ::kSampleRate,
+        1.0f,
+        gate,
+        silence,
+        silence,
+        raw,
+        center,
+        sides,
+        kMaxBlockSize);
+  }
+  double time = static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+  return kDuration / time;
+}
+
+void BenchmarkResonatorModels() {
+  Patch p;
+  p.exciter_envelope_shape = 0.95f;
+  p.exciter_bow_level = 0.5f;
+  p.exciter_bow_timbre = 0.6f;
+  p.exciter_blow_level = 0.3f;
+  p.exciter_blow_meta = 0.5f;
+  p.exciter_blow_timbre = 0.2f;
+  p.exciter_strike_level = 0.5f;
+  p.exciter_strike_meta = 0.5f;
+  p.exciter_strike_timbre = 0.5f;
+  p.exciter_signature = 0.0f;
+  p.resonator_geometry = 0.2f;
+  p.resonator_brightness = 0.9f;
+  p.resonator_damping = 0.3f;
+  p.resonator_position = 0.3f;
+  p.resonator_modulation_frequency = 0.5f / ::kSampleRate;
+  p.resonator_modulation_offset = 0.1f;
+  
+  // Only the modal model runs elements::Resonator, so it is the only one
+  // affected by the backend and the resolution.
+  const char* backend_names[] = { "scalar", "simd" };
+#ifdef RESONATOR_USE_SIMD
+  const size_t num_backends = 2;
+#else
+  const size_t num_backends = 1;
+#endif  // RESONATOR_USE_SIMD
+  const size_t resolutions[] = { 24, 52, kMaxModes };
+  for (size_t backend = 0; backend < num_backends; ++backend) {
+    for (size_t k = 0; k < 3; ++k) {
+      Voice voice;
+      voice.Init();
+      voice.set_resonator_model(RESONATOR_MODEL_MODAL);
+      voice.set_resonator_backend(static_cast<ResonatorBackend>(backend));
+      voice.set_resonator_resolution(resolutions[k]);
+      printf("modal, %s, %d modes:\t%.2fx realtime\n",
+          backend_names[backend],
+          static_cast<int>(resolutions[k]),
+          BenchmarkVoice(p, &voice));
+    }
+  }
+  
+  const ResonatorModel models[] = {
+    RESONATOR_MODEL_STRING,
+    RESONATOR_MODEL_STRINGS
+  };
+  const char* names[] = { "string", "strings" };
+  for (size_t model = 0; model < 2; ++model) {
+    Voice voice;
+    voice.Init();
+    voice.set_resonator_model(models[model]);
+    printf("%s:\t%.2fx realtime\n", names[model], BenchmarkVoice(p, &voice));
+  }
+}
 
 int main(void) {
   _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
@@ -498,4 +726,7 @@ int main(void) {
   // TestExciter();
   // TestResonator();
   // TestEasterEgg();
+  // CompareExciterSamplePlayers();
+  // CompareResonatorBackends();
+  // BenchmarkResonatorModels();
 }
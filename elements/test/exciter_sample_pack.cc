@@ -0,0 +1,173 @@
+// Copyright 2014 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Exciter sample banks read from .wav files.
+
+#include "elements/test/exciter_sample_pack.h"
+
+#include <pthread.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "stmlib/dsp/dsp.h"
+
+namespace elements {
+
+using namespace std;
+using namespace stmlib;
+
+static float rom_sample_bank_storage[kExciterSampleBankRomSize];
+static ExciterSampleBank rom_sample_bank;
+static pthread_once_t rom_sample_bank_once = PTHREAD_ONCE_INIT;
+
+static bool rom_sample_bank_ready = false;
+
+static void InitRomSampleBank() {
+  rom_sample_bank_ready = rom_sample_bank.Init(
+      rom_sample_bank_storage,
+      kExciterSampleBankRomSize);
+}
+
+const ExciterSampleBank* SharedExciterSampleBank() {
+  pthread_once(&rom_sample_bank_once, &InitRomSampleBank);
+  return rom_sample_bank_ready ? &rom_sample_bank : NULL;
+}
+
+static uint32_t ReadLittleEndian(const uint8_t* data, size_t size) {
+  uint32_t value = 0;
+  for (size_t i = 0; i < size; ++i) {
+    value |= static_cast<uint32_t>(data[i]) << (8 * i);
+  }
+  return value;
+}
+
+/* static */
+bool ExciterSamplePack::ReadWavFile(
+    const char* file_name,
+    vector<int16_t>* data) {
+  FILE* fp = fopen(file_name, "rb");
+  if (!fp) {
+    return false;
+  }
+  
+  uint8_t header[12];
+  if (fread(header, 1, 12, fp) != 12 ||
+      memcmp(&header[0], "RIFF", 4) || memcmp(&header[8], "WAVE", 4)) {
+    fclose(fp);
+    return false;
+  }
+  
+  size_t num_channels = 0;
+  bool success = false;
+  uint8_t chunk[8];
+  while (fread(chunk, 1, 8, fp) == 8) {
+    uint32_t chunk_size = ReadLittleEndian(&chunk[4], 4);
+    if (!memcmp(&chunk[0], "fmt ", 4)) {
+      uint8_t format[16];
+      if (chunk_size < 16 || fread(format, 1, 16, fp) != 16) {
+        break;
+      }
+      num_channels = ReadLittleEndian(&format[2], 2);
+      if (ReadLittleEndian(&format[0], 2) != 1 || !num_channels ||
+          ReadLittleEndian(&format[14], 2) != 16) {
+        break;
+      }
+      fseek(fp, chunk_size - 16 + (chunk_size & 1), SEEK_CUR);
+    } else if (!memcmp(&chunk[0], "data", 4)) {
+      if (!num_channels) {
+        break;
+      }
+      const size_t frame_size = 2 * num_channels;
+      vector<uint8_t> bytes(chunk_size + frame_size);
+      size_t num_frames = fread(
+          &bytes[0], frame_size, chunk_size / frame_size, fp);
+      // Like samples.py: the channels are summed, and the [-1, 1) range of
+      // the .wav file is mapped to [-32767, 32767).
+      for (size_t i = 0; i < num_frames; ++i) {
+        double sum = 0.0;
+        for (size_t j = 0; j < num_channels; ++j) {
+          int16_t x = static_cast<int16_t>(
+              ReadLittleEndian(&bytes[(i * num_channels + j) * 2], 2));
+          sum += static_cast<double>(x) / 32768.0;
+        }
+        data->push_back(Clip16(static_cast<int32_t>(
+            nearbyint(sum * 32767.0))));
+      }
+      success = num_frames != 0;
+      break;
+    } else {
+      fseek(fp, chunk_size + (chunk_size & 1), SEEK_CUR);
+    }
+  }
+  fclose(fp);
+  return success;
+}
+
+bool ExciterSamplePack::Load(const char* directory) {
+  char file_name[1024];
+  
+  sample_data_.clear();
+  boundaries_.assign(1, 0);
+  noise_sample_.clear();
+  
+  for (size_t i = 0; i < kMaxExciterSamples; ++i) {
+    snprintf(file_name, sizeof(file_name), "%s/hit_%02d.wav",
+        directory, static_cast<int>(i + 1));
+    if (!ReadWavFile(file_name, &sample_data_)) {
+      break;
+    }
+    const size_t sample_size = sample_data_.size() - boundaries_.back();
+    if (sample_size > kMaxExciterSampleSize) {
+      fprintf(stderr, "%s: %d frames, the limit is %d\n",
+          file_name,
+          static_cast<int>(sample_size),
+          static_cast<int>(kMaxExciterSampleSize));
+      return false;
+    }
+    // Interpolation tail.
+    sample_data_.push_back(sample_data_.back());
+    boundaries_.push_back(sample_data_.size());
+  }
+  
+  snprintf(file_name, sizeof(file_name), "%s/noise.wav", directory);
+  if (boundaries_.size() < 3 || !ReadWavFile(file_name, &noise_sample_)) {
+    return false;
+  }
+  
+  storage_.resize(sample_data_.size() + noise_sample_.size());
+  return bank_.Init(
+      &sample_data_[0],
+      &boundaries_[0],
+      boundaries_.size() - 1,
+      &noise_sample_[0],
+      noise_sample_.size(),
+      &storage_[0],
+      storage_.size());
+}
+
+}  // namespace elements
@@ -0,0 +1,77 @@
+// Copyright 2014 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Exciter sample banks read from .wav files. Host only - this is not built
+// into the firmware.
+
+#ifndef ELEMENTS_TEST_EXCITER_SAMPLE_PACK_H_
+#define ELEMENTS_TEST_EXCITER_SAMPLE_PACK_H_
+
+#include <vector>
+
+#include "stmlib/stmlib.h"
+
+#include "elements/dsp/exciter_sample_bank.h"
+
+namespace elements {
+
+// The ROM samples, decoded on the first call and shared by all the exciters
+// of the process. NULL if they could not be decoded.
+const ExciterSampleBank* SharedExciterSampleBank();
+
+// A sample pack laid out like elements/samples: hit_01.wav, hit_02.wav...
+// (up to kMaxExciterSamples) and noise.wav, converted to 16-bit like
+// elements/resources/samples.py does when building the ROM. Loading
+// elements/samples thus gives the same samples as the ROM, and any other
+// directory can be swapped in without rebuilding the resources.
+class ExciterSamplePack {
+ public:
+  ExciterSamplePack() { }
+  ~ExciterSamplePack() { }
+  
+  // Returns false if there is no hit_01.wav and hit_02.wav, if a file is not
+  // an uncompressed 16-bit .wav file, if a sample is longer than
+  // kMaxExciterSampleSize frames (reported on stderr), or if the noise sample
+  // is too short.
+  bool Load(const char* directory);
+  
+  inline const ExciterSampleBank* bank() const { return &bank_; }
+  
+ private:
+  static bool ReadWavFile(const char* file_name, std::vector<int16_t>* data);
+  
+  std::vector<int16_t> sample_data_;
+  std::vector<size_t> boundaries_;
+  std::vector<int16_t> noise_sample_;
+  std::vector<float> storage_;
+  ExciterSampleBank bank_;
+  
+  DISALLOW_COPY_AND_ASSIGN(ExciterSamplePack);
+};
+
+}  // namespace elements
+
+#endif  // ELEMENTS_TEST_EXCITER_SAMPLE_PACK_H_
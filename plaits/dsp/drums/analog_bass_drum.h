@@ -82,14 +82,15 @@ class AnalogBassDrum {
       float self_fm_amount,
       float* out,
       size_t size) {
-    const int kTriggerPulseDuration = 1.0e-3 * kSampleRate;
-    const int kFMPulseDuration = 6.0e-3 * kSampleRate;
-    const float kPulseDecayTime = 0.2e-3 * kSampleRate;
-    const float kPulseFilterTime = 0.1e-3 * kSampleRate;
-    const float kRetrigPulseDuration = 0.05f * kSampleRate;
+    const int kTriggerPulseDuration = 1.0e-3 * SampleRate();
+    const int kFMPulseDuration = 6.0e-3 * SampleRate();
+    const float kPulseDecayTime = 0.2e-3 * SampleRate();
+    const float kPulseFilterTime = 0.1e-3 * SampleRate();
+    const float kRetrigPulseDuration = 0.05f * SampleRate();
     
     const float scale = 0.001f / f0;
-    const float q = 1500.0f * stmlib::SemitonesToRatio(decay * 80.0f);
+    const float q = 1500.0f / SampleRateRatio() * \
+        stmlib::SemitonesToRatio(decay * 80.0f);
     const float tone_f = std::min(
         4.0f * f0 * stmlib::SemitonesToRatio(tone * 108.0f),
         1.0f);
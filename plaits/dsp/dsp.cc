@@ -0,0 +1,51 @@
+// Copyright 2016 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Utility DSP routines.
+
+#include "plaits/dsp/dsp.h"
+
+namespace plaits {
+
+#ifdef TEST
+
+SampleRateSettings sample_rate_settings = {
+  kSampleRate,
+  kCorrectedSampleRate,
+  (440.0f / 8.0f) / kCorrectedSampleRate,
+  1.0f
+};
+
+void SetSampleRate(float sample_rate) {
+  sample_rate_settings.sample_rate = sample_rate;
+  sample_rate_settings.corrected_sample_rate = sample_rate;
+  sample_rate_settings.a0 = (440.0f / 8.0f) / sample_rate;
+  sample_rate_settings.ratio = kSampleRate / sample_rate;
+}
+
+#endif  // TEST
+
+}  // namespace plaits
@@ -45,7 +45,48 @@ static const float kSampleRate = 48000.0f;
 // That's only 4.6 cts of error, but we care!
 
 static const float kCorrectedSampleRate = 47872.34f;
-const float a0 = (440.0f / 8.0f) / kCorrectedSampleRate;
+
+#ifdef TEST
+
+// Host builds (tests, renderers, plug-ins) can render natively at the rate of
+// the host. SetSampleRate() must be called before the voices are initialized.
+// Until then, the rates of the module are used, including the correction of
+// its clock error; a host running at an exact rate gets no correction.
+//
+// The rate is a process-wide global, not a setting of each Voice: all the
+// voices of a process run at the same rate, and it must not be changed while
+// any of them is rendering. A host that needs voices at different rates must
+// render them in separate processes.
+struct SampleRateSettings {
+  float sample_rate;
+  float corrected_sample_rate;
+  float a0;
+  float ratio;
+};
+
+extern SampleRateSettings sample_rate_settings;
+
+void SetSampleRate(float sample_rate);
+
+inline float SampleRate() { return sample_rate_settings.sample_rate; }
+inline float CorrectedSampleRate() {
+  return sample_rate_settings.corrected_sample_rate;
+}
+inline float A0() { return sample_rate_settings.a0; }
+inline float SampleRateRatio() { return sample_rate_settings.ratio; }
+
+#else
+
+inline float SampleRate() { return kSampleRate; }
+inline float CorrectedSampleRate() { return kCorrectedSampleRate; }
+inline float A0() { return (440.0f / 8.0f) / kCorrectedSampleRate; }
+inline float SampleRateRatio() { return 1.0f; }
+
+#endif  // TEST
+
+// SampleRateRatio() is kSampleRate / SampleRate(). It rescales normalized
+// frequencies which are not derived from the sample rate, and were tuned for
+// the module.
 
 const size_t kMaxBlockSize = 24;
 const size_t kBlockSize = 12;
@@ -37,10 +37,22 @@ namespace plaits {
 using namespace std;
 using namespace stmlib;
 
-#ifdef JON_CHORDS
+const float chords[kChordNumChords][kChordNumNotes] = {
+  { 0.00f, 0.01f, 11.99f, 12.00f },  // OCT
+  { 0.00f, 7.01f,  7.00f, 12.00f },  // 5
+  { 0.00f, 5.00f,  7.00f, 12.00f },  // sus4
+  { 0.00f, 3.00f,  7.00f, 12.00f },  // m
+  { 0.00f, 3.00f,  7.00f, 10.00f },  // m7
+  { 0.00f, 3.00f, 10.00f, 14.00f },  // m9
+  { 0.00f, 3.00f, 10.00f, 17.00f },  // m11
+  { 0.00f, 2.00f,  9.00f, 16.00f },  // 69
+  { 0.00f, 4.00f, 11.00f, 14.00f },  // M9
+  { 0.00f, 4.00f,  7.00f, 11.00f },  // M7
+  { 0.00f, 4.00f,  7.00f, 12.00f },  // M
+};
 
 // Alternative chord table by Jon Butler jonbutler88@gmail.com
-const float chords[kChordNumChords][kChordNumNotes] = {
+const float extended_chords[kChordNumExtendedChords][kChordNumNotes] = {
   // Fixed Intervals
   { 0.00f, 0.01f, 11.99f, 12.00f },  // Octave
   { 0.00f, 7.01f,  7.00f, 12.00f },  // Fifth
@@ -64,42 +76,55 @@ const float chords[kChordNumChords][kChordNumNotes] = {
   { 0.00f, 3.00f,  6.00f,  9.00f },  // Fully Diminished
 };
 
-#else
-
-const float chords[kChordNumChords][kChordNumNotes] = {
-  { 0.00f, 0.01f, 11.99f, 12.00f },  // OCT
-  { 0.00f, 7.01f,  7.00f, 12.00f },  // 5
-  { 0.00f, 5.00f,  7.00f, 12.00f },  // sus4
-  { 0.00f, 3.00f,  7.00f, 12.00f },  // m
-  { 0.00f, 3.00f,  7.00f, 10.00f },  // m7
-  { 0.00f, 3.00f, 10.00f, 14.00f },  // m9
-  { 0.00f, 3.00f, 10.00f, 17.00f },  // m11
-  { 0.00f, 2.00f,  9.00f, 16.00f },  // 69
-  { 0.00f, 4.00f, 11.00f, 14.00f },  // M9
-  { 0.00f, 4.00f,  7.00f, 11.00f },  // M7
-  { 0.00f, 4.00f,  7.00f, 12.00f },  // M
-};
-
-#endif  // JON_CHORDS
-
 void ChordEngine::Init(BufferAllocator* allocator) {
+#ifdef CHORD_ENGINE_USE_SIMD
+  divide_down_bank_.Init();
+  wavetable_bank_.Init();
+#else
   for (int i = 0; i < kChordNumVoices; ++i) {
     divide_down_voice_[i].Init();
     wavetable_voice_[i].Init();
   }
+#endif  // CHORD_ENGINE_USE_SIMD
   chord_index_quantizer_.Init();
   morph_lp_ = 0.0f;
   timbre_lp_ = 0.0f;
   
-  ratios_ = allocator->Allocate<float>(kChordNumChords * kChordNumNotes);
+#ifdef JON_CHORDS
+  set_chord_table(CHORD_TABLE_EXTENDED);
+#else
+  set_chord_table(CHORD_TABLE_DEFAULT);
+#endif  // JON_CHORDS
+  num_layers_ = 1;
+  
+  ratios_ = allocator->Allocate<float>(kChordMaxNumChords * kChordNumNotes);
+  // The ratios are not computed yet.
+  ratios_chord_table_ = CHORD_TABLE_LAST;
 }
 
 void ChordEngine::Reset() {
-  for (int i = 0; i < kChordNumChords; ++i) {
+  ComputeRatios();
+}
+
+void ChordEngine::set_chord_table(ChordTable chord_table) {
+  chord_table_ = chord_table;
+  num_chords_ = chord_table == CHORD_TABLE_EXTENDED
+      ? kChordNumExtendedChords
+      : kChordNumChords;
+}
+
+void ChordEngine::ComputeRatios() {
+  // The ratios live in the RAM shared by all engines, so they are only
+  // computed when this engine is active.
+  const float (*table)[kChordNumNotes] = chord_table_ == CHORD_TABLE_EXTENDED
+      ? extended_chords
+      : chords;
+  for (int i = 0; i < num_chords_; ++i) {
     for (int j = 0; j < kChordNumNotes; ++j) {
-      ratios_[i * kChordNumNotes + j] = SemitonesToRatio(chords[i][j]);
+      ratios_[i * kChordNumNotes + j] = SemitonesToRatio(table[i][j]);
     }
   }
+  ratios_chord_table_ = chord_table_;
 }
 
 const float fade_point[kChordNumVoices] = {
@@ -205,11 +230,15 @@ void ChordEngine::Render(
     float* aux,
     size_t size,
     bool* already_enveloped) {
+  if (ratios_chord_table_ != chord_table_) {
+    ComputeRatios();
+  }
+  
   ONE_POLE(morph_lp_, parameters.morph, 0.1f);
   ONE_POLE(timbre_lp_, parameters.timbre, 0.1f);
 
   const int chord_index = chord_index_quantizer_.Process(
-      parameters.harmonics * 1.02f, kChordNumChords);
+      parameters.harmonics * 1.02f, num_chords_);
 
   float harmonics[kChordNumHarmonics * 2 + 2];
   float note_amplitudes[kChordNumVoices];
@@ -231,6 +260,82 @@ void ChordEngine::Render(
   const float f0 = NoteToFrequency(parameters.note) * 0.998f;
   const float waveform = max((morph_lp_ - 0.535f) * 2.15f, 0.0f);
   
+#ifdef CHORD_ENGINE_USE_SIMD
+  // Layer l is a copy of the chord, detuned by layer_detune[l] and mixed into
+  // oscillators [l * kChordNumVoices, (l + 1) * kChordNumVoices).
+  const float layer_detune[kChordMaxNumLayers] = { 1.0f, 1.0046f, 0.9954f };
+  const float layer_gain[kChordMaxNumLayers] = { 1.0f, 0.7071f, 0.5774f };
+  const float gain = layer_gain[num_layers_ - 1];
+  const int num_oscillators = num_layers_ * kChordNumVoices;
+  
+  float wavetable_f0[kChordMaxNumOscillators];
+  float wavetable_amplitudes[kChordMaxNumOscillators];
+  float divide_down_f0[kChordMaxNumOscillators];
+  float divide_down_amplitudes[kChordMaxNumOscillators];
+  float route[kChordMaxNumOscillators];
+  fill(&wavetable_f0[0], &wavetable_f0[kChordMaxNumOscillators], f0);
+  fill(&wavetable_amplitudes[0],
+       &wavetable_amplitudes[kChordMaxNumOscillators],
+       0.0f);
+  fill(&divide_down_f0[0], &divide_down_f0[kChordMaxNumOscillators], f0);
+  fill(&divide_down_amplitudes[0],
+       &divide_down_amplitudes[kChordMaxNumOscillators],
+       0.0f);
+  fill(&route[0], &route[kChordMaxNumOscillators], 0.0f);
+  
+  bool render_wavetable = false;
+  bool render_divide_down = false;
+  for (int note = 0; note < kChordNumVoices; ++note) {
+    float wavetable_amount = 50.0f * (morph_lp_ - fade_point[note]);
+    CONSTRAIN(wavetable_amount, 0.0f, 1.0f);
+
+    const float divide_down_amount = 1.0f - wavetable_amount;
+    const float destination = (1 << note) & aux_note_mask ? 1.0f : 0.0f;
+    
+    for (int layer = 0; layer < num_layers_; ++layer) {
+      const int i = layer * kChordNumVoices + note;
+      const float note_f0 = f0 * ratios[note] * layer_detune[layer];
+      float divide_down_gain = 4.0f - note_f0 * 32.0f;
+      CONSTRAIN(divide_down_gain, 0.0f, 1.0f);
+      divide_down_gain *= divide_down_amount;
+      
+      wavetable_f0[i] = note_f0 * 1.004f;
+      wavetable_amplitudes[i] = note_amplitudes[note] * wavetable_amount * gain;
+      divide_down_f0[i] = note_f0;
+      divide_down_amplitudes[i] = note_amplitudes[note] * \
+          divide_down_gain * gain;
+      route[i] = destination;
+      
+      render_wavetable = render_wavetable || wavetable_amplitudes[i];
+      render_divide_down = render_divide_down || divide_down_amplitudes[i];
+    }
+  }
+  
+  if (render_wavetable) {
+    wavetable_bank_.Render(
+        num_oscillators,
+        wavetable_f0,
+        wavetable_amplitudes,
+        waveform,
+        wavetable,
+        route,
+        out,
+        aux,
+        size);
+  }
+  
+  if (render_divide_down) {
+    divide_down_bank_.Render(
+        num_oscillators,
+        divide_down_f0,
+        harmonics,
+        divide_down_amplitudes,
+        route,
+        out,
+        aux,
+        size);
+  }
+#else
   for (int note = 0; note < kChordNumVoices; ++note) {
     float wavetable_amount = 50.0f * (morph_lp_ - fade_point[note]);
     CONSTRAIN(wavetable_amount, 0.0f, 1.0f);
@@ -262,6 +367,7 @@ void ChordEngine::Render(
           size);
     }
   }
+#endif  // CHORD_ENGINE_USE_SIMD
   
   for (size_t i = 0; i < size; ++i) {
     out[i] += aux[i];
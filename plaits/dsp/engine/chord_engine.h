@@ -35,19 +35,43 @@
 #include "plaits/dsp/oscillator/string_synth_oscillator.h"
 #include "plaits/dsp/oscillator/wavetable_oscillator.h"
 
+#if defined(__SSE2__) || defined(__ARM_NEON__)
+#define CHORD_ENGINE_USE_SIMD
+#endif  // __SSE2__ || __ARM_NEON__
+
+#ifdef CHORD_ENGINE_USE_SIMD
+#include "plaits/dsp/oscillator/string_synth_oscillator_bank.h"
+#include "plaits/dsp/oscillator/wavetable_oscillator_bank.h"
+#endif  // CHORD_ENGINE_USE_SIMD
+
 namespace plaits {
 
 const int kChordNumNotes = 4;
 const int kChordNumVoices = 5;
 const int kChordNumHarmonics = 3;
 
+const int kChordNumChords = 11;
+const int kChordNumExtendedChords = 17;
+const int kChordMaxNumChords = kChordNumExtendedChords;
+
 // #define JON_CHORDS
 
-#ifdef JON_CHORDS
-const int kChordNumChords = 17;
+enum ChordTable {
+  CHORD_TABLE_DEFAULT,
+  // Alternative chord table by Jon Butler, with more colour chords.
+  CHORD_TABLE_EXTENDED,
+  CHORD_TABLE_LAST
+};
+
+// With SIMD, all the voices are rendered in a single pass, and the chord can
+// be doubled by up to 2 detuned layers, for 15 voices.
+#ifdef CHORD_ENGINE_USE_SIMD
+const int kChordMaxNumLayers = 3;
 #else
-const int kChordNumChords = 11;
-#endif  // JON_CHORDS
+const int kChordMaxNumLayers = 1;
+#endif  // CHORD_ENGINE_USE_SIMD
+
+const int kChordMaxNumOscillators = 16;
 
 class ChordEngine : public Engine {
  public:
@@ -61,8 +85,20 @@ class ChordEngine : public Engine {
       float* aux,
       size_t size,
       bool* already_enveloped);
+  
+  void set_chord_table(ChordTable chord_table);
+  
+  inline void set_num_layers(int num_layers) {
+    CONSTRAIN(num_layers, 1, kChordMaxNumLayers);
+    num_layers_ = num_layers;
+  }
+  
+  inline ChordTable chord_table() const { return chord_table_; }
+  inline int num_chords() const { return num_chords_; }
+  inline int num_layers() const { return num_layers_; }
 
  private:
+  void ComputeRatios();
   void ComputeRegistration(float registration, float* amplitudes);
   int ComputeChordInversion(
       int chord_index,
@@ -70,10 +106,20 @@ class ChordEngine : public Engine {
       float* ratios,
       float* amplitudes);
   
+#ifdef CHORD_ENGINE_USE_SIMD
+  StringSynthOscillatorBank<kChordMaxNumOscillators> divide_down_bank_;
+  WavetableOscillatorBank<256, 15, kChordMaxNumOscillators> wavetable_bank_;
+#else
   StringSynthOscillator divide_down_voice_[kChordNumVoices];
   WavetableOscillator<256, 15> wavetable_voice_[kChordNumVoices];
+#endif  // CHORD_ENGINE_USE_SIMD
   stmlib::HysteresisQuantizer chord_index_quantizer_;
   
+  ChordTable chord_table_;
+  ChordTable ratios_chord_table_;
+  int num_chords_;
+  int num_layers_;
+  
   float morph_lp_;
   float timbre_lp_;
   float previous_root_normalization_;
@@ -39,7 +39,7 @@ namespace plaits {
 inline float NoteToFrequency(float midi_note) {
   midi_note -= 9.0f;
   CONSTRAIN(midi_note, -128.0f, 127.0f);
-  return a0 * 0.25f * stmlib::SemitonesToRatio(midi_note);
+  return A0() * 0.25f * stmlib::SemitonesToRatio(midi_note);
 }
 
 enum TriggerState {
@@ -41,11 +41,14 @@ void FMEngine::Init(BufferAllocator* allocator) {
   modulator_phase_ = 0;
   sub_phase_ = 0;
 
-  previous_carrier_frequency_ = a0;
-  previous_modulator_frequency_ = a0;
+  previous_carrier_frequency_ = A0();
+  previous_modulator_frequency_ = A0();
   previous_amount_ = 0.0f;
   previous_feedback_ = 0.0f;
   previous_sample_ = 0.0f;
+  
+  sub_fir_ = 0.0f;
+  carrier_fir_ = 0.0f;
 }
 
 void FMEngine::Reset() {
@@ -58,6 +58,12 @@ class SpeechEngine : public Engine {
   inline void set_speed(float speed) {
     speed_ = speed;
   }
+  
+  // Reads the LPC words from a cache rather than decoding them from ROM. The
+  // cache is not owned, and can be shared by several engines.
+  inline void set_word_bank_cache(const LPCSpeechSynthWordBankCache* cache) {
+    lpc_speech_synth_word_bank_.set_cache(cache);
+  }
 
  private:
   stmlib::HysteresisQuantizer word_bank_quantizer_;
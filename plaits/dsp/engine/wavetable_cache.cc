@@ -0,0 +1,107 @@
+// Copyright 2016 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+//
+// -----------------------------------------------------------------------------
+//
+// Pre-computed, band-limited mipmaps of the wave terrain used by
+// WavetableEngine.
+
+#include "plaits/dsp/engine/wavetable_cache.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "plaits/resources.h"
+
+namespace plaits {
+
+using namespace std;
+
+// Length of one cycle of the integrated waves in ROM.
+const size_t kRomTableSize = 256;
+const size_t kRomNumHarmonics = kRomTableSize / 2 - 1;
+
+void WavetableCache::Init(float* storage) {
+  double sine[kWavetableCacheMaxTableSize];
+  for (size_t i = 0; i < kWavetableCacheMaxTableSize; ++i) {
+    sine[i] = sin(2.0 * M_PI * i / kWavetableCacheMaxTableSize);
+  }
+  const size_t mask = kWavetableCacheMaxTableSize - 1;
+  const size_t quarter = kWavetableCacheMaxTableSize / 4;
+  
+  float* data[kWavetableCacheNumLevels];
+  for (size_t level = 0; level < kWavetableCacheNumLevels; ++level) {
+    data[level] = storage;
+    level_data_[level] = storage;
+    storage += kWavetableCacheNumWaves * stride(level);
+  }
+  
+  for (size_t wave = 0; wave < kWavetableCacheNumWaves; ++wave) {
+    // The engine reads sample n of a cycle from index n + 1.
+    const int16_t* integrated = wav_integrated_waves +
+        wave * (kRomTableSize + 4) + 1;
+    
+    // Fourier series of the derivative of the integrated wave, scaled the
+    // same way as WavetableEngine scales the output of its differentiator.
+    double cosine_amplitude[kRomNumHarmonics + 1];
+    double sine_amplitude[kRomNumHarmonics + 1];
+    const double scale = 2.0 / kRomTableSize / 131072.0;
+    for (size_t k = 1; k <= kRomNumHarmonics; ++k) {
+      double re = 0.0;
+      double im = 0.0;
+      const size_t step = k * (kWavetableCacheMaxTableSize / kRomTableSize);
+      for (size_t n = 0; n < kRomTableSize; ++n) {
+        const size_t phase = (n * step) & mask;
+        re += integrated[n] * sine[(phase + quarter) & mask];
+        im -= integrated[n] * sine[phase];
+      }
+      const double derivative_scale = 2.0 * M_PI * k * scale;
+      cosine_amplitude[k] = -im * derivative_scale;
+      sine_amplitude[k] = -re * derivative_scale;
+    }
+    
+    for (size_t level = 0; level < kWavetableCacheNumLevels; ++level) {
+      const size_t size = table_size(level);
+      const size_t num_harmonics = min(kRomNumHarmonics, size_t(128) >> level);
+      float* t = data[level] + wave * stride(level);
+      for (size_t n = 0; n < size; ++n) {
+        const size_t step = n * (kWavetableCacheMaxTableSize / size);
+        double s = 0.0;
+        for (size_t k = 1; k <= num_harmonics; ++k) {
+          const size_t phase = (k * step) & mask;
+          s += cosine_amplitude[k] * sine[(phase + quarter) & mask];
+          s += sine_amplitude[k] * sine[phase];
+        }
+        t[n + 1] = static_cast<float>(s);
+      }
+      t[0] = t[size];
+      t[size + 1] = t[1];
+      t[size + 2] = t[2];
+      t[size + 3] = t[3];
+    }
+  }
+}
+
+}  // namespace plaits
@@ -0,0 +1,111 @@
+// Copyright 2016 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+//
+// -----------------------------------------------------------------------------
+//
+// Pre-computed, band-limited mipmaps of the wave terrain used by
+// WavetableEngine.
+//
+// The ROM stores the integral of each wave, which the engine interpolates and
+// differentiates sample by sample. The cache stores the derivative itself,
+// computed once from the spectrum of each wave, with one level per octave:
+// level n keeps at most 128 >> n harmonics, so that the highest harmonic of
+// the level selected for a given frequency is below Nyquist. The lowest
+// levels are oversampled (512 samples per cycle for level 0), and the highest
+// levels are decimated, so that each table has at least 4 samples per cycle
+// of its highest harmonic.
+//
+// The cache is immutable once initialized, and can be shared by any number of
+// voices rendered from any number of threads. It takes about 860kB, so this
+// is for hosts only.
+
+#ifndef PLAITS_DSP_ENGINE_WAVETABLE_CACHE_H_
+#define PLAITS_DSP_ENGINE_WAVETABLE_CACHE_H_
+
+#include "stmlib/stmlib.h"
+
+namespace plaits {
+
+const size_t kWavetableCacheNumWaves = 192;
+const size_t kWavetableCacheNumLevels = 8;
+const size_t kWavetableCacheMaxTableSize = 512;
+const size_t kWavetableCacheMinTableSize = 32;
+
+// Guard samples around each table, for Hermite interpolation.
+const size_t kWavetableCacheGuard = 4;
+
+// Number of floats to provide to WavetableCache::Init().
+const size_t kWavetableCacheSize = kWavetableCacheNumWaves * (
+    512 + 256 + 128 + 64 + 32 + 32 + 32 + 32 +
+    kWavetableCacheNumLevels * kWavetableCacheGuard);
+
+class WavetableCache {
+ public:
+  WavetableCache() { }
+  ~WavetableCache() { }
+  
+  // Computes all the levels into storage, which must hold
+  // kWavetableCacheSize floats. This is slow: do it once at startup.
+  void Init(float* storage);
+  
+  // Selects the level for a given frequency (in cycles per sample).
+  static inline size_t level(float f0) {
+    size_t level = 0;
+    float highest_harmonic = f0 * 128.0f;
+    while (highest_harmonic > 0.5f && level < kWavetableCacheNumLevels - 1) {
+      highest_harmonic *= 0.5f;
+      ++level;
+    }
+    return level;
+  }
+  
+  static inline size_t table_size(size_t level) {
+    size_t size = kWavetableCacheMaxTableSize >> level;
+    return size < kWavetableCacheMinTableSize
+        ? kWavetableCacheMinTableSize
+        : size;
+  }
+  
+  static inline size_t stride(size_t level) {
+    return table_size(level) + kWavetableCacheGuard;
+  }
+  
+  // Returns the first wave of a level. Waves are stride(level) floats apart,
+  // and each wave can be read with InterpolateWaveHermite(), using an index
+  // in [0, table_size(level)). The samples are scaled so that the engine
+  // output is the same as with the integrated ROM waves.
+  inline const float* level_data(size_t level) const {
+    return level_data_[level];
+  }
+
+ private:
+  const float* level_data_[kWavetableCacheNumLevels];
+  
+  DISALLOW_COPY_AND_ASSIGN(WavetableCache);
+};
+
+}  // namespace plaits
+
+#endif  // PLAITS_DSP_ENGINE_WAVETABLE_CACHE_H_
@@ -51,9 +51,10 @@ void WavetableEngine::Init(BufferAllocator* allocator) {
   previous_x_ = 0.0f;
   previous_y_ = 0.0f;
   previous_z_ = 0.0f;
-  previous_f0_ = a0;
+  previous_f0_ = A0();
 
   diff_out_.Init();
+  cache_ = NULL;
 }
 
 void WavetableEngine::Reset() {
@@ -71,7 +72,10 @@ inline float Clamp(float x, float amount) {
 const size_t table_size = 256;
 const float table_size_f = float(table_size);
 
+template<typename T>
 inline float ReadWave(
+    const T* waves,
+    size_t stride,
     int x,
     int y,
     int z,
@@ -80,11 +84,68 @@ inline float ReadWave(
     float phase_fractional) {
   int wave = ((x + y * 8 + z * 64) * randomize) % 192;
   return InterpolateWaveHermite(
-      wav_integrated_waves + wave * (table_size + 4),
+      waves + wave * stride,
       phase_integral,
       phase_fractional);
 }
 
+template<typename T>
+inline float ReadTerrain(
+    const T* waves,
+    size_t stride,
+    int x_integral,
+    float x_fractional,
+    int y_integral,
+    float y_fractional,
+    int z_integral,
+    float z_fractional,
+    int p_integral,
+    float p_fractional) {
+  int x0 = x_integral;
+  int x1 = x_integral + 1;
+  int y0 = y_integral;
+  int y1 = y_integral + 1;
+  int z0 = z_integral;
+  int z1 = z_integral + 1;
+  
+  if (z0 >= 4) {
+    z0 = 7 - z0;
+  }
+  if (z1 >= 4) {
+    z1 = 7 - z1;
+  }
+  
+  int r0 = z0 == 3 ? 101 : 1;
+  int r1 = z1 == 3 ? 101 : 1;
+  
+  const T* w = waves;
+  const size_t s = stride;
+  const int p = p_integral;
+  const float f = p_fractional;
+
+  float x0y0z0 = ReadWave(w, s, x0, y0, z0, r0, p, f);
+  float x1y0z0 = ReadWave(w, s, x1, y0, z0, r0, p, f);
+  float xy0z0 = x0y0z0 + (x1y0z0 - x0y0z0) * x_fractional;
+
+  float x0y1z0 = ReadWave(w, s, x0, y1, z0, r0, p, f);
+  float x1y1z0 = ReadWave(w, s, x1, y1, z0, r0, p, f);
+  float xy1z0 = x0y1z0 + (x1y1z0 - x0y1z0) * x_fractional;
+
+  float xyz0 = xy0z0 + (xy1z0 - xy0z0) * y_fractional;
+
+  float x0y0z1 = ReadWave(w, s, x0, y0, z1, r1, p, f);
+  float x1y0z1 = ReadWave(w, s, x1, y0, z1, r1, p, f);
+  float xy0z1 = x0y0z1 + (x1y0z1 - x0y0z1) * x_fractional;
+
+  float x0y1z1 = ReadWave(w, s, x0, y1, z1, r1, p, f);
+  float x1y1z1 = ReadWave(w, s, x1, y1, z1, r1, p, f);
+  float xy1z1 = x0y1z1 + (x1y1z1 - x0y1z1) * x_fractional;
+  
+  float xyz1 = xy0z1 + (xy1z1 - xy0z1) * y_fractional;
+
+  return xyz0 + (xyz1 - xyz0) * z_fractional;
+}
+
 void WavetableEngine::Render(
     const EngineParameters& parameters,
     float* out,
@@ -120,14 +181,18 @@ void WavetableEngine::Render(
   ParameterInterpolator z_modulation(
       &previous_z_, static_cast<float>(z_integral) + z_fractional, size);
 
+  // With the cache, the mipmap level is selected for the highest frequency
+  // reached during the block.
+  const size_t level = WavetableCache::level(max(previous_f0_, f0));
+  const float* level_data = cache_ ? cache_->level_data(level) : NULL;
+  const size_t level_stride = WavetableCache::stride(level);
+  const float level_size_f = float(WavetableCache::table_size(level));
+
   ParameterInterpolator f0_modulation(&previous_f0_, f0, size);
   
   while (size--) {
     const float f0 = f0_modulation.Next();
     
-    const float gain = (1.0f / (f0 * 131072.0f)) * (0.95f - f0);
-    const float cutoff = min(table_size_f * f0, 1.0f);
-    
     ONE_POLE(x_lp_, x_modulation.Next(), lp_coefficient);
     ONE_POLE(y_lp_, y_modulation.Next(), lp_coefficient);
     ONE_POLE(z_lp_, z_modulation.Next(), lp_coefficient);
@@ -145,52 +210,32 @@ void WavetableEngine::Render(
       phase_ -= 1.0f;
     }
     
-    const float p = phase_ * table_size_f;
-    MAKE_INTEGRAL_FRACTIONAL(p);
-    
-    {
-      int x0 = x_integral;
-      int x1 = x_integral + 1;
-      int y0 = y_integral;
-      int y1 = y_integral + 1;
-      int z0 = z_integral;
-      int z1 = z_integral + 1;
-      
-      if (z0 >= 4) {
-        z0 = 7 - z0;
-      }
-      if (z1 >= 4) {
-        z1 = 7 - z1;
-      }
-      
-      int r0 = z0 == 3 ? 101 : 1;
-      int r1 = z1 == 3 ? 101 : 1;
-
-      float x0y0z0 = ReadWave(x0, y0, z0, r0, p_integral, p_fractional);
-      float x1y0z0 = ReadWave(x1, y0, z0, r0, p_integral, p_fractional);
-      float xy0z0 = x0y0z0 + (x1y0z0 - x0y0z0) * x_fractional;
-
-      float x0y1z0 = ReadWave(x0, y1, z0, r0, p_integral, p_fractional); 
-      float x1y1z0 = ReadWave(x1, y1, z0, r0, p_integral, p_fractional);
-      float xy1z0 = x0y1z0 + (x1y1z0 - x0y1z0) * x_fractional;
-
-      float xyz0 = xy0z0 + (xy1z0 - xy0z0) * y_fractional;
-
-      float x0y0z1 = ReadWave(x0, y0, z1, r1, p_integral, p_fractional);
-      float x1y0z1 = ReadWave(x1, y0, z1, r1, p_integral, p_fractional);
-      float xy0z1 = x0y0z1 + (x1y0z1 - x0y0z1) * x_fractional;
-
-      float x0y1z1 = ReadWave(x0, y1, z1, r1, p_integral, p_fractional);
-      float x1y1z1 = ReadWave(x1, y1, z1, r1, p_integral, p_fractional);
-      float xy1z1 = x0y1z1 + (x1y1z1 - x0y1z1) * x_fractional;
+    float mix;
+    if (level_data) {
+      const float p = phase_ * level_size_f;
+      MAKE_INTEGRAL_FRACTIONAL(p);
+      mix = ReadTerrain(
+          level_data, level_stride,
+          x_integral, x_fractional,
+          y_integral, y_fractional,
+          z_integral, z_fractional,
+          p_integral, p_fractional) * (0.95f - f0);
+    } else {
+      const float gain = (1.0f / (f0 * 131072.0f)) * (0.95f - f0);
+      const float cutoff = min(table_size_f * f0, 1.0f);
       
-      float xyz1 = xy0z1 + (xy1z1 - xy0z1) * y_fractional;
-
-      float mix = xyz0 + (xyz1 - xyz0) * z_fractional;
+      const float p = phase_ * table_size_f;
+      MAKE_INTEGRAL_FRACTIONAL(p);
+      mix = ReadTerrain(
+          wav_integrated_waves, table_size + 4,
+          x_integral, x_fractional,
+          y_integral, y_fractional,
+          z_integral, z_fractional,
+          p_integral, p_fractional);
       mix = diff_out_.Process(cutoff, mix) * gain;
-      *out++ = mix;
-      *aux++ = static_cast<float>(static_cast<int>(mix * 32.0f)) / 32.0f;
     }
+    *out++ = mix;
+    *aux++ = static_cast<float>(static_cast<int>(mix * 32.0f)) / 32.0f;
   }
 }
 
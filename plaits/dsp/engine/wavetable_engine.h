@@ -32,6 +32,7 @@
 #include "stmlib/dsp/hysteresis_quantizer.h"
 
 #include "plaits/dsp/engine/engine.h"
+#include "plaits/dsp/engine/wavetable_cache.h"
 #include "plaits/dsp/oscillator/wavetable_oscillator.h"
 
 namespace plaits {
@@ -49,6 +50,12 @@ class WavetableEngine : public Engine {
       size_t size,
       bool* already_enveloped);
   
+  // Renders from pre-computed mipmaps rather than from the integrated waves
+  // in ROM. The cache is not owned, and can be shared by several engines.
+  inline void set_cache(const WavetableCache* cache) {
+    cache_ = cache;
+  }
+  
  private:
   float phase_;
   
@@ -67,6 +74,8 @@ class WavetableEngine : public Engine {
   
   Differentiator diff_out_;
   
+  const WavetableCache* cache_;
+  
   DISALLOW_COPY_AND_ASSIGN(WavetableEngine);
 };
 
@@ -0,0 +1,277 @@
+// Copyright 2016 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Bank of oscillators rendered in lockstep - same waveforms as Oscillator, but
+// the state is stored as arrays of 4-lane vectors and the polyBLEP corrections
+// are computed without branches. num_oscillators must be a multiple of 4; a
+// bank of 8 runs two SSE/NEON vectors side by side.
+//
+// Audio-rate FM (and through-zero FM) is not supported.
+
+#ifndef PLAITS_DSP_OSCILLATOR_OSCILLATOR_BANK_H_
+#define PLAITS_DSP_OSCILLATOR_OSCILLATOR_BANK_H_
+
+#include "stmlib/dsp/dsp.h"
+
+#include "plaits/dsp/oscillator/oscillator.h"
+#include "plaits/dsp/simd.h"
+
+namespace plaits {
+
+template<size_t num_oscillators>
+class OscillatorBank {
+ public:
+  OscillatorBank() { }
+  ~OscillatorBank() { }
+  
+  enum {
+    num_vectors = num_oscillators / kSimdWidth
+  };
+  
+  void Init() {
+    for (size_t i = 0; i < num_vectors; ++i) {
+      phase_[i] = Splat(0.5f);
+      next_sample_[i] = Float4();
+      lp_state_[i] = Splat(1.0f);
+      hp_state_[i] = Float4();
+      high_[i] = Splat(1.0f);
+      
+      frequency_[i] = Splat(0.001f);
+      pw_[i] = Splat(0.5f);
+    }
+  }
+  
+  // Writes the oscillators' outputs interleaved: out[n * num_oscillators + i].
+  template<OscillatorShape shape>
+  void Render(
+      const float* frequency,
+      const float* pw,
+      float* out,
+      size_t size) {
+    Prepare<shape>(frequency, pw, size);
+    while (size--) {
+      Float4 s[num_vectors];
+      Tick<shape>(s);
+      for (size_t i = 0; i < num_vectors; ++i) {
+        Store(out, s[i]);
+        out += kSimdWidth;
+      }
+    }
+  }
+  
+  // Writes the weighted sum of the oscillators' outputs.
+  template<OscillatorShape shape>
+  void Render(
+      const float* frequency,
+      const float* pw,
+      const float* amplitude,
+      float* out,
+      size_t size) {
+    Prepare<shape>(frequency, pw, size);
+    Float4 a[num_vectors];
+    for (size_t i = 0; i < num_vectors; ++i) {
+      a[i] = Load(&amplitude[i * kSimdWidth]);
+    }
+    while (size--) {
+      Float4 s[num_vectors];
+      Tick<shape>(s);
+      Float4 sum = s[0] * a[0];
+      for (size_t i = 1; i < num_vectors; ++i) {
+        sum += s[i] * a[i];
+      }
+      *out++ = Sum(sum);
+    }
+  }
+  
+ private:
+  template<OscillatorShape shape>
+  inline void Prepare(const float* frequency, const float* pw, size_t size) {
+    const Float4 size_vector = Splat(static_cast<float>(size));
+    for (size_t i = 0; i < num_vectors; ++i) {
+      Float4 f = Load(&frequency[i * kSimdWidth]);
+      f = Min(Max(f, Splat(kMinFrequency)), Splat(kMaxFrequency));
+      Float4 p = (shape == OSCILLATOR_SHAPE_SQUARE_TRIANGLE ||
+                  shape == OSCILLATOR_SHAPE_TRIANGLE)
+          ? Splat(0.5f)
+          : Load(&pw[i * kSimdWidth]);
+      p = Max(Min(p, 1.0f - 2.0f * f), 2.0f * f);
+      frequency_increment_[i] = (f - frequency_[i]) / size_vector;
+      pw_increment_[i] = (p - pw_[i]) / size_vector;
+    }
+  }
+  
+  template<OscillatorShape shape>
+  inline void Tick(Float4* out) {
+    const Float4 one = Splat(1.0f);
+    const Float4 zero = Float4();
+    
+    for (size_t i = 0; i < num_vectors; ++i) {
+      frequency_[i] += frequency_increment_[i];
+      pw_[i] += pw_increment_[i];
+      
+      const Float4 frequency = frequency_[i];
+      const Float4 pw = (shape == OSCILLATOR_SHAPE_SQUARE_TRIANGLE ||
+                         shape == OSCILLATOR_SHAPE_TRIANGLE)
+          ? Splat(0.5f)
+          : pw_[i];
+      const Float4 inverse_frequency = one / frequency;
+      
+      Float4 this_sample = next_sample_[i];
+      Float4 next_sample = zero;
+      Float4 phase = phase_[i] + frequency;
+      Float4 high = high_[i];
+      
+      // The polyBLEP residuals are always computed, and scaled by masks
+      // (0.0f or 1.0f) indicating whether a discontinuity occurred.
+      if (shape <= OSCILLATOR_SHAPE_SAW) {
+        const Float4 wrap = Mask(phase >= one);
+        phase -= wrap;
+        const Float4 t = phase * inverse_frequency;
+        this_sample -= wrap * ThisBlepSample(t);
+        next_sample -= wrap * NextBlepSample(t);
+        next_sample += phase;
+        
+        if (shape == OSCILLATOR_SHAPE_SAW) {
+          out[i] = 2.0f * this_sample - one;
+        } else {
+          lp_state_[i] += 0.25f * ((hp_state_[i] - this_sample) - lp_state_[i]);
+          out[i] = 4.0f * lp_state_[i];
+          hp_state_[i] = this_sample;
+        }
+      } else if (shape <= OSCILLATOR_SHAPE_SLOPE) {
+        Float4 slope_up = Splat(2.0f);
+        Float4 slope_down = Splat(2.0f);
+        if (shape == OSCILLATOR_SHAPE_SLOPE) {
+          slope_up = one / pw;
+          slope_down = one / (one - pw);
+        }
+        const Float4 discontinuity = (slope_up + slope_down) * frequency;
+        
+        const Float4 below = Mask(phase < pw);
+        const Float4 edge = Select(high != below, discontinuity, zero);
+        const Float4 t_edge = (phase - pw) * inverse_frequency;
+        this_sample -= ThisIntegratedBlepSample(t_edge) * edge;
+        next_sample -= NextIntegratedBlepSample(t_edge) * edge;
+        high = below;
+        
+        const Float4 wrap = Mask(phase >= one);
+        phase -= wrap;
+        const Float4 t_wrap = phase * inverse_frequency;
+        const Float4 wrap_discontinuity = wrap * discontinuity;
+        this_sample += ThisIntegratedBlepSample(t_wrap) * wrap_discontinuity;
+        next_sample += NextIntegratedBlepSample(t_wrap) * wrap_discontinuity;
+        high = Max(high, wrap);
+        
+        next_sample += Select(
+            high > 0.5f,
+            phase * slope_up,
+            one - (phase - pw) * slope_down);
+        out[i] = 2.0f * this_sample - one;
+      } else {
+        const Float4 above = Mask(phase >= pw);
+        const Float4 edge = Mask(high != above);
+        const Float4 t_edge = (phase - pw) * inverse_frequency;
+        this_sample += ThisBlepSample(t_edge) * edge;
+        next_sample += NextBlepSample(t_edge) * edge;
+        high = above;
+        
+        const Float4 wrap = Mask(phase >= one);
+        phase -= wrap;
+        const Float4 t_wrap = phase * inverse_frequency;
+        this_sample -= ThisBlepSample(t_wrap) * wrap;
+        next_sample -= NextBlepSample(t_wrap) * wrap;
+        high *= one - wrap;
+        
+        next_sample += Mask(phase >= pw);
+        
+        if (shape == OSCILLATOR_SHAPE_SQUARE_TRIANGLE) {
+          const Float4 integrator_coefficient = frequency * 0.0625f;
+          this_sample = 128.0f * (this_sample - 0.5f);
+          lp_state_[i] += integrator_coefficient * (this_sample - lp_state_[i]);
+          out[i] = lp_state_[i];
+        } else if (shape == OSCILLATOR_SHAPE_SQUARE_DARK) {
+          const Float4 integrator_coefficient = frequency * 2.0f;
+          this_sample = 4.0f * (this_sample - 0.5f);
+          lp_state_[i] += integrator_coefficient * (this_sample - lp_state_[i]);
+          out[i] = lp_state_[i];
+        } else if (shape == OSCILLATOR_SHAPE_SQUARE_BRIGHT) {
+          const Float4 integrator_coefficient = frequency * 2.0f;
+          this_sample = 2.0f * this_sample - one;
+          lp_state_[i] += integrator_coefficient * (this_sample - lp_state_[i]);
+          out[i] = (this_sample - lp_state_[i]) * 0.5f;
+        } else {
+          out[i] = 2.0f * this_sample - one;
+        }
+      }
+      
+      phase_[i] = phase;
+      high_[i] = high;
+      next_sample_[i] = next_sample;
+    }
+  }
+  
+  // Vectorized versions of the polyBLEP residuals from stmlib/dsp/polyblep.h.
+  static inline Float4 ThisBlepSample(Float4 t) {
+    return 0.5f * t * t;
+  }
+  
+  static inline Float4 NextBlepSample(Float4 t) {
+    t = 1.0f - t;
+    return -0.5f * t * t;
+  }
+  
+  static inline Float4 NextIntegratedBlepSample(Float4 t) {
+    const Float4 t1 = 0.5f * t;
+    const Float4 t2 = t1 * t1;
+    const Float4 t4 = t2 * t2;
+    return 0.1875f - t1 + 1.5f * t2 - t4;
+  }
+  
+  static inline Float4 ThisIntegratedBlepSample(Float4 t) {
+    return NextIntegratedBlepSample(1.0f - t);
+  }
+  
+  // Oscillator state. high_ is stored as 0.0f/1.0f.
+  Float4 phase_[num_vectors];
+  Float4 next_sample_[num_vectors];
+  Float4 lp_state_[num_vectors];
+  Float4 hp_state_[num_vectors];
+  Float4 high_[num_vectors];
+  
+  // For interpolation of parameters.
+  Float4 frequency_[num_vectors];
+  Float4 pw_[num_vectors];
+  Float4 frequency_increment_[num_vectors];
+  Float4 pw_increment_[num_vectors];
+  
+  STATIC_ASSERT(num_oscillators % kSimdWidth == 0, multiple_of_simd_width);
+  
+  DISALLOW_COPY_AND_ASSIGN(OscillatorBank);
+};
+
+}  // namespace plaits
+
+#endif  // PLAITS_DSP_OSCILLATOR_OSCILLATOR_BANK_H_
@@ -0,0 +1,245 @@
+// Copyright 2016 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+//
+// -----------------------------------------------------------------------------
+//
+// Bank of divide-down oscillators rendered in lockstep - same waveforms as
+// StringSynthOscillator, with one oscillator per vector lane. The
+// discontinuities are corrected with masks whenever one of the lanes of a
+// vector crosses a segment boundary, so the output of each lane is identical
+// to the output of a StringSynthOscillator.
+//
+// Each oscillator is mixed into one of two outputs. Only the first
+// num_oscillators (rounded up to a multiple of 4) are rendered.
+
+#ifndef PLAITS_DSP_OSCILLATOR_STRING_SYNTH_OSCILLATOR_BANK_H_
+#define PLAITS_DSP_OSCILLATOR_STRING_SYNTH_OSCILLATOR_BANK_H_
+
+#include <algorithm>
+
+#include "stmlib/dsp/dsp.h"
+
+#include "plaits/dsp/simd.h"
+
+namespace plaits {
+
+template<size_t max_num_oscillators>
+class StringSynthOscillatorBank {
+ public:
+  StringSynthOscillatorBank() { }
+  ~StringSynthOscillatorBank() { }
+  
+  enum {
+    max_num_vectors = max_num_oscillators / kSimdWidth
+  };
+  
+  void Init() {
+    for (size_t i = 0; i < max_num_vectors; ++i) {
+      phase_[i] = Float4();
+      next_sample_[i] = Float4();
+      segment_[i] = Int4();
+      
+      frequency_[i] = Splat(0.001f);
+      saw_8_gain_[i] = Float4();
+      saw_4_gain_[i] = Float4();
+      saw_2_gain_[i] = Float4();
+      saw_1_gain_[i] = Float4();
+    }
+  }
+  
+  // The output of oscillator i is added to aux if route[i] is 1.0f, to out if
+  // route[i] is 0.0f.
+  void Render(
+      size_t num_oscillators,
+      const float* frequency,
+      const float* unshifted_registration,
+      const float* gain,
+      const float* route,
+      float* out,
+      float* aux,
+      size_t size) {
+    const size_t num_vectors = std::min(
+        (num_oscillators + kSimdWidth - 1) / kSimdWidth,
+        size_t(max_num_vectors));
+    Prepare(num_vectors, frequency, unshifted_registration, gain, size);
+    
+    Float4 aux_mask[max_num_vectors];
+    Float4 out_mask[max_num_vectors];
+    for (size_t i = 0; i < num_vectors; ++i) {
+      aux_mask[i] = Load(&route[i * kSimdWidth]) * 2.0f;
+      out_mask[i] = 2.0f - aux_mask[i];
+    }
+    
+    const Float4 zero = Float4();
+    const Float4 eight = Splat(8.0f);
+    while (size--) {
+      Float4 out_sum = zero;
+      Float4 aux_sum = zero;
+      for (size_t i = 0; i < num_vectors; ++i) {
+        Float4 this_sample = next_sample_[i];
+        Float4 next_sample = zero;
+        
+        const Float4 frequency = frequency_[i] += frequency_increment_[i];
+        const Float4 saw_8_gain = saw_8_gain_[i] += saw_8_gain_increment_[i];
+        const Float4 saw_4_gain = saw_4_gain_[i] += saw_4_gain_increment_[i];
+        const Float4 saw_2_gain = saw_2_gain_[i] += saw_2_gain_increment_[i];
+        const Float4 saw_1_gain = saw_1_gain_[i] += saw_1_gain_increment_[i];
+        
+        Float4 phase = phase_[i] + frequency;
+        Int4 segment = ToInt(phase);
+        const Int4 changed = segment != segment_[i];
+        if (Any(changed)) {
+          const Int4 wrap = segment == 8;
+          phase -= Select(wrap, eight, zero);
+          segment -= wrap & 8;
+          
+          // Subtracting 0.0f is exact, so the sum is the same as in the
+          // scalar version, in which the terms are conditionally subtracted.
+          Float4 discontinuity = zero;
+          discontinuity -= Select(wrap, saw_8_gain, zero);
+          discontinuity -= Select((segment & 3) == 0, saw_4_gain, zero);
+          discontinuity -= Select((segment & 1) == 0, saw_2_gain, zero);
+          discontinuity -= saw_1_gain;
+          discontinuity = Select(changed, discontinuity, zero);
+          
+          const Float4 t = (phase - ToFloat(segment)) / frequency;
+          this_sample += ThisBlepSample(t) * discontinuity;
+          next_sample += NextBlepSample(t) * discontinuity;
+        }
+        
+        next_sample += (phase - 4.0f) * saw_8_gain * 0.125f;
+        next_sample += (phase - ToFloat(segment & 4) - 2.0f) * \
+            saw_4_gain * 0.25f;
+        next_sample += (phase - ToFloat(segment & 6) - 1.0f) * \
+            saw_2_gain * 0.5f;
+        next_sample += (phase - ToFloat(segment & 7) - 0.5f) * saw_1_gain;
+        
+        out_sum += this_sample * out_mask[i];
+        aux_sum += this_sample * aux_mask[i];
+        
+        phase_[i] = phase;
+        segment_[i] = segment;
+        next_sample_[i] = next_sample;
+      }
+      *out++ += Sum(out_sum);
+      *aux++ += Sum(aux_sum);
+    }
+  }
+  
+ private:
+  void Prepare(
+      size_t num_vectors,
+      const float* frequency,
+      const float* unshifted_registration,
+      const float* gain,
+      size_t size) {
+    float f[max_num_oscillators];
+    float saw_8_gain[max_num_oscillators];
+    float saw_4_gain[max_num_oscillators];
+    float saw_2_gain[max_num_oscillators];
+    float saw_1_gain[max_num_oscillators];
+    
+    for (size_t i = 0; i < num_vectors * kSimdWidth; ++i) {
+      f[i] = frequency[i] * 8.0f;
+      
+      // Same octave shifting as in StringSynthOscillator. Oscillators whose
+      // frequency is too high are silenced.
+      size_t shift = 0;
+      while (f[i] > 0.5f) {
+        shift += 2;
+        f[i] *= 0.5f;
+      }
+      float g = gain[i];
+      if (shift >= 8) {
+        shift = 0;
+        g = 0.0f;
+      }
+      
+      float registration[7];
+      std::fill(&registration[0], &registration[shift], 0.0f);
+      std::copy(
+          &unshifted_registration[0],
+          &unshifted_registration[7 - shift],
+          &registration[shift]);
+      
+      saw_8_gain[i] = (registration[0] + 2.0f * registration[1]) * g;
+      saw_4_gain[i] = (registration[2] - registration[1] + \
+          2.0f * registration[3]) * g;
+      saw_2_gain[i] = (registration[4] - registration[3] + \
+          2.0f * registration[5]) * g;
+      saw_1_gain[i] = (registration[6] - registration[5]) * g;
+    }
+    
+    const Float4 size_vector = Splat(static_cast<float>(size));
+    for (size_t i = 0; i < num_vectors; ++i) {
+      const size_t offset = i * kSimdWidth;
+      frequency_increment_[i] = \
+          (Load(&f[offset]) - frequency_[i]) / size_vector;
+      saw_8_gain_increment_[i] = \
+          (Load(&saw_8_gain[offset]) - saw_8_gain_[i]) / size_vector;
+      saw_4_gain_increment_[i] = \
+          (Load(&saw_4_gain[offset]) - saw_4_gain_[i]) / size_vector;
+      saw_2_gain_increment_[i] = \
+          (Load(&saw_2_gain[offset]) - saw_2_gain_[i]) / size_vector;
+      saw_1_gain_increment_[i] = \
+          (Load(&saw_1_gain[offset]) - saw_1_gain_[i]) / size_vector;
+    }
+  }
+  
+  // Vectorized versions of the polyBLEP residuals from stmlib/dsp/polyblep.h.
+  static inline Float4 ThisBlepSample(Float4 t) {
+    return 0.5f * t * t;
+  }
+  
+  static inline Float4 NextBlepSample(Float4 t) {
+    t = 1.0f - t;
+    return -0.5f * t * t;
+  }
+  
+  // Oscillator state.
+  Float4 phase_[max_num_vectors];
+  Float4 next_sample_[max_num_vectors];
+  Int4 segment_[max_num_vectors];
+  
+  // For interpolation of parameters.
+  Float4 frequency_[max_num_vectors];
+  Float4 saw_8_gain_[max_num_vectors];
+  Float4 saw_4_gain_[max_num_vectors];
+  Float4 saw_2_gain_[max_num_vectors];
+  Float4 saw_1_gain_[max_num_vectors];
+  Float4 frequency_increment_[max_num_vectors];
+  Float4 saw_8_gain_increment_[max_num_vectors];
+  Float4 saw_4_gain_increment_[max_num_vectors];
+  Float4 saw_2_gain_increment_[max_num_vectors];
+  Float4 saw_1_gain_increment_[max_num_vectors];
+  
+  STATIC_ASSERT(max_num_oscillators % kSimdWidth == 0, multiple_of_simd_width);
+  
+  DISALLOW_COPY_AND_ASSIGN(StringSynthOscillatorBank);
+};
+
+}  // namespace plaits
+
+#endif  // PLAITS_DSP_OSCILLATOR_STRING_SYNTH_OSCILLATOR_BANK_H_
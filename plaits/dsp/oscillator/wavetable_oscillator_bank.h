@@ -0,0 +1,189 @@
+// Copyright 2016 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+//
+// -----------------------------------------------------------------------------
+//
+// Bank of integrated wavetable oscillators rendered in lockstep - same
+// algorithm as WavetableOscillator (with approximate_scale), with one
+// oscillator per vector lane. All oscillators share the same waveform. The
+// table lookups are done lane by lane; the interpolation, differentiation and
+// filtering are vectorized. This assumes a little-endian target.
+//
+// Each oscillator is mixed into one of two outputs. Only the first
+// num_oscillators (rounded up to a multiple of 4) are rendered.
+
+#ifndef PLAITS_DSP_OSCILLATOR_WAVETABLE_OSCILLATOR_BANK_H_
+#define PLAITS_DSP_OSCILLATOR_WAVETABLE_OSCILLATOR_BANK_H_
+
+#include <algorithm>
+
+#include "stmlib/dsp/dsp.h"
+#include "stmlib/dsp/parameter_interpolator.h"
+
+#include "plaits/dsp/oscillator/oscillator.h"
+#include "plaits/dsp/simd.h"
+
+namespace plaits {
+
+template<
+    size_t wavetable_size,
+    size_t num_waves,
+    size_t max_num_oscillators>
+class WavetableOscillatorBank {
+ public:
+  WavetableOscillatorBank() { }
+  ~WavetableOscillatorBank() { }
+  
+  enum {
+    max_num_vectors = max_num_oscillators / kSimdWidth
+  };
+  
+  void Init() {
+    for (size_t i = 0; i < max_num_vectors; ++i) {
+      phase_[i] = Float4();
+      frequency_[i] = Float4();
+      amplitude_[i] = Float4();
+      lp_[i] = Float4();
+      differentiator_lp_[i] = Float4();
+      differentiator_previous_[i] = Float4();
+    }
+    waveform_ = 0.0f;
+  }
+  
+  // The output of oscillator i is added to aux if route[i] is 1.0f, to out if
+  // route[i] is 0.0f. Frequencies must be strictly positive.
+  void Render(
+      size_t num_oscillators,
+      const float* frequency,
+      const float* amplitude,
+      float waveform,
+      const int16_t** wavetable,
+      const float* route,
+      float* out,
+      float* aux,
+      size_t size) {
+    const size_t num_vectors = std::min(
+        (num_oscillators + kSimdWidth - 1) / kSimdWidth,
+        size_t(max_num_vectors));
+    
+    const Float4 size_vector = Splat(static_cast<float>(size));
+    Float4 aux_mask[max_num_vectors];
+    Float4 out_mask[max_num_vectors];
+    for (size_t i = 0; i < num_vectors; ++i) {
+      Float4 f = Min(Load(&frequency[i * kSimdWidth]), Splat(kMaxFrequency));
+      Float4 a = Load(&amplitude[i * kSimdWidth]);
+      a *= 1.0f - 2.0f * f;
+      a *= 1.0f / (f * 131072.0f) * (0.95f - f);
+      frequency_increment_[i] = (f - frequency_[i]) / size_vector;
+      amplitude_increment_[i] = (a - amplitude_[i]) / size_vector;
+      aux_mask[i] = Load(&route[i * kSimdWidth]);
+      out_mask[i] = 1.0f - aux_mask[i];
+    }
+    
+    // All oscillators share the same waveform.
+    stmlib::ParameterInterpolator waveform_modulation(
+        &waveform_,
+        waveform * float(num_waves - 1.0001f),
+        size);
+    
+    const Float4 one = Splat(1.0f);
+    while (size--) {
+      Float4 out_sum = Float4();
+      Float4 aux_sum = Float4();
+      
+      const float waveform = waveform_modulation.Next();
+      MAKE_INTEGRAL_FRACTIONAL(waveform);
+      const int16_t* wave_0 = wavetable[waveform_integral];
+      const int16_t* wave_1 = wavetable[waveform_integral + 1];
+      
+      for (size_t i = 0; i < num_vectors; ++i) {
+        const Float4 f0 = frequency_[i] += frequency_increment_[i];
+        const Float4 cutoff = Min(float(wavetable_size) * f0, one);
+        
+        Float4 phase = phase_[i] + f0;
+        phase -= Mask(phase >= one);
+        phase_[i] = phase;
+        
+        const Float4 p = phase * float(wavetable_size);
+        const Int4 p_integral = ToInt(p);
+        const Float4 p_fractional = p - ToFloat(p_integral);
+        
+        // Each pair of adjacent samples is read with a single 32-bit load.
+        Int4 pair_0, pair_1;
+        for (size_t j = 0; j < kSimdWidth; ++j) {
+          pair_0[j] = LoadPair(wave_0 + p_integral[j]);
+          pair_1[j] = LoadPair(wave_1 + p_integral[j]);
+        }
+        const Float4 x0_a = ToFloat((pair_0 << 16) >> 16);
+        const Float4 x0_b = ToFloat(pair_0 >> 16);
+        const Float4 x1_a = ToFloat((pair_1 << 16) >> 16);
+        const Float4 x1_b = ToFloat(pair_1 >> 16);
+        const Float4 x0 = x0_a + (x0_b - x0_a) * p_fractional;
+        const Float4 x1 = x1_a + (x1_b - x1_a) * p_fractional;
+        const Float4 s = x0 + (x1 - x0) * Splat(waveform_fractional);
+        
+        differentiator_lp_[i] += cutoff * (
+            (s - differentiator_previous_[i]) - differentiator_lp_[i]);
+        differentiator_previous_[i] = s;
+        
+        lp_[i] += cutoff * 0.5f * (differentiator_lp_[i] - lp_[i]);
+        const Float4 a = amplitude_[i] += amplitude_increment_[i];
+        const Float4 y = a * lp_[i];
+        out_sum += y * out_mask[i];
+        aux_sum += y * aux_mask[i];
+      }
+      *out++ += Sum(out_sum);
+      *aux++ += Sum(aux_sum);
+    }
+  }
+
+ private:
+  static inline int32_t LoadPair(const int16_t* samples) {
+    int32_t pair;
+    memcpy(&pair, samples, sizeof(pair));
+    return pair;
+  }
+  
+  // Oscillator state.
+  Float4 phase_[max_num_vectors];
+  Float4 lp_[max_num_vectors];
+  Float4 differentiator_lp_[max_num_vectors];
+  Float4 differentiator_previous_[max_num_vectors];
+  
+  // For interpolation of parameters.
+  Float4 frequency_[max_num_vectors];
+  Float4 amplitude_[max_num_vectors];
+  Float4 frequency_increment_[max_num_vectors];
+  Float4 amplitude_increment_[max_num_vectors];
+  float waveform_;
+  
+  STATIC_ASSERT(max_num_oscillators % kSimdWidth == 0, multiple_of_simd_width);
+  
+  DISALLOW_COPY_AND_ASSIGN(WavetableOscillatorBank);
+};
+
+}  // namespace plaits
+
+#endif  // PLAITS_DSP_OSCILLATOR_WAVETABLE_OSCILLATOR_BANK_H_
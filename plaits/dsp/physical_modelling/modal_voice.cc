@@ -37,6 +37,7 @@
 #include "stmlib/dsp/units.h"
 #include "stmlib/utils/random.h"
 
+#include "plaits/dsp/dsp.h"
 #include "plaits/dsp/noise/dust.h"
 
 namespace plaits {
@@ -75,7 +76,8 @@ void ModalVoice::Render(
   
   // Synthesize excitation signal.
   if (sustain) {
-    const float dust_f = 0.00005f + 0.99995f * density * density;
+    const float dust_f = (0.00005f + 0.99995f * density * density) * \
+        SampleRateRatio();
     for (size_t i = 0; i < size; ++i) {
       temp[i] = Dust(dust_f) * (4.0f - dust_f * 3.0f) * accent;
     }
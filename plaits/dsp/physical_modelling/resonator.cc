@@ -34,6 +34,7 @@
 #include "stmlib/dsp/dsp.h"
 #include "stmlib/dsp/units.h"
 
+#include "plaits/dsp/dsp.h"
 #include "plaits/resources.h"
 
 namespace plaits {
@@ -83,7 +84,7 @@ void Resonator::Process(
   float harmonic = f0;
   float stretch_factor = 1.0f;
   float q_sqrt = SemitonesToRatio(damping * 79.7f);
-  float q = 500.0f * q_sqrt * q_sqrt;
+  float q = 500.0f / SampleRateRatio() * q_sqrt * q_sqrt;
   brightness *= 1.0f - structure * 0.3f;
   brightness *= 1.0f - damping * 0.3f;
   float q_loss = brightness * (2.0f - brightness) * 0.85f + 0.15f;
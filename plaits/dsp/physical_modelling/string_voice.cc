@@ -33,6 +33,7 @@
 #include "stmlib/dsp/units.h"
 #include "stmlib/utils/random.h"
 
+#include "plaits/dsp/dsp.h"
 #include "plaits/dsp/noise/dust.h"
 
 namespace plaits {
@@ -80,7 +81,8 @@ void StringVoice::Render(
   }
 
   if (sustain) {
-    const float dust_f = 0.00005f + 0.99995f * density * density;
+    const float dust_f = (0.00005f + 0.99995f * density * density) * \
+        SampleRateRatio();
     for (size_t i = 0; i < size; ++i) {
       temp[i] = Dust(dust_f) * (8.0f - dust_f * 6.0f) * accent;
     }
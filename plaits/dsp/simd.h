@@ -0,0 +1,95 @@
+// Copyright 2016 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// 4-lane float vectors, using the GCC vector extensions. This compiles to SSE
+// on x86 hosts, to NEON on ARMv7-A/ARMv8, and is lowered to scalar code on
+// targets without a vector unit (like the Cortex-M4).
+
+#ifndef PLAITS_DSP_SIMD_H_
+#define PLAITS_DSP_SIMD_H_
+
+#include "stmlib/stmlib.h"
+
+#include <cstring>
+
+namespace plaits {
+
+const size_t kSimdWidth = 4;
+
+typedef float Float4 __attribute__((vector_size(16)));
+typedef int32_t Int4 __attribute__((vector_size(16)));
+
+inline Float4 Splat(float x) {
+  return Float4() + x;
+}
+
+inline Float4 Load(const float* source) {
+  Float4 x;
+  memcpy(&x, source, sizeof(x));
+  return x;
+}
+
+inline void Store(float* destination, Float4 x) {
+  memcpy(destination, &x, sizeof(x));
+}
+
+// Truncates towards zero, like static_cast<int32_t>.
+inline Int4 ToInt(Float4 x) {
+  return __builtin_convertvector(x, Int4);
+}
+
+inline Float4 ToFloat(Int4 x) {
+  return __builtin_convertvector(x, Float4);
+}
+
+// Converts a comparison result into 0.0f/1.0f.
+inline Float4 Mask(Int4 condition) {
+  return condition ? Splat(1.0f) : Float4();
+}
+
+inline bool Any(Int4 condition) {
+  return (condition[0] | condition[1] | condition[2] | condition[3]) != 0;
+}
+
+inline Float4 Select(Int4 condition, Float4 a, Float4 b) {
+  return condition ? a : b;
+}
+
+inline Float4 Min(Float4 a, Float4 b) {
+  return a < b ? a : b;
+}
+
+inline Float4 Max(Float4 a, Float4 b) {
+  return a > b ? a : b;
+}
+
+inline float Sum(Float4 x) {
+  return (x[0] + x[1]) + (x[2] + x[3]);
+}
+
+}  // namespace plaits
+
+#endif  // PLAITS_DSP_SIMD_H_
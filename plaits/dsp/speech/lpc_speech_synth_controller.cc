@@ -116,8 +116,19 @@ void LPCSpeechSynthWordBank::Init(
     BufferAllocator* allocator) {
   word_banks_ = word_banks;
   num_banks_ = num_banks;
-  frames_ = allocator->Allocate<LPCSpeechSynth::Frame>(
+  buffer_ = allocator->Allocate<LPCSpeechSynth::Frame>(
       kLPCSpeechSynthMaxFrames);
+  frames_ = buffer_;
+  cache_ = NULL;
+  Reset();
+}
+
+void LPCSpeechSynthWordBank::Init(const LPCSpeechSynthWordBankCache* cache) {
+  word_banks_ = NULL;
+  num_banks_ = cache->num_banks();
+  buffer_ = NULL;
+  frames_ = NULL;
+  cache_ = cache;
   Reset();
 }
 
@@ -174,18 +185,33 @@ size_t LPCSpeechSynthWordBank::LoadNextWord(const uint8_t* data) {
         }
       }
     }
-    frames_[num_frames_++] = frame;
+    buffer_[num_frames_++] = frame;
   }
   return bitstream.ptr() - data;
 }
 
 bool LPCSpeechSynthWordBank::Load(int bank) {
-  if (bank == loaded_bank_ || bank >= num_banks_) {
+  // The cache may hold fewer banks than the ROM, if its storage was too small.
+  const int num_banks = cache_ ? cache_->num_banks() : num_banks_;
+  if (bank == loaded_bank_ || bank >= num_banks) {
     return false;
   }
 
+  if (cache_) {
+    frames_ = cache_->frames(bank);
+    num_frames_ = cache_->num_frames(bank);
+    num_words_ = cache_->num_words(bank);
+    copy(
+        &cache_->word_boundaries(bank)[0],
+        &cache_->word_boundaries(bank)[num_words_ + 1],
+        &word_boundaries_[0]);
+    loaded_bank_ = bank;
+    return true;
+  }
+  
   num_frames_ = 0;
   num_words_ = 0;
+  frames_ = buffer_;
   
   const uint8_t* data = word_banks_[bank].data;
   size_t size = word_banks_[bank].size;
@@ -203,6 +229,41 @@ bool LPCSpeechSynthWordBank::Load(int bank) {
   return true;
 }
 
+bool LPCSpeechSynthWordBankCache::Init(
+    const LPCSpeechSynthWordBankData* word_banks,
+    int num_banks,
+    LPCSpeechSynth::Frame* storage) {
+  num_banks_ = min(num_banks, kLPCSpeechSynthMaxWordBanks);
+  
+  // Decode each bank with a word bank whose buffer is the free space left in
+  // storage.
+  LPCSpeechSynth::Frame* free_space = storage;
+  int free_frames = kLPCSpeechSynthWordBankCacheSize;
+  for (int i = 0; i < num_banks_; ++i) {
+    if (free_frames < kLPCSpeechSynthMaxFrames) {
+      num_banks_ = i;
+      return false;
+    }
+    BufferAllocator allocator(
+        free_space,
+        kLPCSpeechSynthMaxFrames * sizeof(LPCSpeechSynth::Frame));
+    LPCSpeechSynthWordBank word_bank;
+    word_bank.Init(word_banks, num_banks, &allocator);
+    word_bank.Load(i);
+    
+    frames_[i] = free_space;
+    num_frames_[i] = word_bank.num_frames();
+    num_words_[i] = word_bank.num_words();
+    copy(
+        &word_bank.word_boundaries()[0],
+        &word_bank.word_boundaries()[num_words_[i] + 1],
+        &word_boundaries_[i][0]);
+    free_space += num_frames_[i];
+    free_frames -= num_frames_[i];
+  }
+  return true;
+}
+
 void LPCSpeechSynthController::Init(LPCSpeechSynthWordBank* word_bank) {
   word_bank_ = word_bank;
   
@@ -233,11 +294,11 @@ void LPCSpeechSynthController::Render(
     float* output,
     size_t size) {
   const float rate_ratio = SemitonesToRatio((formant_shift - 0.5f) * 36.0f);
-  const float rate = rate_ratio / 6.0f;
+  const float rate = rate_ratio / 6.0f * SampleRateRatio();
   
   // All utterances have been normalized for an average f0 of 100 Hz.
   const float pitch_shift = frequency / \
-      (rate_ratio * kLPCSpeechSynthDefaultF0 / kCorrectedSampleRate);
+      (rate_ratio * kLPCSpeechSynthDefaultF0 / CorrectedSampleRate());
   const float time_stretch = SemitonesToRatio(-speed * 24.0f +
         (formant_shift < 0.4f ? (formant_shift - 0.4f) * -45.0f
             : (formant_shift > 0.6f ? (formant_shift - 0.6f) * -45.0f : 0.0f)));
@@ -283,7 +344,7 @@ void LPCSpeechSynthController::Render(
   } else {
     if (remaining_frame_samples_ == 0) {
       synth_.PlayFrame(frames, float(playback_frame_), false);
-      remaining_frame_samples_ = kSampleRate / kLPCSpeechSynthFPS * \
+      remaining_frame_samples_ = SampleRate() / kLPCSpeechSynthFPS * \
           time_stretch;
       ++playback_frame_;
       if (playback_frame_ >= last_playback_frame_) {
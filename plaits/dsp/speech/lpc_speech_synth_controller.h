@@ -97,6 +97,57 @@ struct LPCSpeechSynthWordBankData {
   size_t size;
 };
 
+const int kLPCSpeechSynthMaxWordBanks = 8;
+
+// Number of frames to provide to LPCSpeechSynthWordBankCache::Init(): enough
+// for all the word banks of the module, with room to decode the largest one.
+const int kLPCSpeechSynthWordBankCacheSize = 2048 + kLPCSpeechSynthMaxFrames;
+
+// All the word banks, decoded once. The cache is immutable once initialized,
+// and can be shared by any number of word banks used from any number of
+// threads. It takes about 35kB, so this is for hosts only.
+class LPCSpeechSynthWordBankCache {
+ public:
+  LPCSpeechSynthWordBankCache() { }
+  ~LPCSpeechSynthWordBankCache() { }
+  
+  // Decodes the banks into storage, which must hold
+  // kLPCSpeechSynthWordBankCacheSize frames. Returns false if it is too
+  // small.
+  bool Init(
+      const LPCSpeechSynthWordBankData* word_banks,
+      int num_banks,
+      LPCSpeechSynth::Frame* storage);
+  
+  inline int num_banks() const { return num_banks_; }
+  
+  inline const LPCSpeechSynth::Frame* frames(int bank) const {
+    return frames_[bank];
+  }
+  
+  inline int num_frames(int bank) const {
+    return num_frames_[bank];
+  }
+  
+  inline int num_words(int bank) const {
+    return num_words_[bank];
+  }
+  
+  inline const int* word_boundaries(int bank) const {
+    return word_boundaries_[bank];
+  }
+  
+ private:
+  int num_banks_;
+  const LPCSpeechSynth::Frame* frames_[kLPCSpeechSynthMaxWordBanks];
+  int num_frames_[kLPCSpeechSynthMaxWordBanks];
+  int num_words_[kLPCSpeechSynthMaxWordBanks];
+  int word_boundaries_
+      [kLPCSpeechSynthMaxWordBanks][kLPCSpeechSynthMaxWords + 1];
+  
+  DISALLOW_COPY_AND_ASSIGN(LPCSpeechSynthWordBankCache);
+};
+
 class LPCSpeechSynthWordBank {
  public:
   LPCSpeechSynthWordBank() { }
@@ -107,11 +158,26 @@ class LPCSpeechSynthWordBank {
       int num_banks,
       stmlib::BufferAllocator* allocator);
   
+  // Takes the frames from the cache instead of decoding them: no RAM is
+  // needed, and loading a bank is instantaneous.
+  void Init(const LPCSpeechSynthWordBankCache* cache);
+  
   bool Load(int index);
   void Reset();
   
+  // Loads the banks from the cache, if not NULL. The cache is not owned, and
+  // can be shared by several word banks.
+  inline void set_cache(const LPCSpeechSynthWordBankCache* cache) {
+    if (cache != cache_) {
+      cache_ = cache;
+      Reset();
+    }
+  }
+  
   inline int num_frames() const { return num_frames_; }
   inline const LPCSpeechSynth::Frame* frames() const { return frames_; }
+  inline int num_words() const { return num_words_; }
+  inline const int* word_boundaries() const { return word_boundaries_; }
   
   inline void GetWordBoundaries(float address, int* start, int* end) {
     if (num_words_ == 0) {
@@ -135,9 +201,11 @@ class LPCSpeechSynthWordBank {
   int loaded_bank_;
   int num_frames_;
   int num_words_;
-  int word_boundaries_[kLPCSpeechSynthMaxWords];
+  int word_boundaries_[kLPCSpeechSynthMaxWords + 1];
   
-  LPCSpeechSynth::Frame* frames_;
+  LPCSpeechSynth::Frame* buffer_;
+  const LPCSpeechSynth::Frame* frames_;
+  const LPCSpeechSynthWordBankCache* cache_;
   
   static uint8_t energy_lut_[16];
   static uint8_t period_lut_[64];
@@ -34,6 +34,36 @@ using namespace std;
 using namespace stmlib;
 
 void Voice::Init(BufferAllocator* allocator) {
+  RegisterEngines();
+#ifdef TEST
+  arena_pool_ = NULL;
+  engine_ram_usage_ = 0;
+#endif  // TEST
+  for (int i = 0; i < engines_.size(); ++i) {
+    // All engines will share the same RAM space.
+    allocator->Free();
+#ifdef TEST
+    size_t free = allocator->free();
+    engines_.get(i)->Init(allocator);
+    engine_ram_usage_ = max(engine_ram_usage_, free - allocator->free());
+    initialized_engines_ |= 1 << i;
+#else
+    engines_.get(i)->Init(allocator);
+#endif  // TEST
+  }
+  InitState();
+}
+
+#ifdef TEST
+void Voice::Init(EngineArenaPool* pool) {
+  RegisterEngines();
+  arena_pool_ = pool;
+  engine_ram_usage_ = 0;
+  InitState();
+}
+#endif  // TEST
+
+void Voice::RegisterEngines() {
   engines_.Init();
   engines_.RegisterInstance(&virtual_analog_engine_, false, 0.8f, 0.8f);
   engines_.RegisterInstance(&waveshaping_engine_, false, 0.7f, 0.6f);
@@ -52,18 +82,50 @@ void Voice::Init(BufferAllocator* allocator) {
   engines_.RegisterInstance(&bass_drum_engine_, true, 0.8f, 0.8f);
   engines_.RegisterInstance(&snare_drum_engine_, true, 0.8f, 0.8f);
   engines_.RegisterInstance(&hi_hat_engine_, true, 0.8f, 0.8f);
-  for (int i = 0; i < engines_.size(); ++i) {
-    // All engines will share the same RAM space.
-    allocator->Free();
-    engines_.get(i)->Init(allocator);
+#ifdef TEST
+  initialized_engines_ = 0;
+  wavetable_cache_ = NULL;
+  word_bank_cache_ = NULL;
+#endif  // TEST
+}
+
+#ifdef TEST
+bool Voice::may_draw_noise(
+    const Patch& patch,
+    const Modulations& modulations) const {
+  if (previous_engine_index_ >= kFirstNoiseEngine ||
+      fading_engine_index_ >= kFirstNoiseEngine) {
+    return true;
   }
-  
+  const float engine_cv = modulations.trigger_patched
+      ? engine_cv_
+      : modulations.engine;
+  const float engine = static_cast<float>(patch.engine) + \
+      engine_cv * static_cast<float>(engines_.size() - 1);
+  return engine + 1.0f > static_cast<float>(kFirstNoiseEngine);
+}
+#endif  // TEST
+
+void Voice::InitState() {
   engine_quantizer_.Init();
   previous_engine_index_ = -1;
   engine_cv_ = 0.0f;
   
-  out_post_processor_.Init();
-  aux_post_processor_.Init();
+  for (int i = 0; i < kNumPostProcessors; ++i) {
+    out_post_processor_[i].Init();
+    aux_post_processor_[i].Init();
+  }
+  
+#ifdef TEST
+  post_processor_index_ = 0;
+  fading_engine_index_ = -1;
+  crossfade_length_ = 0;
+  crossfade_remaining_ = 0;
+  crossfade_budget_ = 0.0f;
+  crossfade_credit_ = 0.0f;
+#endif  // TEST
+  
+  num_pending_frames_ = 0;
 
   decay_envelope_.Init();
   lpg_envelope_.Init();
@@ -74,11 +136,96 @@ void Voice::Init(BufferAllocator* allocator) {
   trigger_delay_.Init(trigger_delay_line_);
 }
 
+#ifdef TEST
+bool Voice::InitEngine(int index) {
+  BufferAllocator* allocator = arena_pool_->Acquire();
+  if (!allocator) {
+    return false;
+  }
+  size_t free = allocator->free();
+  engines_.get(index)->Init(allocator);
+  engine_ram_usage_ += free - allocator->free();
+  arena_pool_->Release();
+  
+  // Settings held by the voice are restored after the engine's Init().
+  wavetable_engine_.set_cache(wavetable_cache_);
+  speech_engine_.set_word_bank_cache(word_bank_cache_);
+  initialized_engines_ |= 1 << index;
+  return true;
+}
+#endif  // TEST
+
+void Voice::ComputeControls(
+    const Patch& patch,
+    const Modulations& modulations,
+    Controls* c) {
+  c->short_decay = (200.0f * kBlockSize) / SampleRate() *
+      SemitonesToRatio(-96.0f * patch.decay);
+  c->decay_tail = (20.0f * kBlockSize) / SampleRate() *
+      SemitonesToRatio(-72.0f * patch.decay + 12.0f * patch.lpg_colour) - \
+      c->short_decay;
+  
+  c->compressed_level = max(
+      1.3f * modulations.level / (0.3f + fabsf(modulations.level)),
+      0.0f);
+  c->accent = modulations.level_patched ? c->compressed_level : 0.8f;
+  c->lpg_enabled = modulations.level_patched || modulations.trigger_patched;
+  
+  c->harmonics = patch.harmonics + modulations.harmonics;
+  CONSTRAIN(c->harmonics, 0.0f, 1.0f);
+  
+  c->speech_envelope_amplitude = 2.0f - c->harmonics * 6.0f;
+  CONSTRAIN(c->speech_envelope_amplitude, 0.0f, 1.0f);
+}
+
 void Voice::Render(
     const Patch& patch,
     const Modulations& modulations,
     Frame* frames,
     size_t size) {
+  Controls c;
+  ComputeControls(patch, modulations, &c);
+  RenderBlock(patch, modulations, c, frames, size);
+}
+
+void Voice::RenderLargeBlock(
+    const Patch& patch,
+    const Modulations& modulations,
+    Frame* frames,
+    size_t size) {
+  // Start with what is left of the block rendered ahead by the previous call.
+  size_t n = min(size, num_pending_frames_);
+  copy(
+      &pending_frames_[kBlockSize - num_pending_frames_],
+      &pending_frames_[kBlockSize - num_pending_frames_ + n],
+      frames);
+  num_pending_frames_ -= n;
+  frames += n;
+  size -= n;
+  if (!size) {
+    return;
+  }
+  
+  Controls c;
+  ComputeControls(patch, modulations, &c);
+  while (size >= kBlockSize) {
+    RenderBlock(patch, modulations, c, frames, kBlockSize);
+    frames += kBlockSize;
+    size -= kBlockSize;
+  }
+  if (size) {
+    RenderBlock(patch, modulations, c, pending_frames_, kBlockSize);
+    copy(&pending_frames_[0], &pending_frames_[size], frames);
+    num_pending_frames_ = kBlockSize - size;
+  }
+}
+
+void Voice::RenderBlock(
+    const Patch& patch,
+    const Modulations& modulations,
+    const Controls& c,
+    Frame* frames,
+    size_t size) {
   // Trigger, LPG, internal envelope.
       
   // Delay trigger by 1ms to deal with sequencers or MIDI interfaces whose
@@ -112,11 +259,51 @@ void Voice::Render(
       engines_.size(),
       0.25f);
   
+#ifdef TEST
+  if (crossfade_length_) {
+    crossfade_credit_ = min(
+        crossfade_credit_ + crossfade_budget_ * float(size),
+        float(crossfade_length_));
+  }
+  
+  // Crossfading requires the two engines to have their own RAM. Engine
+  // changes are deferred until the current crossfade is complete, so that at
+  // most two engines are rendered, and until there is enough budget left to
+  // render the outgoing engine for the whole fade.
+  const bool crossfade = arena_pool_ &&
+      previous_engine_index_ != -1 &&
+      crossfade_length_ &&
+      crossfade_budget_ > 0.0f;
+  if (crossfade && (fading_engine_index_ != -1 ||
+                    crossfade_credit_ < float(crossfade_length_))) {
+    engine_index = previous_engine_index_;
+  }
+  
+  if (!engine_initialized(engine_index) && !InitEngine(engine_index)) {
+    // Out of RAM: stay on the current engine.
+    if (previous_engine_index_ == -1) {
+      fill(&frames[0], &frames[size], Frame());
+      return;
+    }
+    engine_index = previous_engine_index_;
+  }
+#endif  // TEST
+  
   Engine* e = engines_.get(engine_index);
   
   if (engine_index != previous_engine_index_) {
+#ifdef TEST
+    if (crossfade) {
+      fading_engine_index_ = previous_engine_index_;
+      crossfade_remaining_ = crossfade_length_;
+      crossfade_credit_ -= float(crossfade_length_);
+      
+      // The outgoing engine keeps its post-processors, with their state.
+      post_processor_index_ ^= 1;
+    }
+#endif  // TEST
     e->Reset();
-    out_post_processor_.Reset();
+    out_post_processor_[post_processor_index()].Reset();
     previous_engine_index_ = engine_index;
   }
   EngineParameters p;
@@ -132,27 +319,19 @@ void Voice::Render(
     p.trigger = TRIGGER_UNPATCHED;
   }
   
-  const float short_decay = (200.0f * kBlockSize) / kSampleRate *
-      SemitonesToRatio(-96.0f * patch.decay);
+  decay_envelope_.Process(c.short_decay * 2.0f);
 
-  decay_envelope_.Process(short_decay * 2.0f);
-
-  const float compressed_level = max(
-      1.3f * modulations.level / (0.3f + fabsf(modulations.level)),
-      0.0f);
-  p.accent = modulations.level_patched ? compressed_level : 0.8f;
+  p.accent = c.accent;
 
   bool use_internal_envelope = modulations.trigger_patched;
 
   // Actual synthesis parameters.
   
-  p.harmonics = patch.harmonics + modulations.harmonics;
-  CONSTRAIN(p.harmonics, 0.0f, 1.0f);
+  p.harmonics = c.harmonics;
 
   float internal_envelope_amplitude = 1.0f;
   if (engine_index == 7) {
-    internal_envelope_amplitude = 2.0f - p.harmonics * 6.0f;
-    CONSTRAIN(internal_envelope_amplitude, 0.0f, 1.0f);
+    internal_envelope_amplitude = c.speech_envelope_amplitude;
     speech_engine_.set_prosody_amount(
         !modulations.trigger_patched || modulations.frequency_patched ?
             0.0f : patch.frequency_modulation_amount);
@@ -198,44 +377,120 @@ void Voice::Render(
   bool already_enveloped = pp_s.already_enveloped;
   e->Render(p, out_buffer_, aux_buffer_, size, &already_enveloped);
   
-  bool lpg_bypass = already_enveloped || \
-      (!modulations.level_patched && !modulations.trigger_patched);
+  bool lpg_bypass = already_enveloped || !c.lpg_enabled;
+  
+  bool fading_lpg_bypass = true;
+#ifdef TEST
+  Engine* fading_engine = NULL;
+  if (fading_engine_index_ != -1) {
+    fading_engine = engines_.get(fading_engine_index_);
+    
+    EngineParameters fading_p = p;
+    if (fading_p.trigger == TRIGGER_RISING_EDGE) {
+      fading_p.trigger = TRIGGER_LOW;
+    }
+    bool fading_already_enveloped = \
+        fading_engine->post_processing_settings.already_enveloped;
+    fading_engine->Render(
+        fading_p,
+        fading_out_buffer_,
+        fading_aux_buffer_,
+        size,
+        &fading_already_enveloped);
+    fading_lpg_bypass = fading_already_enveloped || !c.lpg_enabled;
+    
+    // Complementary linear ramps.
+    const float step = 1.0f / float(crossfade_length_);
+    float gain = float(crossfade_remaining_) * step;
+    for (size_t i = 0; i < size; ++i) {
+      fading_out_buffer_[i] *= gain;
+      fading_aux_buffer_[i] *= gain;
+      out_buffer_[i] *= 1.0f - gain;
+      aux_buffer_[i] *= 1.0f - gain;
+      gain = max(gain - step, 0.0f);
+    }
+  }
+#endif  // TEST
   
   // Compute LPG parameters.
-  if (!lpg_bypass) {
+  if (!lpg_bypass || !fading_lpg_bypass) {
     const float hf = patch.lpg_colour;
-    const float decay_tail = (20.0f * kBlockSize) / kSampleRate *
-        SemitonesToRatio(-72.0f * patch.decay + 12.0f * hf) - short_decay;
-    
     if (modulations.level_patched) {
-      lpg_envelope_.ProcessLP(compressed_level, short_decay, decay_tail, hf);
+      lpg_envelope_.ProcessLP(
+          c.compressed_level,
+          c.short_decay,
+          c.decay_tail,
+          hf);
     } else {
       const float attack = NoteToFrequency(p.note) * float(kBlockSize) * 2.0f;
-      lpg_envelope_.ProcessPing(attack, short_decay, decay_tail, hf);
+      lpg_envelope_.ProcessPing(attack, c.short_decay, c.decay_tail, hf);
     }
   }
+  const float lpg_frequency = min(
+      lpg_envelope_.frequency() * SampleRateRatio(),
+      0.49f);
   
-  out_post_processor_.Process(
+  out_post_processor_[post_processor_index()].Process(
       pp_s.out_gain,
       lpg_bypass,
       lpg_envelope_.gain(),
-      lpg_envelope_.frequency(),
+      lpg_frequency,
       lpg_envelope_.hf_bleed(),
       out_buffer_,
       &frames->out,
       size,
       2);
 
-  aux_post_processor_.Process(
+  aux_post_processor_[post_processor_index()].Process(
       pp_s.aux_gain,
       lpg_bypass,
       lpg_envelope_.gain(),
-      lpg_envelope_.frequency(),
+      lpg_frequency,
       lpg_envelope_.hf_bleed(),
       aux_buffer_,
       &frames->aux,
       size,
       2);
+  
+#ifdef TEST
+  if (fading_engine) {
+    const PostProcessingSettings& fading_pp_s = \
+        fading_engine->post_processing_settings;
+    const int fading_index = post_processor_index_ ^ 1;
+    out_post_processor_[fading_index].Process(
+        fading_pp_s.out_gain,
+        fading_lpg_bypass,
+        lpg_envelope_.gain(),
+        lpg_frequency,
+        lpg_envelope_.hf_bleed(),
+        fading_out_buffer_,
+        &fading_frames_[0].out,
+        size,
+        2);
+    aux_post_processor_[fading_index].Process(
+        fading_pp_s.aux_gain,
+        fading_lpg_bypass,
+        lpg_envelope_.gain(),
+        lpg_frequency,
+        lpg_envelope_.hf_bleed(),
+        fading_aux_buffer_,
+        &fading_frames_[0].aux,
+        size,
+        2);
+    for (size_t i = 0; i < size; ++i) {
+      frames[i].out = Clip16(
+          static_cast<int32_t>(frames[i].out) + fading_frames_[i].out);
+      frames[i].aux = Clip16(
+          static_cast<int32_t>(frames[i].aux) + fading_frames_[i].aux);
+    }
+    
+    if (crossfade_remaining_ > size) {
+      crossfade_remaining_ -= size;
+    } else {
+      fading_engine_index_ = -1;
+    }
+  }
+#endif  // TEST
 }
   
 }  // namespace plaits
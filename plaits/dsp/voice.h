@@ -63,6 +63,36 @@ const int kMaxEngines = 16;
 const int kMaxTriggerDelay = 8;
 const int kTriggerDelay = 5;
 
+// RAM needed by the most demanding engine.
+const size_t kMaxEngineRamSize = 16384;
+
+// The engines before this one never draw numbers from stmlib::Random.
+const int kFirstNoiseEngine = 7;
+
+// Host builds keep a second set of post-processors for the engine being faded
+// out by a crossfade.
+#ifdef TEST
+const int kNumPostProcessors = 2;
+#else
+const int kNumPostProcessors = 1;
+#endif  // TEST
+
+#ifdef TEST
+// Provides RAM to voices whose engines are initialized lazily. Each engine is
+// initialized, on its first selection, with the allocator returned by
+// Acquire(), and gets to keep whatever it allocates from it. Release() is
+// called just after the engine's Init(). Acquire() must return NULL when
+// fewer than kMaxEngineRamSize bytes are free. Pools shared by voices rendered
+// from several threads must serialize Acquire()/Release().
+class EngineArenaPool {
+ public:
+  EngineArenaPool() { }
+  virtual ~EngineArenaPool() { }
+  virtual stmlib::BufferAllocator* Acquire() = 0;
+  virtual void Release() = 0;
+};
+#endif  // TEST
+
 class ChannelPostProcessor {
  public:
   ChannelPostProcessor() { }
@@ -156,17 +186,128 @@ class Voice {
     short aux;
   };
   
+  // Initializes all engines, which share the RAM of allocator (which must
+  // be at least kMaxEngineRamSize bytes): switching engines loses their state.
   void Init(stmlib::BufferAllocator* allocator);
+  
+#ifdef TEST
+  // Defers the initialization of each engine to its first selection, and
+  // gives it its own arena from pool. Engines keep their state when switching
+  // between them. If the pool is exhausted, the voice stays on the current
+  // engine (or is silent if no engine has been initialized yet).
+  void Init(EngineArenaPool* pool);
+#endif  // TEST
+  
+  // Renders at most kMaxBlockSize samples. The controls (trigger, envelopes,
+  // LPG) are processed once per call.
   void Render(
       const Patch& patch,
       const Modulations& modulations,
       Frame* frames,
       size_t size);
+  
+  // Large block mode, for hosts: renders any number of samples, processing
+  // the controls every kBlockSize samples as on the module, whatever the size
+  // of the host buffers. When size is not a multiple of kBlockSize, the last
+  // block is rendered ahead and its tail returned by the next call, so the
+  // output does not depend on how it is split into calls. Not to be mixed
+  // with Render().
+  void RenderLargeBlock(
+      const Patch& patch,
+      const Modulations& modulations,
+      Frame* frames,
+      size_t size);
+  
   inline int active_engine() const { return previous_engine_index_; }
+  
+#ifdef TEST
+  // Whether the next block rendered with these settings might use an engine
+  // drawing numbers from stmlib::Random, which is shared by all the voices of
+  // the process. Such voices must not be rendered from several threads at
+  // once. Errs on the safe side around the hysteresis of engine selection.
+  bool may_draw_noise(
+      const Patch& patch,
+      const Modulations& modulations) const;
+#endif  // TEST
+  
+  inline void set_wavetable_cache(const WavetableCache* cache) {
+#ifdef TEST
+    wavetable_cache_ = cache;
+#endif  // TEST
+    wavetable_engine_.set_cache(cache);
+  }
+  
+  inline void set_word_bank_cache(const LPCSpeechSynthWordBankCache* cache) {
+#ifdef TEST
+    word_bank_cache_ = cache;
+#endif  // TEST
+    speech_engine_.set_word_bank_cache(cache);
+  }
+  
+#ifdef TEST
+  // Crossfades over length samples when switching engines, by rendering the
+  // outgoing engine during the fade. This only happens in lazy mode, since
+  // the two engines must have their own RAM. budget is the fraction of the
+  // rendered samples for which a second engine can be rendered: engine
+  // changes are delayed until it allows a complete fade, so no more than two
+  // engines are ever rendered, and fast engine modulations are slowed down
+  // rather than adding CPU load. With a budget of 0, engines are switched
+  // abruptly.
+  inline void set_engine_crossfade(size_t length, float budget) {
+    crossfade_length_ = length;
+    crossfade_budget_ = budget;
+    crossfade_credit_ = float(length);
+  }
+  
+  inline bool engine_initialized(int index) const {
+    return initialized_engines_ & (1 << index);
+  }
+  
+  // RAM used by the engines, in bytes: the largest engine in eager mode, the
+  // total of the arenas of the engines initialized so far in lazy mode.
+  inline size_t engine_ram_usage() const { return engine_ram_usage_; }
+#endif  // TEST
     
  private:
+  void RegisterEngines();
+  void InitState();
+#ifdef TEST
+  bool InitEngine(int index);
+#endif  // TEST
   void ComputeDecayParameters(const Patch& settings);
   
+  // Index of the post-processors of the current engine.
+  inline int post_processor_index() const {
+#ifdef TEST
+    return post_processor_index_;
+#else
+    return 0;
+#endif  // TEST
+  }
+  
+  // Controls derived from the patch and modulations, which stay the same for
+  // all the blocks rendered by a call.
+  struct Controls {
+    float short_decay;
+    float decay_tail;
+    float compressed_level;
+    float accent;
+    float harmonics;
+    float speech_envelope_amplitude;
+    bool lpg_enabled;
+  };
+  
+  void ComputeControls(
+      const Patch& patch,
+      const Modulations& modulations,
+      Controls* c);
+  void RenderBlock(
+      const Patch& patch,
+      const Modulations& modulations,
+      const Controls& c,
+      Frame* frames,
+      size_t size);
+  
   inline float ApplyModulations(
       float base_value,
       float modulation_amount,
@@ -220,13 +361,41 @@ class Voice {
   float trigger_delay_line_[kMaxTriggerDelay];
   DelayLine<float, kMaxTriggerDelay> trigger_delay_;
   
-  ChannelPostProcessor out_post_processor_;
-  ChannelPostProcessor aux_post_processor_;
+  ChannelPostProcessor out_post_processor_[kNumPostProcessors];
+  ChannelPostProcessor aux_post_processor_[kNumPostProcessors];
+  
+#ifdef TEST
+  // Crossfade state. The outgoing engine uses the other set of
+  // post-processors.
+  int post_processor_index_;
+  int fading_engine_index_;
+  size_t crossfade_length_;
+  size_t crossfade_remaining_;
+  float crossfade_budget_;
+  float crossfade_credit_;
+#endif  // TEST
   
   EngineRegistry<kMaxEngines> engines_;
   
+#ifdef TEST
+  // Lazy mode. The caches are set again on the engines initialized late.
+  EngineArenaPool* arena_pool_;
+  uint32_t initialized_engines_;
+  size_t engine_ram_usage_;
+  const WavetableCache* wavetable_cache_;
+  const LPCSpeechSynthWordBankCache* word_bank_cache_;
+#endif  // TEST
+  
   float out_buffer_[kMaxBlockSize];
   float aux_buffer_[kMaxBlockSize];
+#ifdef TEST
+  float fading_out_buffer_[kMaxBlockSize];
+  float fading_aux_buffer_[kMaxBlockSize];
+  Frame fading_frames_[kMaxBlockSize];
+#endif  // TEST
+  
+  Frame pending_frames_[kBlockSize];
+  size_t num_pending_frames_;
   
   DISALLOW_COPY_AND_ASSIGN(Voice);
 };
@@ -0,0 +1,267 @@
+// Copyright 2016 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Offline rendering of parameter sweeps, one WAV file per combination of
+// parameters.
+
+#include "plaits/test/batch_renderer.h"
+
+#include <sys/time.h>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif  // __SSE__
+
+#include <algorithm>
+#include <cstdio>
+
+#include "stmlib/utils/buffer_allocator.h"
+#include "stmlib/test/wav_writer.h"
+
+#include "plaits/test/voice_bank.h"
+
+namespace plaits {
+
+using namespace std;
+using namespace stmlib;
+
+static const char* axis_names[SWEEP_AXIS_LAST] = {
+  "engine",
+  "note",
+  "harmonics",
+  "timbre",
+  "morph",
+  "decay",
+  "lpg_colour"
+};
+
+bool Sweep::Validate(string* error) const {
+  for (int i = 0; i < SWEEP_AXIS_LAST; ++i) {
+    if (axis[i].empty()) {
+      *error = string("no value for ") + axis_names[i];
+      return false;
+    }
+    float min_value = i == SWEEP_AXIS_NOTE ? -128.0f : 0.0f;
+    float max_value = i == SWEEP_AXIS_NOTE ? 256.0f : 1.0f;
+    if (i == SWEEP_AXIS_ENGINE) {
+      max_value = kMaxEngines - 1;
+    }
+    for (size_t j = 0; j < axis[i].size(); ++j) {
+      if (axis[i][j] < min_value || axis[i][j] > max_value) {
+        *error = string("out of range value for ") + axis_names[i];
+        return false;
+      }
+    }
+  }
+  if (!duration) {
+    *error = "null duration";
+    return false;
+  }
+  if (sample_rate && (sample_rate < 16000 || sample_rate > 192000)) {
+    *error = "out of range sample rate";
+    return false;
+  }
+  return true;
+}
+
+size_t Sweep::num_renders() const {
+  size_t n = 1;
+  for (int i = 0; i < SWEEP_AXIS_LAST; ++i) {
+    n *= axis[i].size();
+  }
+  return n;
+}
+
+void BatchRenderer::Init(const Sweep& sweep, size_t num_threads) {
+  sweep_ = sweep;
+  num_threads_ = num_threads;
+  CONSTRAIN(num_threads_, 1, kMaxRenderThreads);
+  elapsed_time_ = 0.0;
+  next_render_ = 0;
+  num_failed_renders_ = 0;
+  if (sweep_.sample_rate) {
+    SetSampleRate(sweep_.sample_rate);
+  }
+}
+
+void BatchRenderer::MakePatch(size_t index, Patch* patch) const {
+  // The engine varies the most slowly, so that the files of an engine are
+  // rendered - and listed - together.
+  float value[SWEEP_AXIS_LAST];
+  for (int i = SWEEP_AXIS_LAST - 1; i >= 0; --i) {
+    const vector<float>& axis = sweep_.axis[i];
+    value[i] = axis[index % axis.size()];
+    index /= axis.size();
+  }
+  patch->engine = static_cast<int>(value[SWEEP_AXIS_ENGINE] + 0.5f);
+  patch->note = value[SWEEP_AXIS_NOTE];
+  patch->harmonics = value[SWEEP_AXIS_HARMONICS];
+  patch->timbre = value[SWEEP_AXIS_TIMBRE];
+  patch->morph = value[SWEEP_AXIS_MORPH];
+  patch->frequency_modulation_amount = 0.0f;
+  patch->timbre_modulation_amount = 0.0f;
+  patch->morph_modulation_amount = 0.0f;
+  patch->decay = value[SWEEP_AXIS_DECAY];
+  patch->lpg_colour = value[SWEEP_AXIS_LPG_COLOUR];
+}
+
+bool BatchRenderer::draws_noise(size_t index) const {
+  // Each render starts from a freshly initialized voice: the engine of the
+  // patch is the only one it runs.
+  Patch patch;
+  MakePatch(index, &patch);
+  return patch.engine >= kFirstNoiseEngine;
+}
+
+string BatchRenderer::file_name(size_t index) const {
+  Patch patch;
+  MakePatch(index, &patch);
+  
+  char name[128];
+  int n = sprintf(
+      name,
+      "e%02d_n%05.1f_h%.3f_t%.3f_m%.3f",
+      patch.engine,
+      patch.note,
+      patch.harmonics,
+      patch.timbre,
+      patch.morph);
+  if (sweep_.axis[SWEEP_AXIS_DECAY].size() > 1) {
+    n += sprintf(name + n, "_d%.3f", patch.decay);
+  }
+  if (sweep_.axis[SWEEP_AXIS_LPG_COLOUR].size() > 1) {
+    n += sprintf(name + n, "_c%.3f", patch.lpg_colour);
+  }
+  return sweep_.prefix + name + ".wav";
+}
+
+bool BatchRenderer::Render(size_t index, Voice* voice, char* ram) {
+  // Each render starts from a freshly initialized voice, so that its output
+  // does not depend on what was previously rendered by the thread.
+  BufferAllocator allocator(ram, kMaxEngineRamSize);
+  voice->Init(&allocator);
+  voice->set_wavetable_cache(SharedWavetableCache());
+  voice->set_word_bank_cache(SharedWordBankCache());
+  
+  Patch patch;
+  MakePatch(index, &patch);
+  
+  Modulations modulations = Modulations();
+  modulations.level = 1.0f;
+  modulations.trigger_patched = sweep_.trigger_length != 0;
+  
+  WavWriter wav_writer(2, SampleRate(), sweep_.duration);
+  if (!wav_writer.Open(file_name(index).c_str())) {
+    fprintf(stderr, "Cannot write %s\n", file_name(index).c_str());
+    return false;
+  }
+  
+  const size_t num_samples = sweep_.duration * SampleRate();
+  Voice::Frame frames[kRenderBufferSize];
+  for (size_t i = 0; i < num_samples; ) {
+    size_t size = min(kRenderBufferSize, num_samples - i);
+    if (i < sweep_.trigger_length) {
+      size = min(size, sweep_.trigger_length - i);
+      modulations.trigger = 1.0f;
+    } else {
+      modulations.trigger = 0.0f;
+    }
+    voice->RenderLargeBlock(patch, modulations, frames, size);
+    wav_writer.WriteFrames(&frames[0].out, size);
+    i += size;
+  }
+  return true;
+}
+
+/* static */
+void* BatchRenderer::WorkerEntryPoint(void* renderer) {
+  static_cast<BatchRenderer*>(renderer)->Worker();
+  return NULL;
+}
+
+void BatchRenderer::Worker() {
+#ifdef __SSE__
+  // The floating point environment is per-thread.
+  _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
+#endif  // __SSE__
+  
+  Voice* voice = new Voice;
+  char* ram = new char[kMaxEngineRamSize];
+  const size_t num_renders = sweep_.num_renders();
+  while (true) {
+    size_t index = __sync_fetch_and_add(&next_render_, 1);
+    if (index >= num_renders) {
+      break;
+    }
+    if (!draws_noise(index) && !Render(index, voice, ram)) {
+      __sync_fetch_and_add(&num_failed_renders_, 1);
+    }
+  }
+  delete[] ram;
+  delete voice;
+}
+
+void BatchRenderer::RenderNoiseEngines() {
+  Voice* voice = new Voice;
+  char* ram = new char[kMaxEngineRamSize];
+  const size_t num_renders = sweep_.num_renders();
+  for (size_t index = 0; index < num_renders; ++index) {
+    if (draws_noise(index) && !Render(index, voice, ram)) {
+      ++num_failed_renders_;
+    }
+  }
+  delete[] ram;
+  delete voice;
+}
+
+static double Now() {
+  timeval t;
+  gettimeofday(&t, NULL);
+  return t.tv_sec + t.tv_usec * 1e-6;
+}
+
+void BatchRenderer::Run() {
+  double start = Now();
+  next_render_ = 0;
+  num_failed_renders_ = 0;
+  
+  pthread_t workers[kMaxRenderThreads];
+  size_t num_workers = 0;
+  while (num_workers < num_threads_ - 1) {
+    if (pthread_create(&workers[num_workers], NULL, &WorkerEntryPoint, this)) {
+      // Carry on with the threads we have.
+      break;
+    }
+    ++num_workers;
+  }
+  Worker();
+  for (size_t i = 0; i < num_workers; ++i) {
+    pthread_join(workers[i], NULL);
+  }
+  RenderNoiseEngines();
+  elapsed_time_ = Now() - start;
+}
+
+}  // namespace plaits
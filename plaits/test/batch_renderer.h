@@ -0,0 +1,132 @@
+// Copyright 2016 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Offline rendering of parameter sweeps, one WAV file per combination of
+// parameters. Host only - this is not built into the firmware.
+
+#ifndef PLAITS_TEST_BATCH_RENDERER_H_
+#define PLAITS_TEST_BATCH_RENDERER_H_
+
+#include <pthread.h>
+
+#include <string>
+#include <vector>
+
+#include "stmlib/stmlib.h"
+
+#include "plaits/dsp/voice.h"
+
+namespace plaits {
+
+const size_t kMaxRenderThreads = 64;
+const size_t kRenderBufferSize = 256;
+
+enum SweepAxis {
+  SWEEP_AXIS_ENGINE,
+  SWEEP_AXIS_NOTE,
+  SWEEP_AXIS_HARMONICS,
+  SWEEP_AXIS_TIMBRE,
+  SWEEP_AXIS_MORPH,
+  SWEEP_AXIS_DECAY,
+  SWEEP_AXIS_LPG_COLOUR,
+  SWEEP_AXIS_LAST
+};
+
+struct Sweep {
+  // Each render uses one value from each axis: the number of renders is the
+  // product of the sizes of the axes.
+  std::vector<float> axis[SWEEP_AXIS_LAST];
+  
+  // Length of each render, in seconds.
+  size_t duration;
+  
+  // Length of the trigger pulse sent at the beginning of each render, in
+  // samples. With 0, the trigger input is left unpatched and the engines are
+  // free-running.
+  size_t trigger_length;
+  
+  // In Hz. With 0, the voices run at the rate of the module.
+  size_t sample_rate;
+  
+  // Prepended to the name of each file. Can include a directory.
+  std::string prefix;
+  
+  // Returns false and sets error if an axis is empty or out of range.
+  bool Validate(std::string* error) const;
+  
+  size_t num_renders() const;
+};
+
+class BatchRenderer {
+ public:
+  BatchRenderer() { }
+  ~BatchRenderer() { }
+  
+  // num_threads counts the calling thread. Sets the sample rate of the whole
+  // process (see SetSampleRate()).
+  void Init(const Sweep& sweep, size_t num_threads);
+  
+  // Renders the whole sweep. Renders are distributed across the threads, and
+  // each of them is streamed to its file block by block: the memory usage does
+  // not depend on the size of the sweep or on the duration of the renders.
+  // The state of stmlib::Random is global: the renders of the engines drawing
+  // from it are done one after the other on the calling thread, once the
+  // other renders are complete. Their output does not depend on the number of
+  // threads. A file that cannot be written is reported on stderr and counted
+  // in num_failed_renders().
+  void Run();
+  
+  // Name of the file written for render index.
+  std::string file_name(size_t index) const;
+  
+  // Wall-clock duration of the last Run(), in seconds.
+  inline double elapsed_time() const { return elapsed_time_; }
+  inline size_t num_renders() const { return sweep_.num_renders(); }
+  inline size_t num_threads() const { return num_threads_; }
+  inline size_t num_failed_renders() const { return num_failed_renders_; }
+  
+ private:
+  static void* WorkerEntryPoint(void* renderer);
+  void Worker();
+  void RenderNoiseEngines();
+  void MakePatch(size_t index, Patch* patch) const;
+  bool draws_noise(size_t index) const;
+  bool Render(size_t index, Voice* voice, char* ram);
+  
+  Sweep sweep_;
+  size_t num_threads_;
+  double elapsed_time_;
+  
+  // Renders are claimed, and failures counted, with an atomic increment.
+  volatile size_t next_render_;
+  volatile size_t num_failed_renders_;
+  
+  DISALLOW_COPY_AND_ASSIGN(BatchRenderer);
+};
+
+}  // namespace plaits
+
+#endif  // PLAITS_TEST_BATCH_RENDERER_H_
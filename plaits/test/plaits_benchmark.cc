@@ -0,0 +1,307 @@
+// Copyright 2016 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Measures the cost of each engine of the voice, block by block, over a grid
+// of parameters.
+//
+// Usage: plaits_benchmark [key=value ...]
+//
+// engine: comma-separated list of engines, all by default.
+// duration: time spent at each point of the grid, in seconds.
+// block: block size, in samples.
+// passes: number of times the whole grid is rendered.
+// format: text for a table, csv for one line per engine with a header.
+//
+// Each engine is rendered through the voice, post-processing included, for
+// all the combinations of 3 notes and 3 values of harmonics, timbre and morph,
+// with a trigger at the beginning of each point of the grid. The time of each
+// block is the shortest of all passes, which filters out the interruptions of
+// the host OS but keeps the blocks that are genuinely expensive. It is
+// corrected for the cost of reading the clock.
+
+#include <time.h>
+#include <xmmintrin.h>
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "stmlib/utils/buffer_allocator.h"
+
+#include "plaits/dsp/voice.h"
+
+using namespace std;
+using namespace stmlib;
+using namespace plaits;
+
+const char* engine_names[kMaxEngines] = {
+  "virtual_analog",
+  "waveshaping",
+  "fm",
+  "grain",
+  "additive",
+  "wavetable",
+  "chord",
+  "speech",
+  "swarm",
+  "noise",
+  "particle",
+  "string",
+  "modal",
+  "bass_drum",
+  "snare_drum",
+  "hi_hat"
+};
+
+const float grid_notes[] = { 36.0f, 60.0f, 84.0f };
+const float grid_values[] = { 0.0f, 0.5f, 1.0f };
+const size_t kGridSize = 3;
+
+// Percentiles of the block time reported for each engine.
+const float percentiles[] = { 50.0f, 90.0f, 99.0f, 99.9f };
+const size_t kNumPercentiles = sizeof(percentiles) / sizeof(float);
+
+char ram_block[kMaxEngineRamSize];
+
+inline int64_t Now() {
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return int64_t(t.tv_sec) * 1000000000 + t.tv_nsec;
+}
+
+int64_t ClockOverhead() {
+  vector<int64_t> samples;
+  for (int i = 0; i < 1001; ++i) {
+    int64_t start = Now();
+    samples.push_back(Now() - start);
+  }
+  sort(samples.begin(), samples.end());
+  return samples[samples.size() / 2];
+}
+
+struct EngineStats {
+  double ns_per_sample;
+  int64_t worst_block;
+  int64_t percentile[kNumPercentiles];
+  size_t num_blocks;
+};
+
+void RenderGrid(
+    int engine,
+    size_t num_blocks,
+    size_t block_size,
+    int64_t clock_overhead,
+    vector<int64_t>* block_time) {
+  Voice voice;
+  BufferAllocator allocator(ram_block, kMaxEngineRamSize);
+  voice.Init(&allocator);
+  
+  Patch patch = Patch();
+  patch.engine = engine;
+  patch.decay = 0.5f;
+  patch.lpg_colour = 0.5f;
+  Modulations modulations = Modulations();
+  modulations.trigger_patched = true;
+  
+  vector<int64_t>::iterator t_min = block_time->begin();
+  for (size_t n = 0; n < kGridSize; ++n) {
+    for (size_t h = 0; h < kGridSize; ++h) {
+      for (size_t t = 0; t < kGridSize; ++t) {
+        for (size_t m = 0; m < kGridSize; ++m) {
+          patch.note = grid_notes[n];
+          patch.harmonics = grid_values[h];
+          patch.timbre = grid_values[t];
+          patch.morph = grid_values[m];
+          for (size_t i = 0; i < num_blocks; ++i) {
+            modulations.trigger = i == 0 ? 1.0f : 0.0f;
+            Voice::Frame frames[kMaxBlockSize];
+            int64_t start = Now();
+            voice.Render(patch, modulations, frames, block_size);
+            int64_t elapsed = max(Now() - start - clock_overhead, int64_t(0));
+            *t_min = min(*t_min, elapsed);
+            ++t_min;
+          }
+        }
+      }
+    }
+  }
+}
+
+void BenchmarkEngine(
+    int engine,
+    float duration,
+    size_t block_size,
+    size_t num_passes,
+    int64_t clock_overhead,
+    EngineStats* stats) {
+  const size_t num_blocks = size_t(duration * kSampleRate) / block_size;
+  const size_t num_points = kGridSize * kGridSize * kGridSize * kGridSize;
+  vector<int64_t> block_time(
+      num_points * num_blocks,
+      numeric_limits<int64_t>::max());
+  for (size_t i = 0; i < num_passes; ++i) {
+    RenderGrid(engine, num_blocks, block_size, clock_overhead, &block_time);
+  }
+  
+  int64_t total = 0;
+  for (size_t i = 0; i < block_time.size(); ++i) {
+    total += block_time[i];
+  }
+  stats->num_blocks = block_time.size();
+  stats->ns_per_sample = double(total) / (block_time.size() * block_size);
+  sort(block_time.begin(), block_time.end());
+  stats->worst_block = block_time.back();
+  for (size_t i = 0; i < kNumPercentiles; ++i) {
+    size_t rank = size_t(percentiles[i] / 100.0f * (block_time.size() - 1));
+    stats->percentile[i] = block_time[rank];
+  }
+}
+
+int main(int argc, char** argv) {
+  _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
+  
+  vector<int> engines;
+  float duration = 0.25f;
+  size_t block_size = 12;
+  size_t num_passes = 3;
+  string format = "text";
+  
+  for (int i = 1; i < argc; ++i) {
+    string setting(argv[i]);
+    size_t equal = setting.find('=');
+    string key = setting.substr(0, equal);
+    const char* value = argv[i] + equal + 1;
+    if (equal == string::npos) {
+      key = "";
+    }
+    if (key == "engine") {
+      for (char* s = const_cast<char*>(value); *s; ) {
+        engines.push_back(strtol(s, &s, 10));
+        if (*s == ',') {
+          ++s;
+        }
+      }
+    } else if (key == "duration") {
+      duration = atof(value);
+    } else if (key == "block") {
+      block_size = atoi(value);
+    } else if (key == "passes") {
+      num_passes = atoi(value);
+    } else if (key == "format") {
+      format = value;
+    } else {
+      fprintf(stderr, "Invalid setting %s\n", argv[i]);
+      return 1;
+    }
+  }
+  if (engines.empty()) {
+    for (size_t i = 0; i < kMaxEngines; ++i) {
+      engines.push_back(i);
+    }
+  }
+  for (size_t i = 0; i < engines.size(); ++i) {
+    if (engines[i] < 0 || engines[i] >= int(kMaxEngines)) {
+      fprintf(stderr, "Invalid engine %d\n", engines[i]);
+      return 1;
+    }
+  }
+  if (block_size < 1 || block_size > kMaxBlockSize ||
+      size_t(duration * kSampleRate) < block_size || num_passes < 1) {
+    fprintf(stderr, "Invalid block size, duration or number of passes\n");
+    return 1;
+  }
+  if (format != "text" && format != "csv") {
+    fprintf(stderr, "Invalid format %s\n", format.c_str());
+    return 1;
+  }
+  const bool csv = format == "csv";
+  
+  const int64_t clock_overhead = ClockOverhead();
+  const double block_duration = 1e9 * block_size / kSampleRate;
+  
+  if (csv) {
+    printf("engine,name,block_size,num_blocks,ns_per_sample,worst_block_ns");
+    for (size_t i = 0; i < kNumPercentiles; ++i) {
+      printf(",p%g_ns", percentiles[i]);
+    }
+    printf("\n");
+  } else {
+    printf(
+        "block: %lu samples (%.0fns), passes: %lu, clock overhead: %ldns\n\n",
+        static_cast<unsigned long>(block_size),
+        block_duration,
+        static_cast<unsigned long>(num_passes),
+        static_cast<long>(clock_overhead));
+    printf("   engine            ns/sample    worst ns (block)");
+    for (size_t i = 0; i < kNumPercentiles; ++i) {
+      char label[16];
+      sprintf(label, "p%g", percentiles[i]);
+      printf("  %6s", label);
+    }
+    printf("\n");
+  }
+  
+  for (size_t i = 0; i < engines.size(); ++i) {
+    EngineStats s;
+    BenchmarkEngine(
+        engines[i],
+        duration,
+        block_size,
+        num_passes,
+        clock_overhead,
+        &s);
+    if (csv) {
+      printf("%d,%s,%lu,%lu,%.2f,%ld",
+          engines[i],
+          engine_names[engines[i]],
+          static_cast<unsigned long>(block_size),
+          static_cast<unsigned long>(s.num_blocks),
+          s.ns_per_sample,
+          static_cast<long>(s.worst_block));
+      for (size_t j = 0; j < kNumPercentiles; ++j) {
+        printf(",%ld", static_cast<long>(s.percentile[j]));
+      }
+      printf("\n");
+    } else {
+      printf("%2d %-16s %12.2f %11ld (%3.0f%%)",
+          engines[i],
+          engine_names[engines[i]],
+          s.ns_per_sample,
+          static_cast<long>(s.worst_block),
+          100.0 * s.worst_block / block_duration);
+      for (size_t j = 0; j < kNumPercentiles; ++j) {
+        printf("  %6ld", static_cast<long>(s.percentile[j]));
+      }
+      printf("\n");
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,248 @@
+// Copyright 2016 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Renders parameter sweeps into WAV files, on all cores.
+//
+// Usage: plaits_render [spec file] [key=value ...]
+//
+// engine, note, harmonics, timbre, morph, decay, lpg_colour: a single value,
+//   a comma-separated list of values, start:stop (unit steps) or
+//   start:stop:count (count evenly spaced values, bounds included).
+// duration: length of each render, in seconds.
+// trigger: length of the trigger pulse at the beginning of each render, in
+//   samples. 0 leaves the trigger unpatched.
+// sample_rate: in Hz. By default, the rate of the module (48kHz, with the
+//   tuning correction for its clock).
+// threads: number of threads, all cores by default.
+// prefix: prepended to the name of each file. Can include a directory.
+//
+// A spec file contains the same key=value pairs, one per line, with # for
+// comments. The arguments that follow it override its settings.
+//
+// Example: plaits_render engine=0:15 note=36:84:5 timbre=0:1:9 prefix=out/
+
+#include <unistd.h>
+#include <xmmintrin.h>
+
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "plaits/test/batch_renderer.h"
+
+using namespace std;
+using namespace plaits;
+
+// Bounds the memory used by a range before Sweep::Validate() gets to see it.
+const int kMaxAxisSize = 1024;
+
+bool ParseAxis(const char* s, vector<float>* values) {
+  values->clear();
+  float start, stop;
+  int count;
+  char trailing;
+  if (sscanf(s, "%f:%f:%d%c", &start, &stop, &count, &trailing) == 3) {
+    if (count < 1 || count > kMaxAxisSize) {
+      return false;
+    }
+    for (int i = 0; i < count; ++i) {
+      float x = count == 1 ? 0.0f : float(i) / float(count - 1);
+      values->push_back(start + (stop - start) * x);
+    }
+    return true;
+  } else if (sscanf(s, "%f:%f%c", &start, &stop, &trailing) == 2) {
+    // Also rejects the ranges with a NaN or infinite bound.
+    float span = stop - start + 1e-3f;
+    if (!(span >= 0.0f && span < kMaxAxisSize)) {
+      return false;
+    }
+    count = static_cast<int>(span) + 1;
+    for (int i = 0; i < count; ++i) {
+      values->push_back(start + float(i));
+    }
+    return true;
+  }
+  
+  while (true) {
+    char* end;
+    values->push_back(strtof(s, &end));
+    if (end == s) {
+      return false;
+    }
+    if (*end == '\0') {
+      return true;
+    } else if (*end != ',') {
+      return false;
+    }
+    s = end + 1;
+  }
+}
+
+// Non-negative integer, with nothing after it.
+bool ParseCount(const char* s, size_t* value) {
+  char* end;
+  errno = 0;
+  long x = strtol(s, &end, 10);
+  if (end == s || *end != '\0' || errno == ERANGE || x < 0) {
+    return false;
+  }
+  *value = static_cast<size_t>(x);
+  return true;
+}
+
+bool ParseSetting(
+    const string& setting,
+    Sweep* sweep,
+    size_t* num_threads) {
+  size_t equal = setting.find('=');
+  if (equal == string::npos) {
+    return false;
+  }
+  string key = setting.substr(0, equal);
+  string value = setting.substr(equal + 1);
+  const char* s = value.c_str();
+  
+  static const char* axis_keys[SWEEP_AXIS_LAST] = {
+    "engine", "note", "harmonics", "timbre", "morph", "decay", "lpg_colour"
+  };
+  for (int i = 0; i < SWEEP_AXIS_LAST; ++i) {
+    if (key == axis_keys[i]) {
+      return ParseAxis(s, &sweep->axis[i]);
+    }
+  }
+  if (key == "duration") {
+    return ParseCount(s, &sweep->duration);
+  } else if (key == "trigger") {
+    return ParseCount(s, &sweep->trigger_length);
+  } else if (key == "sample_rate") {
+    return ParseCount(s, &sweep->sample_rate);
+  } else if (key == "threads") {
+    return ParseCount(s, num_threads);
+  } else if (key == "prefix") {
+    sweep->prefix = value;
+    return true;
+  }
+  return false;
+}
+
+bool ParseSpecFile(const char* file_name, Sweep* sweep, size_t* num_threads) {
+  FILE* fp = fopen(file_name, "r");
+  if (!fp) {
+    fprintf(stderr, "Cannot open %s\n", file_name);
+    return false;
+  }
+  bool success = true;
+  char line[1024];
+  for (int n = 1; fgets(line, sizeof(line), fp); ++n) {
+    string setting(line);
+    setting = setting.substr(0, setting.find('#'));
+    // Remove whitespace.
+    string stripped;
+    for (size_t i = 0; i < setting.size(); ++i) {
+      if (!isspace(setting[i])) {
+        stripped += setting[i];
+      }
+    }
+    if (!stripped.empty() && !ParseSetting(stripped, sweep, num_threads)) {
+      fprintf(stderr, "%s:%d: invalid setting %s\n", file_name, n,
+          stripped.c_str());
+      success = false;
+    }
+  }
+  fclose(fp);
+  return success;
+}
+
+int main(int argc, char** argv) {
+  _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
+  
+  Sweep sweep;
+  ParseAxis("0:15", &sweep.axis[SWEEP_AXIS_ENGINE]);
+  ParseAxis("48", &sweep.axis[SWEEP_AXIS_NOTE]);
+  ParseAxis("0.5", &sweep.axis[SWEEP_AXIS_HARMONICS]);
+  ParseAxis("0.5", &sweep.axis[SWEEP_AXIS_TIMBRE]);
+  ParseAxis("0.5", &sweep.axis[SWEEP_AXIS_MORPH]);
+  ParseAxis("0.5", &sweep.axis[SWEEP_AXIS_DECAY]);
+  ParseAxis("0.5", &sweep.axis[SWEEP_AXIS_LPG_COLOUR]);
+  sweep.duration = 2;
+  sweep.trigger_length = 48;
+  sweep.sample_rate = 0;
+  sweep.prefix = "plaits_";
+  size_t num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  
+  for (int i = 1; i < argc; ++i) {
+    if (!strchr(argv[i], '=')) {
+      if (!ParseSpecFile(argv[i], &sweep, &num_threads)) {
+        return 1;
+      }
+    } else if (!ParseSetting(argv[i], &sweep, &num_threads)) {
+      fprintf(stderr, "Invalid setting %s\n", argv[i]);
+      return 1;
+    }
+  }
+  
+  string error;
+  if (!sweep.Validate(&error)) {
+    fprintf(stderr, "Invalid sweep: %s\n", error.c_str());
+    return 1;
+  }
+  
+  BatchRenderer renderer;
+  renderer.Init(sweep, num_threads);
+  
+  // Fail early rather than after rendering everything to nowhere. The files
+  // that still cannot be written are reported by Run().
+  FILE* probe = fopen(renderer.file_name(0).c_str(), "wb");
+  if (!probe) {
+    fprintf(stderr, "Cannot write %s\n", renderer.file_name(0).c_str());
+    return 1;
+  }
+  fclose(probe);
+  
+  renderer.Run();
+  if (renderer.num_failed_renders()) {
+    fprintf(stderr, "%lu of %lu files could not be written\n",
+        static_cast<unsigned long>(renderer.num_failed_renders()),
+        static_cast<unsigned long>(renderer.num_renders()));
+    return 1;
+  }
+  
+  const double t = renderer.elapsed_time();
+  const size_t n = renderer.num_renders();
+  printf(
+      "%lu renders of %lus on %lu threads in %.2fs: %.1f renders/s, "
+      "%.0fx real time\n",
+      static_cast<unsigned long>(n),
+      static_cast<unsigned long>(sweep.duration),
+      static_cast<unsigned long>(renderer.num_threads()),
+      t,
+      n / t,
+      n * sweep.duration / t);
+  return 0;
+}
@@ -18,6 +18,8 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
+#include <vector>
 #include <xmmintrin.h>
 
 #include "plaits/dsp/dsp.h"
@@ -37,6 +39,7 @@
 #include "plaits/dsp/engine/swarm_engine.h"
 #include "plaits/dsp/engine/virtual_analog_engine.h"
 #include "plaits/dsp/engine/waveshaping_engine.h"
+#include "plaits/dsp/engine/wavetable_cache.h"
 #include "plaits/dsp/engine/wavetable_engine.h"
 
 #include "plaits/dsp/fx/sample_rate_reducer.h"
@@ -45,15 +48,22 @@
 #include "plaits/dsp/oscillator/grainlet_oscillator.h"
 #include "plaits/dsp/oscillator/harmonic_oscillator.h"
 #include "plaits/dsp/oscillator/oscillator.h"
+#include "plaits/dsp/oscillator/oscillator_bank.h"
 #include "plaits/dsp/oscillator/string_synth_oscillator.h"
+#include "plaits/dsp/oscillator/string_synth_oscillator_bank.h"
 #include "plaits/dsp/oscillator/variable_saw_oscillator.h"
 #include "plaits/dsp/oscillator/variable_shape_oscillator.h"
 #include "plaits/dsp/oscillator/vosim_oscillator.h"
+#include "plaits/dsp/oscillator/wavetable_oscillator_bank.h"
 #include "plaits/dsp/oscillator/z_oscillator.h"
 
+#include "plaits/dsp/speech/lpc_speech_synth_words.h"
+
 #include "plaits/dsp/voice.h"
+#include "plaits/test/voice_bank.h"
 
 #include "stmlib/test/wav_writer.h"
+#include "stmlib/utils/random.h"
 
 using namespace std;
 using namespace stmlib;
@@ -79,6 +89,73 @@ void TestOscillator() {
   }
 }
 
+template<OscillatorShape shape>
+void CompareOscillatorBank(const char* name) {
+  const size_t kNumOscillators = 8;
+  const size_t kDuration = 10;
+  
+  Oscillator osc[kNumOscillators];
+  OscillatorBank<kNumOscillators> bank;
+  bank.Init();
+  for (size_t i = 0; i < kNumOscillators; ++i) {
+    osc[i].Init();
+  }
+  
+  float frequency[kNumOscillators];
+  float pw[kNumOscillators];
+  float max_error = 0.0f;
+  double scalar_time = 0.0;
+  double bank_time = 0.0;
+  
+  for (size_t i = 0; i < kSampleRate * kDuration; i += kAudioBlockSize) {
+    for (size_t j = 0; j < kNumOscillators; ++j) {
+      float detune = 1.0f + 0.01f * j * (1.0f + sinf(i * 0.0001f));
+      frequency[j] = (20.0f + 2000.0f * (i % 48000) / 48000.0f) * \
+          detune / kSampleRate;
+      pw[j] = 0.5f + 0.4f * sinf(i * 0.00003f * (j + 1));
+    }
+    
+    float scalar_out[kNumOscillators][kAudioBlockSize];
+    clock_t start = clock();
+    for (size_t j = 0; j < kNumOscillators; ++j) {
+      osc[j].Render<shape>(
+          frequency[j], pw[j], scalar_out[j], kAudioBlockSize);
+    }
+    scalar_time += clock() - start;
+    
+    float bank_out[kAudioBlockSize * kNumOscillators];
+    start = clock();
+    bank.template Render<shape>(frequency, pw, bank_out, kAudioBlockSize);
+    bank_time += clock() - start;
+    
+    for (size_t j = 0; j < kNumOscillators; ++j) {
+      for (size_t k = 0; k < kAudioBlockSize; ++k) {
+        float error = fabsf(
+            scalar_out[j][k] - bank_out[k * kNumOscillators + j]);
+        max_error = max(max_error, error);
+      }
+    }
+  }
+  double num_samples = kSampleRate * kDuration * kNumOscillators;
+  printf(
+      "%s\tscalar: %.1f Msamples/s\tbank: %.1f Msamples/s\terror: %g\n",
+      name,
+      num_samples / (scalar_time / CLOCKS_PER_SEC) / 1e6,
+      num_samples / (bank_time / CLOCKS_PER_SEC) / 1e6,
+      max_error);
+}
+
+void BenchmarkOscillatorBank() {
+  CompareOscillatorBank<OSCILLATOR_SHAPE_IMPULSE_TRAIN>("impulse");
+  CompareOscillatorBank<OSCILLATOR_SHAPE_SAW>("saw");
+  CompareOscillatorBank<OSCILLATOR_SHAPE_TRIANGLE>("triangle");
+  CompareOscillatorBank<OSCILLATOR_SHAPE_SLOPE>("slope");
+  CompareOscillatorBank<OSCILLATOR_SHAPE_SQUARE>("square");
+  CompareOscillatorBank<OSCILLATOR_SHAPE_SQUARE_BRIGHT>("bright");
+  CompareOscillatorBank<OSCILLATOR_SHAPE_SQUARE_DARK>("dark");
+  CompareOscillatorBank<OSCILLATOR_SHAPE_SQUARE_TRIANGLE>("sqrtri");
+}
+
 void TestVariableShapeOscillator() {
   WavWriter wav_writer(1, kSampleRate, 20);
   wav_writer.Open("plaits_slave_oscillator.wav");
@@ -284,6 +361,139 @@ void TestChordEngine() {
   }
 }
 
+void BenchmarkChordBanks() {
+  const size_t kNumOscillators = 8;
+  const size_t kDuration = 10;
+  
+  StringSynthOscillator divide_down[kNumOscillators];
+  WavetableOscillator<256, 15> wavetable[kNumOscillators];
+  StringSynthOscillatorBank<kNumOscillators> divide_down_bank;
+  WavetableOscillatorBank<256, 15, kNumOscillators> wavetable_bank;
+  for (size_t i = 0; i < kNumOscillators; ++i) {
+    divide_down[i].Init();
+    wavetable[i].Init();
+  }
+  divide_down_bank.Init();
+  wavetable_bank.Init();
+  
+  const int16_t* waves[15];
+  for (size_t i = 0; i < 15; ++i) {
+    waves[i] = &wav_integrated_waves[(128 + 32 + i) * 260];
+  }
+  
+  float frequency[kNumOscillators];
+  float amplitude[kNumOscillators];
+  float route[kNumOscillators];
+  float registration[7];
+  float max_error = 0.0f;
+  double scalar_time[2] = { 0.0, 0.0 };
+  double bank_time[2] = { 0.0, 0.0 };
+  
+  for (size_t i = 0; i < kSampleRate * kDuration; i += kAudioBlockSize) {
+    for (size_t j = 0; j < kNumOscillators; ++j) {
+      frequency[j] = (30.0f + 3000.0f * (i % 96000) / 96000.0f) * \
+          (1.0f + 0.25f * j) / kSampleRate;
+      amplitude[j] = 0.25f * (1.0f + sinf(i * 0.00001f * (j + 1)));
+      route[j] = j & 1 ? 1.0f : 0.0f;
+    }
+    for (size_t j = 0; j < 7; ++j) {
+      registration[j] = 0.5f + 0.5f * sinf(i * 0.00002f * (j + 1));
+    }
+    const float waveform = 0.5f + 0.5f * sinf(i * 0.00003f);
+    
+    float scalar_out[2][kAudioBlockSize];
+    fill(&scalar_out[0][0], &scalar_out[0][0] + 2 * kAudioBlockSize, 0.0f);
+    clock_t start = clock();
+    for (size_t j = 0; j < kNumOscillators; ++j) {
+      wavetable[j].Render(
+          frequency[j] * 1.004f, amplitude[j], waveform, waves,
+          scalar_out[j & 1], kAudioBlockSize);
+    }
+    scalar_time[0] += clock() - start;
+    start = clock();
+    for (size_t j = 0; j < kNumOscillators; ++j) {
+      divide_down[j].Render(
+          frequency[j], registration, amplitude[j],
+          scalar_out[j & 1], kAudioBlockSize);
+    }
+    scalar_time[1] += clock() - start;
+    
+    float bank_out[2][kAudioBlockSize];
+    float wavetable_frequency[kNumOscillators];
+    for (size_t j = 0; j < kNumOscillators; ++j) {
+      wavetable_frequency[j] = frequency[j] * 1.004f;
+    }
+    fill(&bank_out[0][0], &bank_out[0][0] + 2 * kAudioBlockSize, 0.0f);
+    start = clock();
+    wavetable_bank.Render(
+        kNumOscillators, wavetable_frequency, amplitude, waveform, waves,
+        route, bank_out[0], bank_out[1], kAudioBlockSize);
+    bank_time[0] += clock() - start;
+    start = clock();
+    divide_down_bank.Render(
+        kNumOscillators, frequency, registration, amplitude,
+        route, bank_out[0], bank_out[1], kAudioBlockSize);
+    bank_time[1] += clock() - start;
+    
+    for (size_t j = 0; j < 2; ++j) {
+      for (size_t k = 0; k < kAudioBlockSize; ++k) {
+        max_error = max(max_error, fabsf(scalar_out[j][k] - bank_out[j][k]));
+      }
+    }
+  }
+  double num_samples = kSampleRate * kDuration * kNumOscillators;
+  const char* name[2] = { "wavetable", "divide-down" };
+  for (size_t j = 0; j < 2; ++j) {
+    printf(
+        "%s\tscalar: %.1f Msamples/s\tbank: %.1f Msamples/s\n",
+        name[j],
+        num_samples / (scalar_time[j] / CLOCKS_PER_SEC) / 1e6,
+        num_samples / (bank_time[j] / CLOCKS_PER_SEC) / 1e6);
+  }
+  printf("error: %g\n", max_error);
+}
+
+void BenchmarkChordEngine() {
+  const size_t kDuration = 10;
+  
+  for (int num_layers = 1; num_layers <= kChordMaxNumLayers; ++num_layers) {
+    WavWriter wav_writer(2, kSampleRate, kDuration);
+    char name[64];
+    sprintf(name, "plaits_chord_engine_%d_layers.wav", num_layers);
+    wav_writer.Open(name);
+    
+    BufferAllocator allocator(ram_block, 16384);
+    ChordEngine e;
+    e.Init(&allocator);
+    e.set_chord_table(CHORD_TABLE_EXTENDED);
+    e.set_num_layers(num_layers);
+    e.Reset();
+    
+    EngineParameters p;
+    p.trigger = TRIGGER_LOW;
+    p.note = 48.0f;
+    
+    double time = 0.0;
+    for (size_t i = 0; i < kSampleRate * kDuration; i += kAudioBlockSize) {
+      float out[kAudioBlockSize];
+      float aux[kAudioBlockSize];
+      p.harmonics = wav_writer.triangle(7);
+      p.morph = wav_writer.triangle(3);
+      p.timbre = wav_writer.triangle(5);
+      bool already_enveloped;
+      clock_t start = clock();
+      e.Render(p, out, aux, kAudioBlockSize, &already_enveloped);
+      time += clock() - start;
+      wav_writer.Write(out, aux, kAudioBlockSize);
+    }
+    printf(
+        "%d voices: %.3fs for %ds of audio\n",
+        num_layers * kChordNumVoices,
+        time / CLOCKS_PER_SEC,
+        int(kDuration));
+  }
+}
+
 void TestFMEngine() {
   WavWriter wav_writer(2, kSampleRate, 80);
   wav_writer.Open("plaits_fm_engine.wav");
@@ -444,6 +654,73 @@ void TestSpeechEngine() {
   }
 }
 
+void TestLPCSpeechSynthWordBankCache() {
+  const size_t kNumVoices = LPC_SPEECH_SYNTH_NUM_WORD_BANKS;
+  const size_t kDuration = 20;
+  
+  static LPCSpeechSynth::Frame storage[kLPCSpeechSynthWordBankCacheSize];
+  LPCSpeechSynthWordBankCache cache;
+  if (!cache.Init(word_banks_, LPC_SPEECH_SYNTH_NUM_WORD_BANKS, storage)) {
+    printf("Cannot initialize the cache\n");
+    return;
+  }
+  
+  // Voice v says the words of bank v, decoded from ROM or read from the
+  // cache.
+  static char ram[kNumVoices][16384];
+  static LPCSpeechSynthWordBank rom_word_bank[kNumVoices];
+  static LPCSpeechSynthWordBank cached_word_bank[kNumVoices];
+  static LPCSpeechSynthController rom[kNumVoices];
+  static LPCSpeechSynthController cached[kNumVoices];
+  for (size_t v = 0; v < kNumVoices; ++v) {
+    BufferAllocator allocator(ram[v], 16384);
+    rom_word_bank[v].Init(
+        word_banks_,
+        LPC_SPEECH_SYNTH_NUM_WORD_BANKS,
+        &allocator);
+    cached_word_bank[v].Init(&cache);
+    rom[v].Init(&rom_word_bank[v]);
+    cached[v].Init(&cached_word_bank[v]);
+  }
+  
+  size_t num_errors = 0;
+  for (size_t i = 0; i < kSampleRate * kDuration; i += kBlockSize) {
+    for (size_t v = 0; v < kNumVoices; ++v) {
+      const bool trigger = i % (kBlockSize * (2000 + 100 * v)) == 0;
+      const float address = float(i) / (kSampleRate * kDuration);
+      const float frequency = NoteToFrequency(36.0f + 2.0f * v);
+      float out[2][2][kBlockSize];
+      LPCSpeechSynthController* controllers[2] = { &rom[v], &cached[v] };
+      
+      // Both consume the same random numbers.
+      const uint32_t random_state = Random::state();
+      for (int c = 0; c < 2; ++c) {
+        Random::Seed(random_state);
+        controllers[c]->Render(
+            true, trigger, v, frequency, 0.5f, 0.5f, address, 0.4f, 1.0f,
+            out[c][0], out[c][1], kBlockSize);
+      }
+      for (size_t j = 0; j < kBlockSize; ++j) {
+        num_errors += out[0][0][j] != out[1][0][j];
+        num_errors += out[0][1][j] != out[1][1][j];
+      }
+    }
+  }
+  
+  // A cache holding fewer banks than the ROM does not load the others.
+  LPCSpeechSynthWordBankCache small_cache;
+  small_cache.Init(word_banks_, 2, storage);
+  LPCSpeechSynthWordBank word_bank;
+  BufferAllocator allocator(ram[0], 16384);
+  word_bank.Init(word_banks_, LPC_SPEECH_SYNTH_NUM_WORD_BANKS, &allocator);
+  word_bank.set_cache(&small_cache);
+  
+  printf(
+      "%lu samples differ\tbank 2 %s from a 2-bank cache\n",
+      static_cast<unsigned long>(num_errors),
+      word_bank.Load(2) ? "loaded (FAIL)" : "not loaded");
+}
+
 void GenerateStringTuningData() {
   for (int pass = 0; pass < 21; ++pass) {
     WavWriter wav_writer(1, kSampleRate, 4);
@@ -676,6 +953,109 @@ void TestWavetableEngine() {
   }
 }
 
+void TestWavetableCache() {
+  const size_t kDuration = 10;
+  
+  WavWriter wav_writer(2, kSampleRate, kDuration);
+  wav_writer.Open("plaits_wavetable_cache.wav");
+  
+  static float storage[kWavetableCacheSize];
+  WavetableCache cache;
+  clock_t start = clock();
+  cache.Init(storage);
+  double init_time = clock() - start;
+  
+  // Compares some of the tables with a direct evaluation of the Fourier
+  // series of the derivative of the ROM waves, truncated to the number of
+  // harmonics of each level.
+  const size_t kRomTableSize = 256;
+  const size_t kRomNumHarmonics = kRomTableSize / 2 - 1;
+  const size_t kTestedWaves[] = { 0, 37, 101, 191 };
+  double max_error = 0.0;
+  double max_value = 0.0;
+  for (size_t w = 0; w < sizeof(kTestedWaves) / sizeof(size_t); ++w) {
+    const size_t wave = kTestedWaves[w];
+    const int16_t* integrated = wav_integrated_waves + \
+        wave * (kRomTableSize + 4) + 1;
+    double a[kRomNumHarmonics + 1];
+    double b[kRomNumHarmonics + 1];
+    for (size_t k = 1; k <= kRomNumHarmonics; ++k) {
+      a[k] = b[k] = 0.0;
+      for (size_t n = 0; n < kRomTableSize; ++n) {
+        double phase = 2.0 * M_PI * k * n / kRomTableSize;
+        a[k] += integrated[n] * cos(phase);
+        b[k] += integrated[n] * sin(phase);
+      }
+      // Same scale as the differentiator of WavetableEngine.
+      double scale = 2.0 * M_PI * k * 2.0 / kRomTableSize / 131072.0;
+      a[k] *= scale;
+      b[k] *= scale;
+    }
+    for (size_t level = 0; level < kWavetableCacheNumLevels; ++level) {
+      const size_t size = WavetableCache::table_size(level);
+      const size_t num_harmonics = std::min(
+          kRomNumHarmonics, size_t(128) >> level);
+      const float* table = cache.level_data(level) + \
+          wave * WavetableCache::stride(level);
+      for (size_t n = 0; n < size + 4; ++n) {
+        double phase = 2.0 * M_PI * (double(n) - 1.0) / size;
+        double expected = 0.0;
+        for (size_t k = 1; k <= num_harmonics; ++k) {
+          expected += b[k] * cos(k * phase) - a[k] * sin(k * phase);
+        }
+        max_error = std::max(max_error, fabs(table[n] - expected));
+        max_value = std::max(max_value, fabs(expected));
+      }
+    }
+  }
+  const double kTolerance = 1e-5;
+  printf(
+      "max error: %g (peak %g)%s\n",
+      max_error,
+      max_value,
+      max_error > kTolerance * max_value ? " - FAIL" : "");
+  
+  WavetableEngine rom;
+  WavetableEngine cached;
+  rom.Init(NULL);
+  cached.Init(NULL);
+  cached.set_cache(&cache);
+  
+  EngineParameters p;
+  p.trigger = TRIGGER_LOW;
+  double rom_time = 0.0;
+  double cached_time = 0.0;
+  
+  for (size_t i = 0; i < kSampleRate * kDuration; i += kAudioBlockSize) {
+    // Sweep the note across the whole range to go through all mipmap levels.
+    p.note = 12.0f + 108.0f * wav_writer.triangle(1);
+    p.timbre = wav_writer.triangle(3);
+    p.morph = wav_writer.triangle(7);
+    p.harmonics = wav_writer.triangle(13);
+    
+    float rom_out[kAudioBlockSize];
+    float cached_out[kAudioBlockSize];
+    float aux[kAudioBlockSize];
+    bool already_enveloped;
+    
+    start = clock();
+    rom.Render(p, rom_out, aux, kAudioBlockSize, &already_enveloped);
+    rom_time += clock() - start;
+    
+    start = clock();
+    cached.Render(p, cached_out, aux, kAudioBlockSize, &already_enveloped);
+    cached_time += clock() - start;
+    
+    wav_writer.Write(rom_out, cached_out, kAudioBlockSize);
+  }
+  printf(
+      "init: %.3fs\tROM: %.3fs\tcached: %.3fs for %ds of audio\n",
+      init_time / CLOCKS_PER_SEC,
+      rom_time / CLOCKS_PER_SEC,
+      cached_time / CLOCKS_PER_SEC,
+      int(kDuration));
+}
+
 void EnumerateWavetables() {
   WavWriter wav_writer(1, kSampleRate, 64);
   wav_writer.Open("plaits_wavetable_enumeration.wav");
@@ -1015,6 +1395,309 @@ void TestLimiterGlitch() {
   }
 }
 
+void TestVoiceBank() {
+  const size_t kNumVoices = 16;
+  const size_t kDuration = 20;
+  const size_t kHostBlockSize = 256;
+  
+  // Renders with 1 and 4 threads: the voices drawing from stmlib::Random
+  // (engine 7) are rendered in order in both cases, so the output is the same.
+  vector<Voice::Frame> output[2];
+  for (int run = 0; run < 2; ++run) {
+    Random::Seed(0x21);
+    VoiceBank bank;
+    bank.Init(kNumVoices, run ? 4 : 1, false);
+    bank.set_gain(1.0f / kNumVoices);
+    
+    for (size_t v = 0; v < kNumVoices; ++v) {
+      Patch* patch = bank.mutable_patch(v);
+      patch->engine = v % 8;
+      patch->note = 36.0f + 3.0f * v;
+      patch->harmonics = 0.3f;
+      patch->timbre = 0.5f;
+      patch->morph = 0.5f;
+      patch->decay = 0.3f;
+      patch->lpg_colour = 0.5f;
+    
+      Modulations* modulations = bank.mutable_modulations(v);
+      modulations->level = 1.0f;
+      modulations->trigger_patched = true;
+    }
+    
+    WavWriter wav_writer(2, kSampleRate, kDuration);
+    wav_writer.Open(run
+        ? "plaits_voice_bank.wav"
+        : "plaits_voice_bank_serial.wav");
+    for (size_t i = 0; i < kSampleRate * kDuration; i += kHostBlockSize) {
+      for (size_t v = 0; v < kNumVoices; ++v) {
+        size_t period = kHostBlockSize * (40 + v * 3);
+        bank.mutable_modulations(v)->trigger = (i % period) == 0 ? 1.0f : 0.0f;
+        bank.mutable_patch(v)->timbre = wav_writer.triangle(1 + v % 3);
+      }
+      Voice::Frame frames[kHostBlockSize];
+      bank.Render(frames, kHostBlockSize);
+      wav_writer.WriteFrames(&frames[0].out, kHostBlockSize);
+      output[run].insert(
+          output[run].end(),
+          &frames[0],
+          &frames[kHostBlockSize]);
+    }
+    bank.Stop();
+  }
+  
+  size_t num_errors = 0;
+  for (size_t i = 0; i < output[0].size(); ++i) {
+    num_errors += output[0][i].out != output[1][i].out ||
+        output[0][i].aux != output[1][i].aux ? 1 : 0;
+  }
+  printf("1 vs 4 threads: %d samples differ\n", static_cast<int>(num_errors));
+}
+
+void TestEngineCrossfade() {
+  const size_t kDuration = 10;
+  
+  // Alternates between two engines: slowly during the first half, then at
+  // every block (a "switching storm").
+  for (int crossfade = 0; crossfade < 2; ++crossfade) {
+    WavWriter wav_writer(2, kSampleRate, kDuration);
+    wav_writer.Open(crossfade
+        ? "plaits_engine_crossfade.wav"
+        : "plaits_engine_switch.wav");
+    
+    ChunkedArenaPool pool;
+    pool.Init();
+    Voice voice;
+    voice.Init(&pool);
+    if (crossfade) {
+      voice.set_engine_crossfade(240, 0.25f);
+    }
+    
+    Patch patch;
+    patch.note = 36.0f;
+    patch.harmonics = 0.0f;
+    patch.timbre = 0.0f;
+    patch.morph = 0.0f;
+    patch.decay = 0.5f;
+    patch.lpg_colour = 0.5f;
+    Modulations modulations;
+    
+    int max_step[2] = { 0, 0 };
+    int previous = 0;
+    double time = 0.0;
+    for (size_t i = 0; i < kSampleRate * kDuration; i += kBlockSize) {
+      size_t period = i < kSampleRate * kDuration / 2 ? 4800 : kBlockSize;
+      patch.engine = (i / period) % 2 ? 4 : 2;
+      
+      Voice::Frame frames[kBlockSize];
+      clock_t start = clock();
+      voice.Render(patch, modulations, frames, kBlockSize);
+      time += clock() - start;
+      
+      const int half = i < kSampleRate * kDuration / 2 ? 0 : 1;
+      for (size_t j = 0; j < kBlockSize; ++j) {
+        // Skip the attack of the first note.
+        if (i) {
+          max_step[half] = max(max_step[half], abs(frames[j].out - previous));
+        }
+        previous = frames[j].out;
+      }
+      wav_writer.WriteFrames(&frames[0].out, kBlockSize);
+    }
+    pool.Free();
+    printf(
+        "%s\tmax step: %d (slow), %d (storm)\ttime: %.3fs for %ds of audio\n",
+        crossfade ? "crossfade" : "switch",
+        max_step[0],
+        max_step[1],
+        time / CLOCKS_PER_SEC,
+        int(kDuration));
+  }
+}
+
+void BenchmarkVoiceBankStartup() {
+  const size_t kNumVoices = 512;
+  const size_t kHostBlockSize = 256;
+  
+  for (int lazy = 0; lazy < 2; ++lazy) {
+    VoiceBank bank;
+    clock_t start = clock();
+    bank.Init(kNumVoices, 1, lazy);
+    double init_time = clock() - start;
+    size_t init_memory = bank.memory_usage();
+    
+    for (size_t v = 0; v < kNumVoices; ++v) {
+      Patch* patch = bank.mutable_patch(v);
+      patch->engine = v % 16;
+      patch->note = 48.0f;
+      patch->harmonics = 0.5f;
+      patch->timbre = 0.5f;
+      patch->morph = 0.5f;
+      patch->decay = 0.5f;
+      patch->lpg_colour = 0.5f;
+      bank.mutable_modulations(v)->level = 1.0f;
+    }
+    
+    // The first block initializes the engines in lazy mode.
+    Voice::Frame frames[kHostBlockSize];
+    start = clock();
+    bank.Render(frames, kHostBlockSize);
+    double first_block_time = clock() - start;
+    size_t memory = bank.memory_usage();
+    bank.Stop();
+    
+    printf(
+        "%s\tinit: %.2fms\tfirst block: %.2fms\t"
+        "memory per voice: %zu bytes (%zu at init)\n",
+        lazy ? "lazy" : "eager",
+        init_time * 1000.0 / CLOCKS_PER_SEC,
+        first_block_time * 1000.0 / CLOCKS_PER_SEC,
+        memory / kNumVoices,
+        init_memory / kNumVoices);
+  }
+}
+
+void RenderEngine(
+    int engine,
+    size_t host_block_size,
+    bool large_block_mode,
+    Voice::Frame* frames,
+    size_t size,
+    uint32_t seed = 0x21) {
+  Voice voice;
+  BufferAllocator allocator(ram_block, kMaxEngineRamSize);
+  voice.Init(&allocator);
+  Random::Seed(seed);
+  
+  Patch patch = Patch();
+  patch.engine = engine;
+  patch.note = 48.0f;
+  patch.harmonics = 0.5f;
+  patch.timbre = 0.5f;
+  patch.morph = 0.5f;
+  patch.decay = 0.5f;
+  patch.lpg_colour = 0.5f;
+  Modulations modulations = Modulations();
+  
+  for (size_t i = 0; i < size; i += host_block_size) {
+    size_t block_size = min(host_block_size, size - i);
+    if (large_block_mode) {
+      voice.RenderLargeBlock(patch, modulations, &frames[i], block_size);
+    } else {
+      for (size_t j = 0; j < block_size; j += kBlockSize) {
+        voice.Render(
+            patch,
+            modulations,
+            &frames[i + j],
+            min(kBlockSize, block_size - j));
+      }
+    }
+  }
+}
+
+// Shortest of a few runs, in ns/sample, to filter out the host OS.
+double TimeEngines(
+    size_t host_block_size,
+    bool large_block_mode,
+    Voice::Frame* frames,
+    size_t size) {
+  double best = 0.0;
+  for (int run = 0; run < 3; ++run) {
+    clock_t start = clock();
+    for (int engine = 0; engine < 16; ++engine) {
+      RenderEngine(engine, host_block_size, large_block_mode, frames, size);
+    }
+    double t = double(clock() - start) / CLOCKS_PER_SEC * 1e9 / (16.0 * size);
+    best = run == 0 ? t : min(best, t);
+  }
+  return best;
+}
+
+void BenchmarkLargeBlocks() {
+  const size_t kHostBlockSizes[] = { 64, 256, 1024 };
+  const size_t kSize = kSampleRate * 5;
+  
+  vector<Voice::Frame> reference(kSize);
+  vector<Voice::Frame> frames(kSize);
+  
+  // Reference: the host calls Render() with kBlockSize samples at a time.
+  const double reference_ns = TimeEngines(kSize, false, &reference[0], kSize);
+  printf("%d-sample calls\t%.2fns/sample\n", int(kBlockSize), reference_ns);
+  
+  for (size_t i = 0; i < sizeof(kHostBlockSizes) / sizeof(size_t); ++i) {
+    const size_t host_block_size = kHostBlockSizes[i];
+    const double ns = TimeEngines(host_block_size, true, &frames[0], kSize);
+    
+    int num_bit_exact = 0;
+    for (int engine = 0; engine < 16; ++engine) {
+      RenderEngine(engine, kSize, false, &reference[0], kSize);
+      RenderEngine(engine, host_block_size, true, &frames[0], kSize);
+      num_bit_exact += equal(
+          &reference[0].out,
+          &reference[0].out + 2 * kSize,
+          &frames[0].out);
+    }
+    printf(
+        "%d-sample host buffers\t%.2fns/sample (%+.1f%%)\t"
+        "%d/16 engines bit-exact\n",
+        int(host_block_size),
+        ns,
+        100.0 * (ns - reference_ns) / reference_ns,
+        num_bit_exact);
+  }
+}
+
+void TestSampleRate() {
+  const float kSampleRates[] = { 44100.0f, 48000.0f, 96000.0f };
+  const int kNumSampleRates = sizeof(kSampleRates) / sizeof(float);
+  const size_t kDuration = 2;
+  const size_t kHostBlockSize = 256;
+  const uint32_t kNumSeeds = 8;
+  
+  const SampleRateSettings saved_settings = sample_rate_settings;
+  
+  // Rising zero-crossings per second of each engine, which should not depend
+  // on the sample rate for the pitched engines. With the trigger unpatched,
+  // the string and modal engines are excited by random impulses: a single
+  // render varies by +/-15% with the seed, so the counts are averaged.
+  float crossings[kNumSampleRates][16];
+  for (int r = 0; r < kNumSampleRates; ++r) {
+    SetSampleRate(kSampleRates[r]);
+    const size_t size = kDuration * SampleRate();
+    
+    char file_name[64];
+    sprintf(file_name, "plaits_sample_rate_%d.wav", int(kSampleRates[r]));
+    WavWriter wav_writer(2, SampleRate(), kDuration * 16);
+    wav_writer.Open(file_name);
+    
+    vector<Voice::Frame> frames(size);
+    for (int engine = 0; engine < 16; ++engine) {
+      int n = 0;
+      for (uint32_t seed = kNumSeeds; seed > 0; --seed) {
+        RenderEngine(engine, kHostBlockSize, true, &frames[0], size, seed);
+        for (size_t i = 1; i < size; ++i) {
+          n += frames[i - 1].out < 0 && frames[i].out >= 0;
+        }
+      }
+      crossings[r][engine] = float(n) / (kDuration * kNumSeeds);
+      wav_writer.WriteFrames(&frames[0].out, size);
+    }
+  }
+  sample_rate_settings = saved_settings;
+  
+  printf("engine");
+  for (int r = 0; r < kNumSampleRates; ++r) {
+    printf("\t%dHz", int(kSampleRates[r]));
+  }
+  printf("\n");
+  for (int engine = 0; engine < 16; ++engine) {
+    printf("%d", engine);
+    for (int r = 0; r < kNumSampleRates; ++r) {
+      printf("\t%.1f", crossings[r][engine]);
+    }
+    printf("\n");
+  }
+}
+
 int main(void) {
   _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
   // TestFormantOscillator();
@@ -1026,9 +1709,12 @@ int main(void) {
   // TestVosimOscillator();
   // TestZOscillator();
   // TestHarmonicOscillator();
+  // BenchmarkOscillatorBank();
 
   // TestAdditiveEngine();
   // TestChordEngine();
+  // BenchmarkChordBanks();
+  // BenchmarkChordEngine();
   TestFMEngine();
   // TestGrainEngine();
   // TestModalEngine();
@@ -1036,10 +1722,12 @@ int main(void) {
   // TestNoiseEngine();
   // TestParticleEngine();
   // TestSpeechEngine();
+  // TestLPCSpeechSynthWordBankCache();
   // TestSwarmEngine();
   // TestVirtualAnalogEngine();
   // TestWaveshapingEngine();
   // TestWavetableEngine();
+  // TestWavetableCache();
   // TestBassDrumEngine();
   // TestSnareDrumEngine();
   // TestHiHatEngine();
@@ -1053,4 +1741,9 @@ int main(void) {
   // EnumerateWavetables();
   
   // TestLPGAttackDecay();
+  // TestVoiceBank();
+  // BenchmarkVoiceBankStartup();
+  // TestEngineCrossfade();
+  // BenchmarkLargeBlocks();
+  // TestSampleRate();
 }
@@ -0,0 +1,286 @@
+// Copyright 2016 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Polyphonic bank of independent voices, rendered by a pool of worker threads.
+
+#include "plaits/test/voice_bank.h"
+
+#include <algorithm>
+#include <new>
+
+#include "stmlib/dsp/dsp.h"
+
+#include "plaits/dsp/speech/lpc_speech_synth_words.h"
+
+namespace plaits {
+
+using namespace std;
+using namespace stmlib;
+
+// The wavetable cache is immutable once built, so all the voices of all the
+// banks in the process share the same one.
+static float wavetable_cache_storage[kWavetableCacheSize];
+static WavetableCache wavetable_cache;
+static pthread_once_t wavetable_cache_once = PTHREAD_ONCE_INIT;
+
+static void InitWavetableCache() {
+  wavetable_cache.Init(wavetable_cache_storage);
+}
+
+const WavetableCache* SharedWavetableCache() {
+  pthread_once(&wavetable_cache_once, &InitWavetableCache);
+  return &wavetable_cache;
+}
+
+static LPCSpeechSynth::Frame word_bank_cache_storage[
+    kLPCSpeechSynthWordBankCacheSize];
+static LPCSpeechSynthWordBankCache word_bank_cache;
+static bool word_bank_cache_ready = false;
+static pthread_once_t word_bank_cache_once = PTHREAD_ONCE_INIT;
+
+static void InitWordBankCache() {
+  word_bank_cache_ready = word_bank_cache.Init(
+      word_banks_,
+      LPC_SPEECH_SYNTH_NUM_WORD_BANKS,
+      word_bank_cache_storage);
+}
+
+const LPCSpeechSynthWordBankCache* SharedWordBankCache() {
+  pthread_once(&word_bank_cache_once, &InitWordBankCache);
+  // Without the cache, the voices decode the words from ROM.
+  return word_bank_cache_ready ? &word_bank_cache : NULL;
+}
+
+static inline char* Align(char* p) {
+  uintptr_t address = reinterpret_cast<uintptr_t>(p);
+  address = (address + kArenaAlignment - 1) & ~(kArenaAlignment - 1);
+  return reinterpret_cast<char*>(address);
+}
+
+void ChunkedArenaPool::Init() {
+  allocator_.Init(NULL, 0);
+  next_ = end_ = NULL;
+  pthread_mutex_init(&lock_, NULL);
+}
+
+void ChunkedArenaPool::Free() {
+  for (size_t i = 0; i < chunks_.size(); ++i) {
+    delete[] chunks_[i];
+  }
+  chunks_.clear();
+  next_ = end_ = NULL;
+  pthread_mutex_destroy(&lock_);
+}
+
+BufferAllocator* ChunkedArenaPool::Acquire() {
+  pthread_mutex_lock(&lock_);
+  char* arena = Align(next_);
+  if (!next_ || arena + kMaxEngineRamSize > end_) {
+    // The remainder of the current chunk is lost.
+    char* chunk = new (nothrow) char[kArenaChunkSize + kArenaAlignment];
+    if (!chunk) {
+      pthread_mutex_unlock(&lock_);
+      return NULL;
+    }
+    chunks_.push_back(chunk);
+    arena = Align(chunk);
+    end_ = arena + kArenaChunkSize;
+  }
+  allocator_.Init(arena, end_ - arena);
+  return &allocator_;
+}
+
+void ChunkedArenaPool::Release() {
+  // The next arena starts after what the engine has allocated.
+  next_ = end_ - allocator_.free();
+  pthread_mutex_unlock(&lock_);
+}
+
+bool VoiceBank::Init(
+    size_t num_voices,
+    size_t num_threads,
+    bool lazy_engines) {
+  CONSTRAIN(num_voices, 1, kMaxBankVoices);
+  CONSTRAIN(num_threads, 1, kMaxBankThreads + 1);
+  
+  Stop();
+  
+  const WavetableCache* wavetable_cache = SharedWavetableCache();
+  const LPCSpeechSynthWordBankCache* word_bank_cache = SharedWordBankCache();
+  
+  num_voices_ = num_voices;
+  lazy_engines_ = lazy_engines;
+  arena_pool_.Init();
+  slots_ = new Slot[num_voices_];
+  for (size_t i = 0; i < num_voices_; ++i) {
+    Slot* s = &slots_[i];
+    if (lazy_engines_) {
+      s->ram = NULL;
+      s->voice.Init(&arena_pool_);
+    } else {
+      s->ram = new char[kMaxEngineRamSize];
+      BufferAllocator allocator(s->ram, kMaxEngineRamSize);
+      s->voice.Init(&allocator);
+    }
+    s->voice.set_wavetable_cache(wavetable_cache);
+    s->voice.set_word_bank_cache(word_bank_cache);
+    s->patch = Patch();
+    s->modulations = Modulations();
+  }
+  gain_ = 1.0f;
+  
+  sem_init(&start_, 0, 0);
+  sem_init(&done_, 0, 0);
+  quit_ = false;
+  next_job_ = num_voices_;
+  block_size_ = 0;
+  
+  num_workers_ = 0;
+  while (num_workers_ < num_threads - 1) {
+    if (pthread_create(
+            &workers_[num_workers_],
+            NULL,
+            &WorkerEntryPoint,
+            this)) {
+      Stop();
+      return false;
+    }
+    ++num_workers_;
+  }
+  return true;
+}
+
+void VoiceBank::Stop() {
+  if (!slots_) {
+    return;
+  }
+  quit_ = true;
+  for (size_t i = 0; i < num_workers_; ++i) {
+    sem_post(&start_);
+  }
+  for (size_t i = 0; i < num_workers_; ++i) {
+    pthread_join(workers_[i], NULL);
+  }
+  num_workers_ = 0;
+  sem_destroy(&start_);
+  sem_destroy(&done_);
+  for (size_t i = 0; i < num_voices_; ++i) {
+    delete[] slots_[i].ram;
+  }
+  delete[] slots_;
+  slots_ = NULL;
+  arena_pool_.Free();
+}
+
+size_t VoiceBank::memory_usage() const {
+  size_t size = num_voices_ * sizeof(Slot);
+  return size + (lazy_engines_
+      ? arena_pool_.size()
+      : num_voices_ * kMaxEngineRamSize);
+}
+
+/* static */
+void* VoiceBank::WorkerEntryPoint(void* bank) {
+  static_cast<VoiceBank*>(bank)->Worker();
+  return NULL;
+}
+
+void VoiceBank::Worker() {
+  while (true) {
+    sem_wait(&start_);
+    if (quit_) {
+      break;
+    }
+    RenderJobs();
+    sem_post(&done_);
+  }
+}
+
+void VoiceBank::RenderJobs() {
+  while (true) {
+    size_t job = __sync_fetch_and_add(&next_job_, 1);
+    if (job >= num_voices_) {
+      break;
+    }
+    if (!slots_[job].draws_noise) {
+      RenderVoice(&slots_[job], block_size_);
+    }
+  }
+}
+
+void VoiceBank::RenderVoice(Slot* slot, size_t size) {
+  slot->voice.RenderLargeBlock(
+      slot->patch,
+      slot->modulations,
+      slot->frames,
+      size);
+}
+
+void VoiceBank::Render(Voice::Frame* frames, size_t size) {
+  while (size) {
+    size_t chunk = min(size, kMaxBankBlockSize);
+
+    // The semaphores act as memory barriers: block_size_ and the patches are
+    // visible to the workers, and their output is visible to us once done_
+    // has been posted by each of them.
+    block_size_ = chunk;
+    for (size_t i = 0; i < num_voices_; ++i) {
+      Slot* s = &slots_[i];
+      s->draws_noise = num_workers_ && s->voice.may_draw_noise(
+          s->patch,
+          s->modulations);
+    }
+    next_job_ = 0;
+    for (size_t i = 0; i < num_workers_; ++i) {
+      sem_post(&start_);
+    }
+    RenderJobs();
+    for (size_t i = 0; i < num_workers_; ++i) {
+      sem_wait(&done_);
+    }
+    for (size_t i = 0; i < num_voices_; ++i) {
+      if (slots_[i].draws_noise) {
+        RenderVoice(&slots_[i], chunk);
+      }
+    }
+    
+    const float gain = gain_;
+    for (size_t i = 0; i < chunk; ++i) {
+      int32_t out = 0;
+      int32_t aux = 0;
+      for (size_t j = 0; j < num_voices_; ++j) {
+        out += slots_[j].frames[i].out;
+        aux += slots_[j].frames[i].aux;
+      }
+      frames[i].out = Clip16(static_cast<int32_t>(out * gain));
+      frames[i].aux = Clip16(static_cast<int32_t>(aux * gain));
+    }
+    frames += chunk;
+    size -= chunk;
+  }
+}
+
+}  // namespace plaits
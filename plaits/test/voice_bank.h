@@ -0,0 +1,170 @@
+// Copyright 2016 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Polyphonic bank of independent voices, rendered by a pool of worker threads.
+// Host only - this is not built into the firmware.
+
+#ifndef PLAITS_TEST_VOICE_BANK_H_
+#define PLAITS_TEST_VOICE_BANK_H_
+
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <vector>
+
+#include "stmlib/stmlib.h"
+
+#include "stmlib/utils/buffer_allocator.h"
+
+#include "plaits/dsp/voice.h"
+
+namespace plaits {
+
+const size_t kMaxBankVoices = 1024;
+const size_t kMaxBankThreads = 16;
+const size_t kMaxBankBlockSize = 1024;
+const size_t kArenaChunkSize = 256 * 1024;
+const size_t kArenaAlignment = 16;
+
+// Caches shared by all the voices of the process, built on the first call.
+// SharedWordBankCache() returns NULL if the word banks do not fit in it.
+const WavetableCache* SharedWavetableCache();
+const LPCSpeechSynthWordBankCache* SharedWordBankCache();
+
+// Engine arenas carved from large chunks allocated on demand, shared by all
+// the voices of a bank. Each arena starts on a kArenaAlignment boundary.
+// Acquire() returns NULL when a new chunk cannot be allocated.
+class ChunkedArenaPool : public EngineArenaPool {
+ public:
+  ChunkedArenaPool() { }
+  ~ChunkedArenaPool() { }
+  
+  void Init();
+  void Free();
+  
+  virtual stmlib::BufferAllocator* Acquire();
+  virtual void Release();
+  
+  // Total size of the chunks allocated so far.
+  inline size_t size() const {
+    return chunks_.size() * (kArenaChunkSize + kArenaAlignment);
+  }
+  
+ private:
+  std::vector<char*> chunks_;
+  stmlib::BufferAllocator allocator_;
+  
+  // Free space left in the current chunk.
+  char* next_;
+  char* end_;
+  pthread_mutex_t lock_;
+  
+  DISALLOW_COPY_AND_ASSIGN(ChunkedArenaPool);
+};
+
+class VoiceBank {
+ public:
+  VoiceBank() : slots_(NULL), num_voices_(0), num_workers_(0) { }
+  ~VoiceBank() { Stop(); }
+  
+  // Each voice gets its own RAM, so engine state is never shared between
+  // voices. With lazy_engines, the engines of each voice are initialized on
+  // first use, in arenas from a pool shared by all voices; otherwise, each
+  // voice has kMaxEngineRamSize bytes shared by all its engines.
+  // num_threads counts the calling thread: with 1, everything is rendered
+  // synchronously in Render().
+  bool Init(size_t num_voices, size_t num_threads, bool lazy_engines);
+  
+  // Joins the workers and frees the voices. Does nothing if the bank is not
+  // initialized, so it is safe to call more than once.
+  void Stop();
+  
+  // Renders all voices and mixes them into frames. Worker threads pick voices
+  // from a lock-free job counter; the calling thread joins the work. The
+  // voices whose engines may draw from stmlib::Random are rendered afterwards
+  // by the calling thread alone, in order.
+  void Render(Voice::Frame* frames, size_t size);
+  
+  inline Patch* mutable_patch(size_t voice) {
+    return &slots_[voice].patch;
+  }
+  
+  inline Modulations* mutable_modulations(size_t voice) {
+    return &slots_[voice].modulations;
+  }
+  
+  inline const Voice& voice(size_t voice) const {
+    return slots_[voice].voice;
+  }
+  
+  inline void set_gain(float gain) {
+    gain_ = gain;
+  }
+  
+  // Memory used by the voices and the RAM of their engines, in bytes.
+  size_t memory_usage() const;
+  
+  inline size_t num_voices() const { return num_voices_; }
+  inline size_t num_threads() const { return num_workers_ + 1; }
+  
+ private:
+  struct Slot {
+    Voice voice;
+    Patch patch;
+    Modulations modulations;
+    Voice::Frame frames[kMaxBankBlockSize];
+    char* ram;
+    bool draws_noise;
+  };
+  
+  static void* WorkerEntryPoint(void* bank);
+  void Worker();
+  void RenderJobs();
+  void RenderVoice(Slot* slot, size_t size);
+  
+  Slot* slots_;
+  size_t num_voices_;
+  float gain_;
+  
+  bool lazy_engines_;
+  ChunkedArenaPool arena_pool_;
+  
+  pthread_t workers_[kMaxBankThreads];
+  size_t num_workers_;
+  sem_t start_;
+  sem_t done_;
+  bool quit_;
+  
+  // Per-block job queue: voices are claimed with an atomic increment.
+  volatile size_t next_job_;
+  size_t block_size_;
+  
+  DISALLOW_COPY_AND_ASSIGN(VoiceBank);
+};
+
+}  // namespace plaits
+
+#endif  // PLAITS_TEST_VOICE_BANK_H_
@@ -0,0 +1,234 @@
+// Copyright 2014 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Block-wise access to the delay memory of FxEngine. Data is the
+// DataType<format> of the engine.
+
+#ifndef RINGS_DSP_FX_FX_BLOCK_CONTEXT_H_
+#define RINGS_DSP_FX_FX_BLOCK_CONTEXT_H_
+
+#include "stmlib/stmlib.h"
+
+#include "stmlib/dsp/dsp.h"
+#include "stmlib/dsp/cosine_oscillator.h"
+
+#if defined(__SSE2__) || defined(__ARM_NEON__)
+  #define FX_ENGINE_USE_SIMD
+  #include "rings/dsp/simd.h"
+#endif  // __SSE2__ || __ARM_NEON__
+
+namespace rings {
+
+// Block-wise processing: each delay line is read or written for a whole
+// block at once, instead of interleaving the accesses to all delay lines at
+// each sample. This gives the same result as the sample-by-sample
+// processing only if, within a block, no location is read after having been
+// overwritten by a later sample. Within a delay line, this means that the
+// block size must be smaller than the distance between a write and a read.
+// Across delay lines, this is guaranteed when they are processed in the
+// order in which they are declared in the Memory, except for the last one,
+// whose tail is adjacent to the first one - see AllPass() below.
+template<size_t size, typename Data>
+class FxBlockContext {
+ public:
+  typedef typename Data::T T;
+  
+  enum {
+    max_block_size = 32
+  };
+  
+  FxBlockContext() { }
+  ~FxBlockContext() { }
+  
+  // Advances the write pointer of the engine by block_size samples, with the
+  // same LFO updates as block_size calls to FxEngine::Start().
+  inline void Start(
+      T* buffer,
+      int32_t* write_ptr,
+      stmlib::CosineOscillator* lfo,
+      size_t block_size) {
+    buffer_ = buffer;
+    size_ = block_size;
+    write_ptr_ = (*write_ptr - 1) & MASK;
+    for (size_t i = 0; i < block_size; ++i) {
+      --*write_ptr;
+      if (*write_ptr < 0) {
+        *write_ptr += size;
+      }
+      if ((*write_ptr & 31) == 0) {
+        lfo_value_[0][i] = lfo[0].Next();
+        lfo_value_[1][i] = lfo[1].Next();
+      } else {
+        lfo_value_[0][i] = lfo[0].value();
+        lfo_value_[1][i] = lfo[1].value();
+      }
+    }
+  }
+  
+  template<typename D>
+  inline void Read(D& d, int32_t offset, float* out) const {
+    STATIC_ASSERT(D::base + D::length <= size, delay_memory_full);
+    if (offset == -1) {
+      offset = D::length - 1;
+    }
+    // The write pointer moves backwards, so successive samples of the block
+    // are read from decreasing addresses.
+    int32_t p = write_ptr_ + D::base + offset;
+    size_t i = 0;
+#ifdef FX_ENGINE_USE_SIMD
+    for (; i + kSimdWidth <= size_; i += kSimdWidth) {
+      int32_t q = (p - static_cast<int32_t>(i)) & MASK;
+      if (q < 3) {
+        break;  // Wraps around - finish with the scalar code.
+      }
+      Store(&out[i], Reverse(Data::Load(&buffer_[q - 3])));
+    }
+#endif  // FX_ENGINE_USE_SIMD
+    for (; i < size_; ++i) {
+      out[i] = Data::Decompress(
+          buffer_[(p - static_cast<int32_t>(i)) & MASK]);
+    }
+  }
+  
+  template<typename D>
+  inline void Write(D& d, int32_t offset, const float* in) {
+    STATIC_ASSERT(D::base + D::length <= size, delay_memory_full);
+    if (offset == -1) {
+      offset = D::length - 1;
+    }
+    int32_t p = write_ptr_ + D::base + offset;
+    size_t i = 0;
+#ifdef FX_ENGINE_USE_SIMD
+    for (; i + kSimdWidth <= size_; i += kSimdWidth) {
+      int32_t q = (p - static_cast<int32_t>(i)) & MASK;
+      if (q < 3) {
+        break;
+      }
+      Data::Store(&buffer_[q - 3], Reverse(Load(&in[i])));
+    }
+#endif  // FX_ENGINE_USE_SIMD
+    for (; i < size_; ++i) {
+      buffer_[(p - static_cast<int32_t>(i)) & MASK] = \
+          Data::Compress(in[i]);
+    }
+  }
+  
+  template<typename D>
+  inline void Write(D& d, const float* in) {
+    Write(d, 0, in);
+  }
+  
+  // Equivalent to Read(d TAIL, k) followed by WriteAllPass(d, -k) for each
+  // sample of the block.
+  template<typename D>
+  inline void AllPass(D& d, float k, float* in_out) {
+    STATIC_ASSERT(D::base + D::length <= size, delay_memory_full);
+    int32_t read_ptr = write_ptr_ + D::base + D::length - 1;
+    int32_t write_ptr = write_ptr_ + D::base;
+    size_t i = 0;
+#ifdef FX_ENGINE_USE_SIMD
+    for (; i + kSimdWidth <= size_; i += kSimdWidth) {
+      int32_t r = (read_ptr - static_cast<int32_t>(i)) & MASK;
+      int32_t w = (write_ptr - static_cast<int32_t>(i)) & MASK;
+      if (r < 3 || w < 3) {
+        break;
+      }
+      Float4 delayed = Reverse(Data::Load(&buffer_[r - 3]));
+      Float4 written = Load(&in_out[i]) + delayed * k;
+      Store(&in_out[i], written * -k + delayed);
+      Data::Store(&buffer_[w - 3], Reverse(written));
+    }
+#endif  // FX_ENGINE_USE_SIMD
+    for (; i < size_; ++i) {
+      int32_t offset = -static_cast<int32_t>(i);
+      float delayed = Data::Decompress(
+          buffer_[(read_ptr + offset) & MASK]);
+      float written = in_out[i] + delayed * k;
+      buffer_[(write_ptr + offset) & MASK] = \
+          Data::Compress(written);
+      in_out[i] = written * -k + delayed;
+    }
+  }
+  
+  // Same as above, with the tail of the delay line previously read with
+  // Read(d TAIL, delayed). This is needed for the delay line at the end of
+  // the memory, which is adjacent to the beginning of the first delay line
+  // since the buffer is circular: its tail must be read before the first
+  // delay line is written.
+  template<typename D>
+  inline void AllPass(D& d, float k, const float* delayed, float* in_out) {
+    float written[max_block_size];
+    size_t i = 0;
+#ifdef FX_ENGINE_USE_SIMD
+    for (; i + kSimdWidth <= size_; i += kSimdWidth) {
+      Float4 delayed_4 = Load(&delayed[i]);
+      Float4 written_4 = Load(&in_out[i]) + delayed_4 * k;
+      Store(&written[i], written_4);
+      Store(&in_out[i], written_4 * -k + delayed_4);
+    }
+#endif  // FX_ENGINE_USE_SIMD
+    for (; i < size_; ++i) {
+      written[i] = in_out[i] + delayed[i] * k;
+      in_out[i] = written[i] * -k + delayed[i];
+    }
+    Write(d, 0, written);
+  }
+  
+  template<typename D>
+  inline void Interpolate(
+      D& d,
+      float offset,
+      int32_t index,
+      float amplitude,
+      float* out) const {
+    STATIC_ASSERT(D::base + D::length <= size, delay_memory_full);
+    for (size_t i = 0; i < size_; ++i) {
+      float sample_offset = offset + amplitude * lfo_value_[index][i];
+      MAKE_INTEGRAL_FRACTIONAL(sample_offset);
+      int32_t p = write_ptr_ - static_cast<int32_t>(i) + \
+          sample_offset_integral + D::base;
+      float a = Data::Decompress(buffer_[p & MASK]);
+      float b = Data::Decompress(buffer_[(p + 1) & MASK]);
+      out[i] = a + (b - a) * sample_offset_fractional;
+    }
+  }
+  
+ private:
+  enum {
+    MASK = size - 1
+  };
+  
+  float lfo_value_[2][max_block_size];
+  T* buffer_;
+  int32_t write_ptr_;
+  size_t size_;
+  
+  DISALLOW_COPY_AND_ASSIGN(FxBlockContext);
+};
+
+}  // namespace rings
+
+#endif  // RINGS_DSP_FX_FX_BLOCK_CONTEXT_H_
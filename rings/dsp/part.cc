@@ -40,17 +40,21 @@ using namespace stmlib;
 void Part::Init(uint16_t* reverb_buffer) {
   active_voice_ = 0;
   
-  fill(&note_[0], &note_[kMaxPolyphony], 0.0f);
+  fill(&note_[0], &note_[kMaxExtendedPolyphony], 0.0f);
   
   bypass_ = false;
   polyphony_ = 1;
   model_ = RESONATOR_MODEL_MODAL;
   dirty_ = true;
+  parallel_runner_ = NULL;
   
-  for (int32_t i = 0; i < kMaxPolyphony; ++i) {
+  for (int32_t i = 0; i < kMaxExtendedPolyphony; ++i) {
     excitation_filter_[i].Init();
     plucker_[i].Init();
     dc_blocker_[i].Init(1.0f - 10.0f / kSampleRate);
+    tuning_[i].num_strings = 0;
+    tuning_[i].num_updates = 0;
+    tuning_[i].num_skipped_updates = 0;
   }
   
   reverb_.Init(reverb_buffer);
@@ -72,7 +76,8 @@ void Part::ConfigureResonators() {
   switch (model_) {
     case RESONATOR_MODEL_MODAL:
       {
-        int32_t resolution = 64 / polyphony_ - 4;
+        // Beyond 4 voices, each voice keeps as many modes as with 4 voices.
+        int32_t resolution = max(64 / polyphony_ - 4, 12);
         for (int32_t i = 0; i < polyphony_; ++i) {
           resonator_[i].Init();
           resonator_[i].set_resolution(resolution);
@@ -85,20 +90,25 @@ void Part::ConfigureResonators() {
     case RESONATOR_MODEL_SYMPATHETIC_STRING_QUANTIZED:
     case RESONATOR_MODEL_STRING_AND_REVERB:
       {
-        float lfo_frequencies[kNumStrings] = {
+        float lfo_frequencies[kMaxPolyphony * 2] = {
           0.5f, 0.4f, 0.35f, 0.23f, 0.211f, 0.2f, 0.171f
         };
         for (int32_t i = 0; i < kNumStrings; ++i) {
-          bool has_dispersion = model_ == RESONATOR_MODEL_STRING || \
-              model_ == RESONATOR_MODEL_STRING_AND_REVERB;
-          string_[i].Init(has_dispersion);
+          string_[i].Init(strings_have_dispersion());
 
           float f_lfo = float(kMaxBlockSize) / float(kSampleRate);
-          f_lfo *= lfo_frequencies[i];
+          f_lfo *= lfo_frequencies[i % (kMaxPolyphony * 2)];
           lfo_[i].Init<COSINE_OSCILLATOR_APPROXIMATE>(f_lfo);
         }
+#ifdef STRING_USE_SIMD
+        for (int32_t i = 0; i < kNumStringBanks; ++i) {
+          string_bank_[i].Init(strings_have_dispersion());
+        }
+#endif  // STRING_USE_SIMD
         for (int32_t i = 0; i < polyphony_; ++i) {
           plucker_[i].Init();
+          // Forces the strings to be retuned on the next block.
+          tuning_[i].num_strings = 0;
         }
       }
       break;
@@ -265,7 +275,8 @@ void Part::ComputeSympatheticStringsNotes(
   if (parameter >= 2.0f) {
     // Quantized chords
     int32_t chord_index = parameter - 2.0f;
-    const float* chord = chords[polyphony_ - 1][chord_index];
+    const float* chord = chords[
+        min(polyphony_, kMaxPolyphony) - 1][chord_index];
     for (size_t i = 0; i < num_strings; ++i) {
       destination[i] = chord[i] + note;
     }
@@ -296,6 +307,54 @@ void Part::ComputeSympatheticStringsNotes(
   }
 }
 
+const float* Part::TuneSympatheticStrings(
+    int32_t voice,
+    float tonic,
+    float note,
+    float parameter,
+    int32_t num_strings) {
+  SympatheticStringsTuning* t = &tuning_[voice];
+  if (num_strings == t->num_strings &&
+      fabs(tonic - t->tonic) <= kSympatheticNoteThreshold &&
+      fabs(note - t->note) <= kSympatheticNoteThreshold &&
+      fabs(parameter - t->parameter) <= kSympatheticParameterThreshold) {
+    ++t->num_skipped_updates;
+    return t->frequencies;
+  }
+  
+  ++t->num_updates;
+  t->tonic = tonic;
+  t->note = note;
+  t->parameter = parameter;
+  t->num_strings = num_strings;
+  ComputeSympatheticStringsNotes(
+      tonic,
+      note,
+      parameter,
+      t->frequencies,
+      num_strings);
+  for (int32_t i = 0; i < num_strings; ++i) {
+    t->frequencies[i] = SemitonesToRatio(t->frequencies[i] - 69.0f) * a3;
+  }
+  return t->frequencies;
+}
+
+uint32_t Part::num_tuning_updates() const {
+  uint32_t n = 0;
+  for (int32_t i = 0; i < kMaxExtendedPolyphony; ++i) {
+    n += tuning_[i].num_updates;
+  }
+  return n;
+}
+
+uint32_t Part::num_skipped_tuning_updates() const {
+  uint32_t n = 0;
+  for (int32_t i = 0; i < kMaxExtendedPolyphony; ++i) {
+    n += tuning_[i].num_skipped_updates;
+  }
+  return n;
+}
+
 void Part::RenderModalVoice(
     int32_t voice,
     const PerformanceState& performance_state,
@@ -303,17 +362,21 @@ void Part::RenderModalVoice(
     float frequency,
     float filter_cutoff,
     size_t size) {
+  float* resonator_input = resonator_input_[voice_buffer(voice)];
+  float* out_buffer = out_buffer_[voice_buffer(voice)];
+  float* aux_buffer = aux_buffer_[voice_buffer(voice)];
+  
   // Internal exciter is a pulse, pre-filter.
   if (performance_state.internal_exciter &&
       voice == active_voice_ &&
       performance_state.strum) {
-    resonator_input_[0] += 0.25f * SemitonesToRatio(
+    resonator_input[0] += 0.25f * SemitonesToRatio(
         filter_cutoff * filter_cutoff * 24.0f) / filter_cutoff;
   }
   
   // Process through filter.
   excitation_filter_[voice].Process<FILTER_MODE_LOW_PASS>(
-      resonator_input_, resonator_input_, size);
+      resonator_input, resonator_input, size);
 
   Resonator& r = resonator_[voice];
   r.set_frequency(frequency);
@@ -321,7 +384,7 @@ void Part::RenderModalVoice(
   r.set_brightness(patch.brightness * patch.brightness);
   r.set_position(patch.position);
   r.set_damping(patch.damping);
-  r.Process(resonator_input_, out_buffer_, aux_buffer_, size);
+  r.Process(resonator_input, out_buffer, aux_buffer, size);
 }
 
 void Part::RenderFMVoice(
@@ -331,6 +394,10 @@ void Part::RenderFMVoice(
     float frequency,
     float filter_cutoff,
     size_t size) {
+  float* resonator_input = resonator_input_[voice_buffer(voice)];
+  float* out_buffer = out_buffer_[voice_buffer(voice)];
+  float* aux_buffer = aux_buffer_[voice_buffer(voice)];
+  
   FMVoice& v = fm_voice_[voice];
   if (performance_state.internal_exciter &&
       voice == active_voice_ &&
@@ -344,7 +411,7 @@ void Part::RenderFMVoice(
   v.set_feedback_amount(patch.position);
   v.set_position(/*patch.position*/ 0.0f);
   v.set_damping(patch.damping);
-  v.Process(resonator_input_, out_buffer_, aux_buffer_, size);
+  v.Process(resonator_input, out_buffer, aux_buffer, size);
 }
 
 void Part::RenderStringVoice(
@@ -354,25 +421,30 @@ void Part::RenderStringVoice(
     float frequency,
     float filter_cutoff,
     size_t size) {
+  float* resonator_input = resonator_input_[voice_buffer(voice)];
+  float* sympathetic_resonator_input =
+      sympathetic_resonator_input_[voice_buffer(voice)];
+  float* noise_burst_buffer = noise_burst_buffer_[voice_buffer(voice)];
+  float* out_buffer = out_buffer_[voice_buffer(voice)];
+  float* aux_buffer = aux_buffer_[voice_buffer(voice)];
+  
   // Compute number of strings and frequency.
   int32_t num_strings = 1;
   float frequencies[kNumStrings];
 
   if (model_ == RESONATOR_MODEL_SYMPATHETIC_STRING ||
       model_ == RESONATOR_MODEL_SYMPATHETIC_STRING_QUANTIZED) {
-    num_strings = 2 * kMaxPolyphony / polyphony_;
+    num_strings = max(2 * kMaxPolyphony / polyphony_, 2);
     float parameter = model_ == RESONATOR_MODEL_SYMPATHETIC_STRING
         ? patch.structure
         : 2.0f + performance_state.chord;
-    ComputeSympatheticStringsNotes(
+    const float* tuning = TuneSympatheticStrings(
+        voice,
         performance_state.tonic + performance_state.fm,
         performance_state.tonic + note_[voice] + performance_state.fm,
         parameter,
-        frequencies,
         num_strings);
-    for (int32_t i = 0; i < num_strings; ++i) {
-      frequencies[i] = SemitonesToRatio(frequencies[i] - 69.0f) * a3;
-    }
+    copy(&tuning[0], &tuning[num_strings], &frequencies[0]);
   } else {
     frequencies[0] = frequency;
   }
@@ -380,34 +452,52 @@ void Part::RenderStringVoice(
   if (voice == active_voice_) {
     const float gain = 1.0f / Sqrt(static_cast<float>(num_strings) * 2.0f);
     for (size_t i = 0; i < size; ++i) {
-      resonator_input_[i] *= gain;
+      resonator_input[i] *= gain;
     }
   }
 
   // Process external input.
   excitation_filter_[voice].Process<FILTER_MODE_LOW_PASS>(
-      resonator_input_, resonator_input_, size);
+      resonator_input, resonator_input, size);
 
   // Add noise burst.
   if (performance_state.internal_exciter) {
     if (voice == active_voice_ && performance_state.strum) {
       plucker_[voice].Trigger(frequency, filter_cutoff * 8.0f, patch.position);
     }
-    plucker_[voice].Process(noise_burst_buffer_, size);
+    plucker_[voice].Process(noise_burst_buffer, size);
     for (size_t i = 0; i < size; ++i) {
-      resonator_input_[i] += noise_burst_buffer_[i];
+      resonator_input[i] += noise_burst_buffer[i];
     }
   }
-  dc_blocker_[voice].Process(resonator_input_, size);
+  dc_blocker_[voice].Process(resonator_input, size);
   
-  fill(&out_buffer_[0], &out_buffer_[size], 0.0f);
-  fill(&aux_buffer_[0], &aux_buffer_[size], 0.0f);
+  fill(&out_buffer[0], &out_buffer[size], 0.0f);
+  fill(&aux_buffer[0], &aux_buffer[size], 0.0f);
   
   float structure = patch.structure;
   float dispersion = structure < 0.24f
       ? (structure - 0.24f) * 4.166f
       : (structure > 0.26f ? (structure - 0.26f) * 1.35135f : 0.0f);
   
+#ifdef STRING_USE_SIMD
+  // The strings from first_banked_string are rendered by a StringBank: the
+  // sympathetic strings of the first voices right after string 0, or the
+  // single string of each voice once all voices have been prepared.
+  StringBank* bank = NULL;
+  int32_t first_banked_string = num_strings;
+  int32_t lane_offset = 0;
+  if (num_strings > 2 && voice < kNumStringBanks) {
+    bank = &string_bank_[voice];
+    first_banked_string = 1;
+    lane_offset = -1;
+  } else if (string_voices_in_banks()) {
+    bank = &string_bank_[voice / kMaxBankStrings];
+    first_banked_string = 0;
+    lane_offset = voice % kMaxBankStrings;
+  }
+#endif  // STRING_USE_SIMD
+  
   for (int32_t string = 0; string < num_strings; ++string) {
     int32_t i = voice + string * polyphony_;
     String& s = string_[i];
@@ -418,7 +508,7 @@ void Part::RenderStringVoice(
     float position = patch.position;
     float glide = 1.0f;
     float string_index = static_cast<float>(string) / static_cast<float>(num_strings);
-    const float* input = resonator_input_;
+    const float* input = resonator_input;
     
     if (model_ == RESONATOR_MODEL_STRING_AND_REVERB) {
       damping *= (2.0f - damping);
@@ -435,27 +525,126 @@ void Part::RenderStringVoice(
       float amount = (0.5f - fabs(0.5f - patch.position)) * 0.9f;
       position = patch.position + lfo_value * amount;
       glide = SemitonesToRatio((brightness - 1.0f) * 36.0f);
-      input = sympathetic_resonator_input_;
+      input = sympathetic_resonator_input;
     }
     
+    damping += string_index * (0.95f - damping);
+#ifdef STRING_USE_SIMD
+    if (string >= first_banked_string) {
+      int32_t lane = lane_offset + string;
+      bank->set_dispersion(lane, dispersion);
+      bank->set_frequency(lane, frequencies[string], glide);
+      bank->set_brightness(lane, brightness);
+      bank->set_position(lane, position);
+      bank->set_damping(lane, damping);
+      // With dispersion, this draws from stmlib::Random: voices_draw_noise()
+      // is then true, and the voices are never prepared concurrently.
+      bank->Prepare(lane, input, out_buffer, aux_buffer, size);
+      continue;
+    }
+#endif  // STRING_USE_SIMD
     s.set_dispersion(dispersion);
     s.set_frequency(frequencies[string], glide);
     s.set_brightness(brightness);
     s.set_position(position);
-    s.set_damping(damping + string_index * (0.95f - damping));
-    s.Process(input, out_buffer_, aux_buffer_, size);
+    s.set_damping(damping);
+    s.Process(input, out_buffer, aux_buffer, size);
     
     if (string == 0) {
       // Was 0.1f, Ben Wilson -> 0.2f
       float gain = 0.2f / static_cast<float>(num_strings);
       for (size_t i = 0; i < size; ++i) {
-        float sum = out_buffer_[i] - aux_buffer_[i];
-        sympathetic_resonator_input_[i] = gain * sum;
+        float sum = out_buffer[i] - aux_buffer[i];
+        sympathetic_resonator_input[i] = gain * sum;
       }
     }
   }
+#ifdef STRING_USE_SIMD
+  if (first_banked_string == 1) {
+    bank->Process(num_strings - 1, size);
+  }
+#endif  // STRING_USE_SIMD
+}
+
+/* static */
+void Part::RenderVoiceTask(void* part, int32_t voice) {
+  static_cast<Part*>(part)->RenderVoice(voice);
 }
 
+void Part::RenderVoice(int32_t voice) {
+  const PerformanceState& performance_state = *performance_state_;
+  const Patch& patch = *patch_;
+  const float* in = in_;
+  const size_t size = size_;
+  
+  // Compute MIDI note value, frequency, and cutoff frequency for excitation
+  // filter.
+  float cutoff = patch.brightness * (2.0f - patch.brightness);
+  float note = note_[voice] + performance_state.tonic + performance_state.fm;
+  float frequency = SemitonesToRatio(note - 69.0f) * a3;
+  float filter_cutoff_range = performance_state.internal_exciter
+    ? frequency * SemitonesToRatio((cutoff - 0.5f) * 96.0f)
+    : 0.4f * SemitonesToRatio((cutoff - 1.0f) * 108.0f);
+  float filter_cutoff = min(voice == active_voice_
+    ? filter_cutoff_range
+    : (10.0f / kSampleRate), 0.499f);
+  float filter_q = performance_state.internal_exciter ? 1.5f : 0.8f;
+
+  // Process input with excitation filter. Inactive voices receive silence.
+  float* resonator_input = resonator_input_[voice_buffer(voice)];
+  excitation_filter_[voice].set_f_q<FREQUENCY_DIRTY>(filter_cutoff, filter_q);
+  if (voice == active_voice_) {
+    copy(&in[0], &in[size], &resonator_input[0]);
+  } else {
+    fill(&resonator_input[0], &resonator_input[size], 0.0f);
+  }
+  
+  if (model_ == RESONATOR_MODEL_MODAL) {
+    RenderModalVoice(
+        voice, performance_state, patch, frequency, filter_cutoff, size);
+  } else if (model_ == RESONATOR_MODEL_FM_VOICE) {
+    RenderFMVoice(
+        voice, performance_state, patch, frequency, filter_cutoff, size);
+  } else {
+    RenderStringVoice(
+        voice, performance_state, patch, frequency, filter_cutoff, size);
+  }
+}
+
+void Part::MixVoice(int32_t voice, float* out, float* aux, size_t size) {
+  const float* out_buffer = out_buffer_[voice_buffer(voice)];
+  const float* aux_buffer = aux_buffer_[voice_buffer(voice)];
+  if (polyphony_ == 1) {
+    // Send the two sets of harmonics / pickups to individual outputs.
+    for (size_t i = 0; i < size; ++i) {
+      out[i] += out_buffer[i];
+      aux[i] += aux_buffer[i];
+    }
+  } else {
+    // Dispatch odd/even voices to individual outputs.
+    float* destination = voice & 1 ? aux : out;
+    for (size_t i = 0; i < size; ++i) {
+      destination[i] += out_buffer[i] - aux_buffer[i];
+    }
+  }
+}
+
+#ifdef STRING_USE_SIMD
+
+/* static */
+void Part::ProcessStringBankTask(void* part, int32_t bank) {
+  static_cast<Part*>(part)->ProcessStringBank(bank);
+}
+
+void Part::ProcessStringBank(int32_t bank) {
+  int32_t first_voice = bank * kMaxBankStrings;
+  string_bank_[bank].Process(
+      min(polyphony_ - first_voice, kMaxBankStrings),
+      size_);
+}
+
+#endif  // STRING_USE_SIMD
+
 const int32_t kPingPattern[] = {
   1, 0, 2, 1, 0, 2, 1, 0
 };
@@ -483,7 +672,7 @@ void Part::Process(
 
   if (performance_state.strum) {
     note_[active_voice_] = note_filter_.stable_note();
-    if (polyphony_ > 1 && polyphony_ & 1) {
+    if (polyphony_ == 3) {
       active_voice_ = kPingPattern[step_counter_ % 8];
       step_counter_ = (step_counter_ + 1) % 8;
     } else {
@@ -493,55 +682,46 @@ void Part::Process(
   
   note_[active_voice_] = note_filter_.note();
   
-  fill(&out[0], &out[size], 0.0f);
-  fill(&aux[0], &aux[size], 0.0f);
-  for (int32_t voice = 0; voice < polyphony_; ++voice) {
-    // Compute MIDI note value, frequency, and cutoff frequency for excitation
-    // filter.
-    float cutoff = patch.brightness * (2.0f - patch.brightness);
-    float note = note_[voice] + performance_state.tonic + performance_state.fm;
-    float frequency = SemitonesToRatio(note - 69.0f) * a3;
-    float filter_cutoff_range = performance_state.internal_exciter
-      ? frequency * SemitonesToRatio((cutoff - 0.5f) * 96.0f)
-      : 0.4f * SemitonesToRatio((cutoff - 1.0f) * 108.0f);
-    float filter_cutoff = min(voice == active_voice_
-      ? filter_cutoff_range
-      : (10.0f / kSampleRate), 0.499f);
-    float filter_q = performance_state.internal_exciter ? 1.5f : 0.8f;
-
-    // Process input with excitation filter. Inactive voices receive silence.
-    excitation_filter_[voice].set_f_q<FREQUENCY_DIRTY>(filter_cutoff, filter_q);
-    if (voice == active_voice_) {
-      copy(&in[0], &in[size], &resonator_input_[0]);
-    } else {
-      fill(&resonator_input_[0], &resonator_input_[size], 0.0f);
+  performance_state_ = &performance_state;
+  patch_ = &patch;
+  in_ = in;
+  size_ = size;
+  if (kNumVoiceBuffers == 1) {
+    // The voices share one set of buffers: mix each of them once rendered.
+    fill(&out[0], &out[size], 0.0f);
+    fill(&aux[0], &aux[size], 0.0f);
+    for (int32_t voice = 0; voice < polyphony_; ++voice) {
+      RenderVoice(voice);
+      MixVoice(voice, out, aux, size);
     }
-    
-    if (model_ == RESONATOR_MODEL_MODAL) {
-      RenderModalVoice(
-          voice, performance_state, patch, frequency, filter_cutoff, size);
-    } else if (model_ == RESONATOR_MODEL_FM_VOICE) {
-      RenderFMVoice(
-          voice, performance_state, patch, frequency, filter_cutoff, size);
-    } else {
-      RenderStringVoice(
-          voice, performance_state, patch, frequency, filter_cutoff, size);
+  } else if (parallel_runner_ && polyphony_ > 1 &&
+      !voices_draw_noise(performance_state)) {
+    parallel_runner_->Run(&RenderVoiceTask, this, polyphony_);
+  } else {
+    for (int32_t voice = 0; voice < polyphony_; ++voice) {
+      RenderVoice(voice);
     }
-    
-    if (polyphony_ == 1) {
-      // Send the two sets of harmonics / pickups to individual outputs.
-      for (size_t i = 0; i < size; ++i) {
-        out[i] += out_buffer_[i];
-        aux[i] += aux_buffer_[i];
-      }
+  }
+#ifdef STRING_USE_SIMD
+  if (string_voices_in_banks()) {
+    int32_t num_banks = (polyphony_ + kMaxBankStrings - 1) / kMaxBankStrings;
+    if (parallel_runner_ && num_banks > 1) {
+      parallel_runner_->Run(&ProcessStringBankTask, this, num_banks);
     } else {
-      // Dispatch odd/even voices to individual outputs.
-      float* destination = voice & 1 ? aux : out;
-      for (size_t i = 0; i < size; ++i) {
-        destination[i] += out_buffer_[i] - aux_buffer_[i];
+      for (int32_t bank = 0; bank < num_banks; ++bank) {
+        ProcessStringBank(bank);
       }
     }
   }
+#endif  // STRING_USE_SIMD
+  
+  if (kNumVoiceBuffers > 1) {
+    fill(&out[0], &out[size], 0.0f);
+    fill(&aux[0], &aux[size], 0.0f);
+    for (int32_t voice = 0; voice < polyphony_; ++voice) {
+      MixVoice(voice, out, aux, size);
+    }
+  }
   
   if (model_ == RESONATOR_MODEL_STRING_AND_REVERB) {
     for (size_t i = 0; i < size; ++i) {
@@ -45,6 +45,7 @@
 #include "rings/dsp/plucker.h"
 #include "rings/dsp/resonator.h"
 #include "rings/dsp/string.h"
+#include "rings/dsp/string_bank.h"
 
 namespace rings {
 
@@ -61,7 +62,66 @@ enum ResonatorModel {
 };
 
 const int32_t kMaxPolyphony = 4;
-const int32_t kNumStrings = kMaxPolyphony * 2;
+
+#ifdef TEST
+// On the host, the voices can be rendered on several cores (see
+// Part::set_parallel_runner()), which makes a higher polyphony practical.
+const int32_t kMaxExtendedPolyphony = 16;
+#else
+const int32_t kMaxExtendedPolyphony = kMaxPolyphony;
+#endif  // TEST
+
+const int32_t kNumStrings = kMaxExtendedPolyphony * 2;
+
+#if defined(TEST) || defined(STRING_USE_SIMD)
+// Each voice renders into its own buffers, so that the voices can be rendered
+// in parallel, or mixed once the string banks have been processed.
+const int32_t kNumVoiceBuffers = kMaxExtendedPolyphony;
+#else
+// The firmware renders and mixes the voices one at a time, sharing one set of
+// buffers.
+const int32_t kNumVoiceBuffers = 1;
+#endif  // TEST || STRING_USE_SIMD
+
+#ifdef STRING_USE_SIMD
+// Either the sympathetic strings of the first 2 voices, or the strings of up
+// to 16 voices of the single-string models.
+const int32_t kNumStringBanks = 2;
+#endif  // STRING_USE_SIMD
+
+// The sympathetic strings of a voice are retuned only when its note or the
+// tonic has moved by more than this many semitones, or the structure by more
+// than this amount, since they were last tuned. The cache is thus approximate:
+// the strings can lag the exact tuning by up to 0.1 cent, or by the effect of
+// a 0.001 change of the structure.
+const float kSympatheticNoteThreshold = 0.001f;
+const float kSympatheticParameterThreshold = 0.001f;
+
+// Frequencies of the sympathetic strings of a voice, and the notes they have
+// been computed from.
+struct SympatheticStringsTuning {
+  float tonic;
+  float note;
+  float parameter;
+  int32_t num_strings;
+  float frequencies[kMaxPolyphony * 2];
+  
+  uint32_t num_updates;
+  uint32_t num_skipped_updates;
+};
+
+// Runs a batch of independent tasks, possibly in parallel.
+class ParallelRunner {
+ public:
+  typedef void (*Task)(void* context, int32_t index);
+  
+  ParallelRunner() { }
+  virtual ~ParallelRunner() { }
+  
+  // Calls task(context, i) for each i in [0, num_tasks), in any order and from
+  // any thread, and returns once all the calls have returned.
+  virtual void Run(Task task, void* context, int32_t num_tasks) = 0;
+};
 
 class Part {
  public:
@@ -84,13 +144,27 @@ class Part {
   inline int32_t polyphony() const { return polyphony_; }
   inline void set_polyphony(int32_t polyphony) {
     int32_t old_polyphony = polyphony_;
-    polyphony_ = std::min(polyphony, kMaxPolyphony);
+    polyphony_ = std::min(polyphony, kMaxExtendedPolyphony);
     for (int32_t i = old_polyphony; i < polyphony_; ++i) {
       note_[i] = note_[0] + i * 0.05f;
     }
     dirty_ = true;
   }
   
+  // With a runner, the voices are rendered in parallel, joined before the
+  // reverb and limiter. The output is the same as with the voices rendered one
+  // after the other. stmlib::Random is shared by all the voices, so the
+  // voices drawing noise are still rendered one after the other: see
+  // voices_draw_noise().
+  inline void set_parallel_runner(ParallelRunner* runner) {
+    parallel_runner_ = runner;
+  }
+  
+  // Number of blocks for which the sympathetic strings of a voice have been
+  // retuned, or have kept the tuning of the previous block.
+  uint32_t num_tuning_updates() const;
+  uint32_t num_skipped_tuning_updates() const;
+  
   inline ResonatorModel model() const { return model_; }
   inline void set_model(ResonatorModel model) {
     if (model != model_) {
@@ -101,6 +175,39 @@ class Part {
 
  private:
   void ConfigureResonators();
+  static void RenderVoiceTask(void* part, int32_t voice);
+  void RenderVoice(int32_t voice);
+  void MixVoice(int32_t voice, float* out, float* aux, size_t size);
+  inline int32_t voice_buffer(int32_t voice) const {
+    return kNumVoiceBuffers == 1 ? 0 : voice;
+  }
+  inline bool strings_have_dispersion() const {
+    return model_ == RESONATOR_MODEL_STRING ||
+        model_ == RESONATOR_MODEL_STRING_AND_REVERB;
+  }
+  
+  // The plucker of the string models (internal exciter) and the dispersion
+  // of the strings (String, or StringBank::Prepare()) draw numbers from
+  // stmlib::Random.
+  inline bool voices_draw_noise(
+      const PerformanceState& performance_state) const {
+    if (model_ == RESONATOR_MODEL_MODAL || model_ == RESONATOR_MODEL_FM_VOICE) {
+      return false;
+    }
+    return performance_state.internal_exciter || strings_have_dispersion();
+  }
+  
+#ifdef STRING_USE_SIMD
+  static void ProcessStringBankTask(void* part, int32_t bank);
+  void ProcessStringBank(int32_t bank);
+  
+  // The single-string models render the strings of all voices in banks, once
+  // the excitation of each voice has been computed.
+  inline bool string_voices_in_banks() const {
+    return polyphony_ > 1 && (model_ == RESONATOR_MODEL_STRING ||
+        model_ == RESONATOR_MODEL_STRING_AND_REVERB);
+  }
+#endif  // STRING_USE_SIMD
   void RenderModalVoice(
       int32_t voice,
       const PerformanceState& performance_state,
@@ -149,6 +256,12 @@ class Part {
       float parameter,
       float* destination,
       size_t num_strings);
+  const float* TuneSympatheticStrings(
+      int32_t voice,
+      float tonic,
+      float note,
+      float parameter,
+      int32_t num_strings);
   
   bool bypass_;
   bool dirty_;
@@ -160,24 +273,36 @@ class Part {
   uint32_t step_counter_;
   int32_t polyphony_;
   
-  Resonator resonator_[kMaxPolyphony];
+  Resonator resonator_[kMaxExtendedPolyphony];
   String string_[kNumStrings];
   stmlib::CosineOscillator lfo_[kNumStrings];
-  FMVoice fm_voice_[kMaxPolyphony];
+#ifdef STRING_USE_SIMD
+  StringBank string_bank_[kNumStringBanks];
+#endif  // STRING_USE_SIMD
+  FMVoice fm_voice_[kMaxExtendedPolyphony];
   
-  stmlib::Svf excitation_filter_[kMaxPolyphony];
-  stmlib::DCBlocker dc_blocker_[kMaxPolyphony];
-  Plucker plucker_[kMaxPolyphony];
+  stmlib::Svf excitation_filter_[kMaxExtendedPolyphony];
+  stmlib::DCBlocker dc_blocker_[kMaxExtendedPolyphony];
+  Plucker plucker_[kMaxExtendedPolyphony];
 
-  float note_[kMaxPolyphony];
+  float note_[kMaxExtendedPolyphony];
+  SympatheticStringsTuning tuning_[kMaxExtendedPolyphony];
   NoteFilter note_filter_;
   
-  float resonator_input_[kMaxBlockSize];
-  float sympathetic_resonator_input_[kMaxBlockSize];
-  float noise_burst_buffer_[kMaxBlockSize];
+  float resonator_input_[kNumVoiceBuffers][kMaxBlockSize];
+  float sympathetic_resonator_input_[kNumVoiceBuffers][kMaxBlockSize];
+  float noise_burst_buffer_[kNumVoiceBuffers][kMaxBlockSize];
+  
+  float out_buffer_[kNumVoiceBuffers][kMaxBlockSize];
+  float aux_buffer_[kNumVoiceBuffers][kMaxBlockSize];
+  
+  // Arguments of the Process() call in progress, for RenderVoice().
+  const PerformanceState* performance_state_;
+  const Patch* patch_;
+  const float* in_;
+  size_t size_;
   
-  float out_buffer_[kMaxBlockSize];
-  float aux_buffer_[kMaxBlockSize];
+  ParallelRunner* parallel_runner_;
   
   Reverb reverb_;
   Limiter limiter_;
@@ -43,6 +43,12 @@ void Resonator::Init() {
   for (int32_t i = 0; i < kMaxModes; ++i) {
     f_[i].Init();
   }
+#ifdef RESONATOR_USE_SIMD
+  for (int32_t i = 0; i < kMaxModeVectors; ++i) {
+    state_1_[i] = Float4();
+    state_2_[i] = Float4();
+  }
+#endif  // RESONATOR_USE_SIMD
 
   set_frequency(220.0f / kSampleRate);
   set_structure(0.25f);
@@ -51,13 +57,40 @@ void Resonator::Init() {
   set_position(0.999f);
   previous_position_ = 0.0f;
   set_resolution(kMaxModes);
+  
+  // Forces an update on the first block.
+  StartFilterUpdate();
+  update_.resolution = -1;
+  num_modes_ = 0;
+  modes_per_update_ = kMaxModes;
+  num_updates_ = 0;
+  num_skipped_updates_ = 0;
 }
 
-int32_t Resonator::ComputeFilters() {
-  float stiffness = Interpolate(lut_stiffness, structure_, 256.0f);
-  float harmonic = frequency_;
-  float stretch_factor = 1.0f; 
-  float q = 500.0f * Interpolate(
+bool Resonator::dirty() const {
+  const FilterUpdate& u = update_;
+  return fabsf(frequency_ - u.frequency) > \
+          u.frequency * kResonatorFrequencyThreshold ||
+      fabsf(structure_ - u.structure) > kResonatorParameterThreshold ||
+      fabsf(brightness_ - u.brightness) > kResonatorParameterThreshold ||
+      fabsf(damping_ - u.damping) > kResonatorParameterThreshold ||
+      resolution_ != u.resolution;
+}
+
+void Resonator::StartFilterUpdate() {
+  FilterUpdate* u = &update_;
+  u->frequency = frequency_;
+  u->structure = structure_;
+  u->brightness = brightness_;
+  u->damping = damping_;
+  u->resolution = resolution_;
+  
+  u->mode = 0;
+  u->num_modes = 0;
+  u->stiffness = Interpolate(lut_stiffness, structure_, 256.0f);
+  u->harmonic = frequency_;
+  u->stretch_factor = 1.0f;
+  u->q = 500.0f * Interpolate(
       lut_4_decades,
       damping_,
       256.0f);
@@ -68,15 +101,27 @@ int32_t Resonator::ComputeFilters() {
   brightness_attenuation *= brightness_attenuation;
   brightness_attenuation *= brightness_attenuation;
   float brightness = brightness_ * (1.0f - 0.2f * brightness_attenuation);
-  float q_loss = brightness * (2.0f - brightness) * 0.85f + 0.15f;
-  float q_loss_damping_rate = structure_ * (2.0f - structure_) * 0.1f;
-  int32_t num_modes = 0;
-  for (int32_t i = 0; i < min(kMaxModes, resolution_); ++i) {
+  u->q_loss = brightness * (2.0f - brightness) * 0.85f + 0.15f;
+  u->q_loss_damping_rate = structure_ * (2.0f - structure_) * 0.1f;
+}
+
+void Resonator::ContinueFilterUpdate(int32_t num_modes) {
+  FilterUpdate* u = &update_;
+  float stiffness = u->stiffness;
+  float harmonic = u->harmonic;
+  float stretch_factor = u->stretch_factor;
+  float q = u->q;
+  float q_loss = u->q_loss;
+  const float q_loss_damping_rate = u->q_loss_damping_rate;
+  const float frequency = u->frequency;
+  
+  int32_t end = min(min(kMaxModes, u->resolution), u->mode + num_modes);
+  for (int32_t i = u->mode; i < end; ++i) {
     float partial_frequency = harmonic * stretch_factor;
     if (partial_frequency >= 0.49f) {
       partial_frequency = 0.49f;
     } else {
-      num_modes = i + 1;
+      u->num_modes = i + 1;
     }
     f_[i].set_f_q<FREQUENCY_FAST>(
         partial_frequency,
@@ -91,14 +136,54 @@ int32_t Resonator::ComputeFilters() {
     }
     // This prevents the highest partials from decaying too fast.
     q_loss += q_loss_damping_rate * (1.0f - q_loss);
-    harmonic += frequency_;
+    harmonic += frequency;
     q *= q_loss;
   }
   
-  return num_modes;
+  u->mode = end;
+  u->stiffness = stiffness;
+  u->harmonic = harmonic;
+  u->stretch_factor = stretch_factor;
+  u->q = q;
+  u->q_loss = q_loss;
+}
+
+int32_t Resonator::ComputeFilters() {
+  bool done = update_.mode >= min(kMaxModes, update_.resolution);
+  if (done) {
+    if (!dirty()) {
+      ++num_skipped_updates_;
+      return num_modes_;
+    }
+    StartFilterUpdate();
+  }
+  ++num_updates_;
+  ContinueFilterUpdate(modes_per_update_);
+  
+  done = update_.mode >= min(kMaxModes, update_.resolution);
+  if (done) {
+    num_modes_ = update_.num_modes;
+  } else {
+    // Modes above the ones updated so far keep their previous coefficients.
+    num_modes_ = max(num_modes_, update_.num_modes);
+  }
+  return num_modes_;
+}
+
+void Resonator::Process(
+    const float* in,
+    float* out,
+    float* aux,
+    size_t size) {
+  Process<kResonatorBackend>(in, out, aux, size);
 }
 
-void Resonator::Process(const float* in, float* out, float* aux, size_t size) {
+template<>
+void Resonator::Process<RESONATOR_BACKEND_SCALAR>(
+    const float* in,
+    float* out,
+    float* aux,
+    size_t size) {
   int32_t num_modes = ComputeFilters();
   
   ParameterInterpolator position(&previous_position_, position_, size);
@@ -119,4 +204,90 @@ void Resonator::Process(const float* in, float* out, float* aux, size_t size) {
   }
 }
 
+#ifdef RESONATOR_USE_SIMD
+
+template<>
+void Resonator::Process<RESONATOR_BACKEND_SIMD>(
+    const float* in,
+    float* out,
+    float* aux,
+    size_t size) {
+  const int32_t num_modes = ComputeFilters();
+  
+  // The scalar code processes the modes by pairs.
+  const int32_t num_active_modes = num_modes + (num_modes & 1);
+  const int32_t num_vectors = (num_active_modes + kSimdWidth - 1) / kSimdWidth;
+  
+  // Gather the coefficients computed by ComputeFilters() into vectors.
+  Float4 g[kMaxModeVectors];
+  Float4 r_plus_g[kMaxModeVectors];
+  Float4 h[kMaxModeVectors];
+  Int4 active[kMaxModeVectors];
+  for (int32_t i = 0; i < num_vectors; ++i) {
+    for (size_t j = 0; j < kSimdWidth; ++j) {
+      const int32_t mode = i * kSimdWidth + j;
+      const Svf& f = f_[mode];
+      g[i][j] = f.g();
+      r_plus_g[i][j] = f.r() + f.g();
+      h[i][j] = f.h();
+      active[i][j] = mode < num_active_modes ? -1 : 0;
+    }
+  }
+  
+  Float4 state_1[kMaxModeVectors];
+  Float4 state_2[kMaxModeVectors];
+  copy(&state_1_[0], &state_1_[num_vectors], &state_1[0]);
+  copy(&state_2_[0], &state_2_[num_vectors], &state_2[0]);
+  
+  ParameterInterpolator position(&previous_position_, position_, size);
+  while (size--) {
+    // Mode amplitudes follow the recurrence of CosineOscillator,
+    // u[n + 1] = c u[n] - u[n - 1], which is advanced 4 modes at a time with
+    // u[n + 4] = (c^4 - 4c^2 + 2) u[n] - u[n - 4]. After Start(), the second
+    // value of the oscillator is c / 4 (+ 0.5 offset).
+    CosineOscillator amplitudes;
+    amplitudes.Init<COSINE_OSCILLATOR_APPROXIMATE>(position.Next());
+    amplitudes.Start();
+    Float4 amplitude;
+    Float4 amplitude_next;
+    for (size_t j = 0; j < kSimdWidth; ++j) {
+      amplitude[j] = amplitudes.Next();
+    }
+    for (size_t j = 0; j < kSimdWidth; ++j) {
+      amplitude_next[j] = amplitudes.Next();
+    }
+    amplitude -= 0.5f;
+    amplitude_next -= 0.5f;
+    const float c = 4.0f * amplitude[1];
+    const float c2 = c * c;
+    const Float4 c4 = Splat(c2 * c2 - 4.0f * c2 + 2.0f);
+    Float4 amplitude_previous = c4 * amplitude - amplitude_next;
+    
+    const Float4 input = Splat(*in++ * 0.125f);
+    Float4 sum = Float4();
+    for (int32_t i = 0; i < num_vectors; ++i) {
+      // Like in the scalar code, the modes above num_modes are silent and
+      // their state is left untouched.
+      Float4 hp = (input - r_plus_g[i] * state_1[i] - state_2[i]) * h[i];
+      Float4 bp = g[i] * hp + state_1[i];
+      Float4 lp = g[i] * bp + state_2[i];
+      state_1[i] = Select(active[i], g[i] * hp + bp, state_1[i]);
+      state_2[i] = Select(active[i], g[i] * bp + lp, state_2[i]);
+      sum += Select(active[i], bp * (amplitude + 0.5f), Float4());
+      
+      const Float4 next = c4 * amplitude - amplitude_previous;
+      amplitude_previous = amplitude;
+      amplitude = next;
+    }
+    // Modes 0, 2, 4... (odd partials) go to the main output.
+    *out++ = sum[0] + sum[2];
+    *aux++ = sum[1] + sum[3];
+  }
+  
+  copy(&state_1[0], &state_1[num_vectors], &state_1_[0]);
+  copy(&state_2[0], &state_2[num_vectors], &state_2_[0]);
+}
+
+#endif  // RESONATOR_USE_SIMD
+
 }  // namespace rings
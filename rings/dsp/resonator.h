@@ -34,12 +34,37 @@
 #include <algorithm>
 
 #include "rings/dsp/dsp.h"
+#include "rings/dsp/simd.h"
 #include "stmlib/dsp/filter.h"
 #include "stmlib/dsp/delay_line.h"
 
+// On hosts with a vector unit, the modes are processed 4 at a time. The scalar
+// code is kept as the reference implementation.
+#if defined(__SSE2__) || defined(__ARM_NEON__)
+  #define RESONATOR_USE_SIMD
+#endif  // __SSE2__ || __ARM_NEON__
+
 namespace rings {
 
 const int32_t kMaxModes = 64;
+const int32_t kMaxModeVectors = kMaxModes / kSimdWidth;
+
+// The filter coefficients are recomputed only when the frequency has moved by
+// more than this ratio, or one of the other parameters by more than this
+// amount, since the last update.
+const float kResonatorFrequencyThreshold = 0.0001f;
+const float kResonatorParameterThreshold = 0.001f;
+
+enum ResonatorBackend {
+  RESONATOR_BACKEND_SCALAR,
+  RESONATOR_BACKEND_SIMD
+};
+
+#ifdef RESONATOR_USE_SIMD
+const ResonatorBackend kResonatorBackend = RESONATOR_BACKEND_SIMD;
+#else
+const ResonatorBackend kResonatorBackend = RESONATOR_BACKEND_SCALAR;
+#endif  // RESONATOR_USE_SIMD
 
 class Resonator {
  public:
@@ -47,6 +72,14 @@ class Resonator {
   ~Resonator() { }
   
   void Init();
+  
+  void Process(
+      const float* in,
+      float* out,
+      float* aux,
+      size_t size);
+  
+  template<ResonatorBackend backend>
   void Process(
       const float* in,
       float* out,
@@ -78,8 +111,41 @@ class Resonator {
     resolution_ = std::min(resolution, kMaxModes);
   }
   
+  // Limits the number of modes whose coefficients are recomputed in a block.
+  // A parameter change then takes several blocks to reach the highest modes,
+  // but the cost of a block is bounded. kMaxModes disables this.
+  inline void set_modes_per_update(int32_t modes_per_update) {
+    modes_per_update_ = std::max(modes_per_update, int32_t(2));
+  }
+  
+  inline uint32_t num_updates() const { return num_updates_; }
+  inline uint32_t num_skipped_updates() const { return num_skipped_updates_; }
+  
  private:
+  struct FilterUpdate {
+    // Parameters for which the coefficients are being computed.
+    float frequency;
+    float structure;
+    float brightness;
+    float damping;
+    int32_t resolution;
+    
+    // State of the loop over the modes, which can span several blocks.
+    int32_t mode;
+    int32_t num_modes;
+    float stiffness;
+    float harmonic;
+    float stretch_factor;
+    float q;
+    float q_loss;
+    float q_loss_damping_rate;
+  };
+  
+  bool dirty() const;
+  void StartFilterUpdate();
+  void ContinueFilterUpdate(int32_t num_modes);
   int32_t ComputeFilters();
+  
   float frequency_;
   float structure_;
   float brightness_;
@@ -89,11 +155,39 @@ class Resonator {
   
   int32_t resolution_;
   
+  FilterUpdate update_;
+  int32_t num_modes_;
+  int32_t modes_per_update_;
+  uint32_t num_updates_;
+  uint32_t num_skipped_updates_;
+  
   stmlib::Svf f_[kMaxModes];
   
+#ifdef RESONATOR_USE_SIMD
+  // Filter state for the vectorized implementation, 4 modes per vector.
+  Float4 state_1_[kMaxModeVectors];
+  Float4 state_2_[kMaxModeVectors];
+#endif  // RESONATOR_USE_SIMD
+  
   DISALLOW_COPY_AND_ASSIGN(Resonator);
 };
 
+template<>
+void Resonator::Process<RESONATOR_BACKEND_SCALAR>(
+    const float* in,
+    float* out,
+    float* aux,
+    size_t size);
+
+#ifdef RESONATOR_USE_SIMD
+template<>
+void Resonator::Process<RESONATOR_BACKEND_SIMD>(
+    const float* in,
+    float* out,
+    float* aux,
+    size_t size);
+#endif  // RESONATOR_USE_SIMD
+
 }  // namespace rings
 
 #endif  // RINGS_DSP_RESONATOR_H_
@@ -0,0 +1,133 @@
+// Copyright 2015 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// 4-lane float vectors, using the GCC vector extensions. This compiles to SSE
+// on x86 hosts, to NEON on ARMv7-A/ARMv8, and is lowered to scalar code on
+// targets without a vector unit (like the Cortex-M4).
+
+#ifndef RINGS_DSP_SIMD_H_
+#define RINGS_DSP_SIMD_H_
+
+#include "stmlib/stmlib.h"
+
+#include <cstring>
+
+namespace rings {
+
+const size_t kSimdWidth = 4;
+
+typedef float Float4 __attribute__((vector_size(16)));
+typedef int32_t Int4 __attribute__((vector_size(16)));
+typedef uint16_t UShort4 __attribute__((vector_size(8)));
+
+inline Float4 Splat(float x) {
+  return Float4() + x;
+}
+
+inline Float4 Load(const float* source) {
+  Float4 x;
+  memcpy(&x, source, sizeof(x));
+  return x;
+}
+
+inline void Store(float* destination, Float4 x) {
+  memcpy(destination, &x, sizeof(x));
+}
+
+inline Int4 Load(const int32_t* source) {
+  Int4 x;
+  memcpy(&x, source, sizeof(x));
+  return x;
+}
+
+inline void Store(int32_t* destination, Int4 x) {
+  memcpy(destination, &x, sizeof(x));
+}
+
+// Converts a comparison result into 0.0f/1.0f.
+inline Float4 Mask(Int4 condition) {
+  return condition ? Splat(1.0f) : Float4();
+}
+
+inline Float4 Select(Int4 condition, Float4 a, Float4 b) {
+  return condition ? a : b;
+}
+
+inline Int4 Select(Int4 condition, Int4 a, Int4 b) {
+  return condition ? a : b;
+}
+
+inline Float4 Min(Float4 a, Float4 b) {
+  return a < b ? a : b;
+}
+
+inline Float4 Max(Float4 a, Float4 b) {
+  return a > b ? a : b;
+}
+
+inline Float4 Abs(Float4 x) {
+  return x < 0.0f ? -x : x;
+}
+
+inline float Sum(Float4 x) {
+  return (x[0] + x[1]) + (x[2] + x[3]);
+}
+
+// Truncation towards zero, like static_cast<int32_t>.
+inline Int4 ToInt(Float4 x) {
+  return __builtin_convertvector(x, Int4);
+}
+
+inline Float4 ToFloat(Int4 x) {
+  return __builtin_convertvector(x, Float4);
+}
+
+inline Int4 Load(const uint16_t* source) {
+  UShort4 x;
+  memcpy(&x, source, sizeof(x));
+  return __builtin_convertvector(x, Int4);
+}
+
+// Wraps around, like static_cast<uint16_t>.
+inline void Store(uint16_t* destination, Int4 x) {
+  UShort4 y = __builtin_convertvector(x, UShort4);
+  memcpy(destination, &y, sizeof(y));
+}
+
+inline Float4 Reverse(Float4 x) {
+  const Int4 reverse = { 3, 2, 1, 0 };
+  return __builtin_shuffle(x, reverse);
+}
+
+// Saturates to the int16_t range, like stmlib::Clip16.
+inline Int4 SaturateInt16(Int4 x) {
+  x = x < -32768 ? -32768 : x;
+  return x > 32767 ? 32767 : x;
+}
+
+}  // namespace rings
+
+#endif  // RINGS_DSP_SIMD_H_
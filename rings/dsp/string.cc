@@ -49,6 +49,7 @@ void String::Init(bool enable_dispersion) {
   stretch_.Init();
   fir_damping_filter_.Init();
   iir_damping_filter_.Init();
+  coefficients_.Init();
   
   set_frequency(220.0f / kSampleRate);
   set_dispersion(0.25f);
@@ -61,6 +62,7 @@ void String::Init(bool enable_dispersion) {
   previous_dispersion_ = 0.0f;
   dispersion_noise_ = 0.0f;
   curved_bridge_ = 0.0f;
+  src_phase_ = 0.0f;
   previous_damping_compensation_ = 0.0f;
   
   out_sample_[0] = out_sample_[1] = 0.0f;
@@ -69,62 +71,84 @@ void String::Init(bool enable_dispersion) {
   dc_blocker_.Init(1.0f - 20.0f / kSampleRate);
 }
 
-template<bool enable_dispersion>
-void String::ProcessInternal(
-    const float* in,
-    float* out,
-    float* aux,
-    size_t size) {
-  float delay = 1.0f / frequency_;
+void ComputeStringCoefficients(
+    float frequency,
+    float brightness,
+    float damping,
+    StringCoefficients* c) {
+  float delay = 1.0f / frequency;
   CONSTRAIN(delay, 4.0f, kDelayLineSize - 4.0f);
   
   // If there is not enough delay time in the delay line, we play at the
   // lowest possible note and we upsample on the fly with a shitty linear
   // interpolator. We don't care because it's a corner case (f0 < 11.7Hz)
-  float src_ratio = delay * frequency_;
+  float src_ratio = delay * frequency;
   if (src_ratio >= 0.9999f) {
     // When we are above 11.7 Hz, we make sure that the linear interpolator
     // does not get in the way.
-    src_phase_ = 1.0f;
     src_ratio = 1.0f;
   }
-
-  float clamped_position = 0.5f - 0.98f * fabs(position_ - 0.5f);
-  
-  // Linearly interpolate all comb-related CV parameters for each sample.
-  ParameterInterpolator delay_modulation(
-      &delay_, delay, size);
-  ParameterInterpolator position_modulation(
-      &clamped_position_, clamped_position, size);
-  ParameterInterpolator dispersion_modulation(
-      &previous_dispersion_, dispersion_, size);
+  c->delay = delay;
+  c->src_ratio = src_ratio;
   
   // For damping/absorption, the interpolation is done in the filter code.
-  float lf_damping = damping_ * (2.0f - damping_);
+  float lf_damping = damping * (2.0f - damping);
   float rt60 = 0.07f * SemitonesToRatio(lf_damping * 96.0f) * kSampleRate;
   float rt60_base_2_12 = max(-120.0f * delay / src_ratio / rt60, -127.0f);
   float damping_coefficient = SemitonesToRatio(rt60_base_2_12);
-  float brightness = brightness_ * brightness_;
-  float noise_filter = SemitonesToRatio((brightness_ - 1.0f) * 48.0f);
+  float damping_brightness = brightness * brightness;
   float damping_cutoff = min(
-      24.0f + damping_ * damping_ * 48.0f + brightness_ * brightness_ * 24.0f,
+      24.0f + damping * damping * 48.0f + brightness * brightness * 24.0f,
       84.0f);
-  float damping_f = min(frequency_ * SemitonesToRatio(damping_cutoff), 0.499f);
+  float damping_f = min(frequency * SemitonesToRatio(damping_cutoff), 0.499f);
   
   // Crossfade to infinite decay.
-  if (damping_ >= 0.95f) {
-    float to_infinite = 20.0f * (damping_ - 0.95f);
+  if (damping >= 0.95f) {
+    float to_infinite = 20.0f * (damping - 0.95f);
     damping_coefficient += to_infinite * (1.0f - damping_coefficient);
-    brightness += to_infinite * (1.0f - brightness);
+    damping_brightness += to_infinite * (1.0f - damping_brightness);
     damping_f += to_infinite * (0.4999f - damping_f);
     damping_cutoff += to_infinite * (128.0f - damping_cutoff);
   }
   
-  fir_damping_filter_.Configure(damping_coefficient, brightness, size);
-  iir_damping_filter_.set_f_q<FREQUENCY_ACCURATE>(damping_f, 0.5f);
+  c->damping_coefficient = damping_coefficient;
+  c->brightness = damping_brightness;
+  c->noise_filter = SemitonesToRatio((brightness - 1.0f) * 48.0f);
+  c->damping_f = damping_f;
+  c->damping_compensation = 1.0f - Interpolate(
+      lut_svf_shift, damping_cutoff, 1.0f);
+}
+
+template<bool enable_dispersion>
+void String::ProcessInternal(
+    const float* in,
+    float* out,
+    float* aux,
+    size_t size) {
+  const StringCoefficients& c = coefficients_.Get(
+      frequency_, brightness_, damping_);
+  
+  const float src_ratio = c.src_ratio;
+  if (src_ratio == 1.0f) {
+    // The upsampler is bypassed.
+    src_phase_ = 1.0f;
+  }
+  const float noise_filter = c.noise_filter;
+  float clamped_position = 0.5f - 0.98f * fabs(position_ - 0.5f);
+  
+  // Linearly interpolate all comb-related CV parameters for each sample.
+  ParameterInterpolator delay_modulation(
+      &delay_, c.delay, size);
+  ParameterInterpolator position_modulation(
+      &clamped_position_, clamped_position, size);
+  ParameterInterpolator dispersion_modulation(
+      &previous_dispersion_, dispersion_, size);
+  
+  fir_damping_filter_.Configure(c.damping_coefficient, c.brightness, size);
+  iir_damping_filter_.set_f_q<FREQUENCY_ACCURATE>(c.damping_f, 0.5f);
   ParameterInterpolator damping_compensation_modulation(
       &previous_damping_compensation_,
-      1.0f - Interpolate(lut_svf_shift, damping_cutoff, 1.0f),
+      c.damping_compensation,
       size);
   
   while (size--) {
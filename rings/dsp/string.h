@@ -90,6 +90,63 @@ class DampingFilter {
   DISALLOW_COPY_AND_ASSIGN(DampingFilter);
 };
 
+// Block-rate coefficients of a string, derived from its parameters. Shared
+// by String and StringBank so that both render exactly the same string.
+struct StringCoefficients {
+  float delay;
+  float src_ratio;
+  float damping_coefficient;
+  float brightness;
+  float noise_filter;
+  float damping_f;
+  float damping_compensation;
+};
+
+void ComputeStringCoefficients(
+    float frequency,
+    float brightness,
+    float damping,
+    StringCoefficients* c);
+
+// The coefficients only depend on the frequency, brightness and damping of the
+// string, and are recomputed only when one of them has changed since the
+// previous block - a held note does not change them.
+class StringCoefficientCache {
+ public:
+  StringCoefficientCache() { }
+  ~StringCoefficientCache() { }
+  
+  void Init() {
+    frequency_ = -1.0f;
+    brightness_ = -1.0f;
+    damping_ = -1.0f;
+  }
+  
+  inline const StringCoefficients& Get(
+      float frequency,
+      float brightness,
+      float damping) {
+    if (frequency != frequency_ ||
+        brightness != brightness_ ||
+        damping != damping_) {
+      frequency_ = frequency;
+      brightness_ = brightness;
+      damping_ = damping;
+      ComputeStringCoefficients(
+          frequency, brightness, damping, &coefficients_);
+    }
+    return coefficients_;
+  }
+
+ private:
+  float frequency_;
+  float brightness_;
+  float damping_;
+  StringCoefficients coefficients_;
+  
+  DISALLOW_COPY_AND_ASSIGN(StringCoefficientCache);
+};
+
 typedef stmlib::DelayLine<float, kDelayLineSize> StringDelayLine;
 typedef stmlib::DelayLine<float, kDelayLineSize / 2> StiffnessDelayLine;
 
@@ -161,6 +218,8 @@ class String {
   stmlib::Svf iir_damping_filter_;
   stmlib::DCBlocker dc_blocker_;
   
+  StringCoefficientCache coefficients_;
+  
   DISALLOW_COPY_AND_ASSIGN(String);
 };
 
@@ -0,0 +1,529 @@
+// Copyright 2015 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Bank of KS strings rendered in lockstep, 4 strings per vector.
+
+#include "rings/dsp/string_bank.h"
+
+#ifdef STRING_USE_SIMD
+
+#include <algorithm>
+#include <cmath>
+
+#include "stmlib/dsp/filter.h"
+#include "stmlib/utils/random.h"
+
+namespace rings {
+
+using namespace std;
+using namespace stmlib;
+
+const float kSilence[kMaxBlockSize] = { 0.0f };
+
+void StringBank::Init(bool enable_dispersion) {
+  enable_dispersion_ = enable_dispersion;
+  
+  for (int32_t i = 0; i < kMaxBankStrings; ++i) {
+    set_frequency(i, 220.0f / kSampleRate);
+    set_dispersion(i, 0.25f);
+    set_brightness(i, 0.5f);
+    set_damping(i, 0.3f);
+    set_position(i, 0.8f);
+    coefficients_[i].Init();
+    
+    delay_[i] = 1.0f / frequency_[i];
+    delay_increment_[i] = 0.0f;
+    clamped_position_[i] = 0.0f;
+    clamped_position_increment_[i] = 0.0f;
+    previous_dispersion_[i] = 0.0f;
+    dispersion_increment_[i] = 0.0f;
+    previous_damping_compensation_[i] = 0.0f;
+    damping_compensation_increment_[i] = 0.0f;
+    
+    src_phase_[i] = 0.0f;
+    src_ratio_[i] = 1.0f;
+    out_sample_[0][i] = out_sample_[1][i] = 0.0f;
+    aux_sample_[0][i] = aux_sample_[1][i] = 0.0f;
+    
+    dispersion_noise_[i] = 0.0f;
+    noise_filter_[i] = 0.0f;
+    noise_gain_[i] = 0.0f;
+    curved_bridge_[i] = 0.0f;
+    dc_blocker_x_[i] = 0.0f;
+    dc_blocker_y_[i] = 0.0f;
+    
+    fir_x_[i] = 0.0f;
+    fir_x__[i] = 0.0f;
+    fir_brightness_[i] = 0.0f;
+    fir_brightness_increment_[i] = 0.0f;
+    fir_damping_[i] = 0.0f;
+    fir_damping_increment_[i] = 0.0f;
+    
+    iir_g_[i] = 0.0f;
+    iir_r_[i] = 0.0f;
+    iir_h_[i] = 0.0f;
+    iir_state_1_[i] = 0.0f;
+    iir_state_2_[i] = 0.0f;
+    
+    // Strings that are never prepared render silence.
+    in_[i] = kSilence;
+    out_[i] = NULL;
+    aux_[i] = NULL;
+    
+    write_ptr_[i] = 0;
+    stretch_write_ptr_[i] = 0;
+    fill(&string_[i][0], &string_[i][kDelayLineSize + kSimdWidth], 0.0f);
+    fill(&stretch_[i][0], &stretch_[i][kDelayLineSize / 2 + kSimdWidth], 0.0f);
+  }
+  for (size_t i = 0; i < kMaxBlockSize; ++i) {
+    fill(&noise_[i][0], &noise_[i][kMaxBankStrings], 0.0f);
+  }
+}
+
+void StringBank::Prepare(
+    int32_t string,
+    const float* in,
+    float* out,
+    float* aux,
+    size_t size) {
+  const int32_t i = string;
+  
+  const StringCoefficients& c = coefficients_[i].Get(
+      frequency_[i], brightness_[i], damping_[i]);
+  float clamped_position = 0.5f - 0.98f * fabs(position_[i] - 0.5f);
+  
+  src_ratio_[i] = c.src_ratio;
+  if (c.src_ratio == 1.0f) {
+    src_phase_[i] = 1.0f;
+  }
+  
+  // Same increments as stmlib::ParameterInterpolator and DampingFilter.
+  const float count = static_cast<float>(size);
+  delay_increment_[i] = (c.delay - delay_[i]) / count;
+  clamped_position_increment_[i] = \
+      (clamped_position - clamped_position_[i]) / count;
+  dispersion_increment_[i] = \
+      (dispersion_[i] - previous_dispersion_[i]) / count;
+  damping_compensation_increment_[i] = \
+      (c.damping_compensation - previous_damping_compensation_[i]) / count;
+  
+  const float step = 1.0f / count;
+  fir_damping_increment_[i] = (c.damping_coefficient - fir_damping_[i]) * step;
+  fir_brightness_increment_[i] = (c.brightness - fir_brightness_[i]) * step;
+  
+  Svf iir_damping_filter;
+  iir_damping_filter.set_f_q<FREQUENCY_ACCURATE>(c.damping_f, 0.5f);
+  iir_g_[i] = iir_damping_filter.g();
+  iir_r_[i] = iir_damping_filter.r();
+  iir_h_[i] = iir_damping_filter.h();
+  
+  noise_filter_[i] = c.noise_filter;
+  noise_gain_[i] = 1.0f / (0.2f + c.noise_filter);
+  if (enable_dispersion_) {
+    // String draws a random number each time the upsampler ticks.
+    float src_phase = src_phase_[i];
+    for (size_t j = 0; j < size; ++j) {
+      src_phase += c.src_ratio;
+      if (src_phase > 1.0f) {
+        src_phase -= 1.0f;
+        noise_[j][i] = 2.0f * Random::GetFloat() - 1.0f;
+      }
+    }
+  }
+  
+  in_[i] = in;
+  out_[i] = out;
+  aux_[i] = aux;
+}
+
+void StringBank::Process(int32_t num_strings, size_t size) {
+  for (int32_t first = 0; first < num_strings; first += kSimdWidth) {
+    int32_t n = min(num_strings - first, static_cast<int32_t>(kSimdWidth));
+    bool upsample = false;
+    for (size_t j = 0; j < kSimdWidth; ++j) {
+      upsample = upsample || src_ratio_[first + j] != 1.0f;
+    }
+    if (enable_dispersion_) {
+      if (upsample) {
+        ProcessVector<true, true>(first, n, size);
+      } else {
+        ProcessVector<true, false>(first, n, size);
+      }
+    } else {
+      if (upsample) {
+        ProcessVector<false, true>(first, n, size);
+      } else {
+        ProcessVector<false, false>(first, n, size);
+      }
+    }
+  }
+}
+
+namespace {
+
+inline Float4 Gather(float* const* lines, Int4 index) {
+  Float4 x = {
+    lines[0][index[0]], lines[1][index[1]],
+    lines[2][index[2]], lines[3][index[3]]
+  };
+  return x;
+}
+
+inline Float4 Gather(const float* const* buffers, size_t i) {
+  Float4 x = { buffers[0][i], buffers[1][i], buffers[2][i], buffers[3][i] };
+  return x;
+}
+
+// Transposes the 4 rows of samples read from 4 delay lines.
+inline void Transpose(Float4* x) {
+  const Int4 low = { 0, 4, 1, 5 };
+  const Int4 high = { 2, 6, 3, 7 };
+  const Int4 first_halves = { 0, 1, 4, 5 };
+  const Int4 second_halves = { 2, 3, 6, 7 };
+  Float4 t0 = __builtin_shuffle(x[0], x[1], low);
+  Float4 t1 = __builtin_shuffle(x[2], x[3], low);
+  Float4 t2 = __builtin_shuffle(x[0], x[1], high);
+  Float4 t3 = __builtin_shuffle(x[2], x[3], high);
+  x[0] = __builtin_shuffle(t0, t1, first_halves);
+  x[1] = __builtin_shuffle(t0, t1, second_halves);
+  x[2] = __builtin_shuffle(t2, t3, first_halves);
+  x[3] = __builtin_shuffle(t2, t3, second_halves);
+}
+
+// Reads 4 consecutive samples from each delay line, starting at index, and
+// returns them as 4 vectors of 4 strings.
+inline void ReadRows(float* const* lines, Int4 index, Float4* x) {
+  for (size_t j = 0; j < kSimdWidth; ++j) {
+    x[j] = Load(&lines[j][index[j]]);
+  }
+  Transpose(x);
+}
+
+// stmlib::DelayLine::ReadHermite, for 4 delay lines.
+template<size_t max_delay>
+inline Float4 ReadHermite(float* const* lines, Int4 write_ptr, Float4 delay) {
+  const Int4 mask = Int4() + static_cast<int32_t>(max_delay - 1);
+  Int4 delay_integral = ToInt(delay);
+  Float4 delay_fractional = delay - ToFloat(delay_integral);
+  Int4 t = write_ptr + delay_integral + static_cast<int32_t>(max_delay);
+  Float4 x[4];
+  ReadRows(lines, (t - 1) & mask, x);
+  const Float4 xm1 = x[0];
+  const Float4 x0 = x[1];
+  const Float4 x1 = x[2];
+  const Float4 x2 = x[3];
+  const Float4 c = (x1 - xm1) * 0.5f;
+  const Float4 v = x0 - x1;
+  const Float4 w = c + v;
+  const Float4 a = w + v + (x2 - x0) * 0.5f;
+  const Float4 b_neg = w + a;
+  const Float4 f = delay_fractional;
+  return (((a * f) - b_neg) * f + c) * f + x0;
+}
+
+// stmlib::DelayLine::Read(float), for 4 delay lines.
+template<size_t max_delay>
+inline Float4 Read(float* const* lines, Int4 write_ptr, Float4 delay) {
+  const Int4 mask = Int4() + static_cast<int32_t>(max_delay - 1);
+  Int4 delay_integral = ToInt(delay);
+  Float4 delay_fractional = delay - ToFloat(delay_integral);
+  Float4 x[4];
+  ReadRows(lines, (write_ptr + delay_integral) & mask, x);
+  const Float4 a = x[0];
+  const Float4 b = x[1];
+  return a + (b - a) * delay_fractional;
+}
+
+// Writes the strings for which write is set, and moves their write pointer.
+// The first samples of the line are mirrored past its end, so that ReadRows
+// never has to wrap around.
+template<size_t max_delay>
+inline Int4 Write(float* const* lines, Int4 write_ptr, Float4 x, Int4 write) {
+  const Int4 mask = Int4() + static_cast<int32_t>(max_delay - 1);
+  for (size_t j = 0; j < kSimdWidth; ++j) {
+    if (write[j]) {
+      lines[j][write_ptr[j]] = x[j];
+      if (write_ptr[j] < static_cast<int32_t>(kSimdWidth)) {
+        lines[j][max_delay + write_ptr[j]] = x[j];
+      }
+    }
+  }
+  return Select(write, (write_ptr - 1) & mask, write_ptr);
+}
+
+// Reads a block from each of 4 buffers, as one vector per sample.
+inline void Interleave(const float* const* rows, size_t size, Float4* columns) {
+  size_t i = 0;
+  for (; i + kSimdWidth <= size; i += kSimdWidth) {
+    Float4* x = &columns[i];
+    for (size_t j = 0; j < kSimdWidth; ++j) {
+      x[j] = Load(&rows[j][i]);
+    }
+    Transpose(x);
+  }
+  for (; i < size; ++i) {
+    columns[i] = Gather(rows, i);
+  }
+}
+
+// Adds one vector per sample to the first num_rows of 4 buffers, in
+// ascending order when several of them are the same buffer.
+inline void Deinterleave(
+    Float4* columns,
+    size_t size,
+    int32_t num_rows,
+    float* const* rows) {
+  size_t i = 0;
+  for (; i + kSimdWidth <= size; i += kSimdWidth) {
+    Float4* x = &columns[i];
+    Transpose(x);
+    for (int32_t j = 0; j < num_rows; ++j) {
+      Store(&rows[j][i], Load(&rows[j][i]) + x[j]);
+    }
+  }
+  for (; i < size; ++i) {
+    for (int32_t j = 0; j < num_rows; ++j) {
+      rows[j][i] += columns[i][j];
+    }
+  }
+}
+
+// When upsampling, the state of a string only moves when its upsampler ticks.
+template<bool upsample>
+inline void Update(Int4 tick, Float4 value, Float4* state) {
+  *state = upsample ? Select(tick, value, *state) : value;
+}
+
+}  // namespace
+
+template<bool enable_dispersion, bool upsample>
+void StringBank::ProcessVector(
+    int32_t first,
+    int32_t num_strings,
+    size_t size) {
+  const Float4 one = Splat(1.0f);
+  const Float4 zero = Float4();
+  
+  Float4 delay = Load(&delay_[first]);
+  const Float4 delay_increment = Load(&delay_increment_[first]);
+  Float4 clamped_position = Load(&clamped_position_[first]);
+  const Float4 clamped_position_increment = Load(
+      &clamped_position_increment_[first]);
+  Float4 dispersion = Load(&previous_dispersion_[first]);
+  const Float4 dispersion_increment = Load(&dispersion_increment_[first]);
+  Float4 damping_compensation = Load(&previous_damping_compensation_[first]);
+  const Float4 damping_compensation_increment = Load(
+      &damping_compensation_increment_[first]);
+  
+  Float4 src_phase = Load(&src_phase_[first]);
+  const Float4 src_ratio = Load(&src_ratio_[first]);
+  Float4 out_sample_0 = Load(&out_sample_[0][first]);
+  Float4 out_sample_1 = Load(&out_sample_[1][first]);
+  Float4 aux_sample_0 = Load(&aux_sample_[0][first]);
+  Float4 aux_sample_1 = Load(&aux_sample_[1][first]);
+  
+  Float4 dispersion_noise = Load(&dispersion_noise_[first]);
+  const Float4 noise_filter = Load(&noise_filter_[first]);
+  const Float4 noise_gain = Load(&noise_gain_[first]);
+  Float4 curved_bridge = Load(&curved_bridge_[first]);
+  Float4 dc_blocker_x = Load(&dc_blocker_x_[first]);
+  Float4 dc_blocker_y = Load(&dc_blocker_y_[first]);
+  const Float4 dc_blocker_pole = Splat(1.0f - 20.0f / kSampleRate);
+  
+  Float4 fir_x = Load(&fir_x_[first]);
+  Float4 fir_xx = Load(&fir_x__[first]);
+  Float4 fir_brightness = Load(&fir_brightness_[first]);
+  const Float4 fir_brightness_increment = Load(
+      &fir_brightness_increment_[first]);
+  Float4 fir_damping = Load(&fir_damping_[first]);
+  const Float4 fir_damping_increment = Load(&fir_damping_increment_[first]);
+  
+  const Float4 iir_g = Load(&iir_g_[first]);
+  const Float4 iir_r = Load(&iir_r_[first]);
+  const Float4 iir_h = Load(&iir_h_[first]);
+  Float4 iir_state_1 = Load(&iir_state_1_[first]);
+  Float4 iir_state_2 = Load(&iir_state_2_[first]);
+  
+  Int4 write_ptr = Load(&write_ptr_[first]);
+  Int4 stretch_write_ptr = Load(&stretch_write_ptr_[first]);
+  
+  float* lines[kSimdWidth];
+  float* stretch_lines[kSimdWidth];
+  for (size_t j = 0; j < kSimdWidth; ++j) {
+    lines[j] = string_[first + j];
+    stretch_lines[j] = stretch_[first + j];
+  }
+  
+  Float4 in[kMaxBlockSize];
+  Float4 out[kMaxBlockSize];
+  Float4 aux[kMaxBlockSize];
+  Interleave(&in_[first], size, in);
+  
+  // Without upsampling, every string ticks on every sample and the phase
+  // stays at 1.
+  Int4 tick = Int4() == Int4();
+  for (size_t i = 0; i < size; ++i) {
+    if (upsample) {
+      src_phase += src_ratio;
+      tick = src_phase > one;
+      src_phase = Select(tick, src_phase - one, src_phase);
+    }
+    
+    Float4 next_delay = delay + delay_increment;
+    Float4 next_clamped_position = clamped_position + \
+        clamped_position_increment;
+    Update<upsample>(tick, next_delay, &delay);
+    Update<upsample>(tick, next_clamped_position, &clamped_position);
+    
+    Float4 d = next_delay;
+    Float4 comb_delay = d * next_clamped_position;
+#ifndef MIC_W
+    Float4 next_damping_compensation = damping_compensation + \
+        damping_compensation_increment;
+    Update<upsample>(tick, next_damping_compensation, &damping_compensation);
+    d = d * next_damping_compensation;  // IIR delay.
+#endif  // MIC_W
+    d = d - one;  // FIR delay.
+    
+    Float4 s;
+    if (enable_dispersion) {
+      Float4 n = Load(&noise_[i][first]) * noise_gain;
+      Float4 next_dispersion_noise = dispersion_noise + \
+          noise_filter * (n - dispersion_noise);
+      Update<upsample>(tick, next_dispersion_noise, &dispersion_noise);
+      
+      Float4 x = dispersion + dispersion_increment;
+      Update<upsample>(tick, x, &dispersion);
+      Float4 stretch_point = Select(
+          x <= zero, zero, x * (2.0f - x) * 0.475f);
+      Float4 noise_amount = Select(x > 0.75f, 4.0f * (x - 0.75f), zero);
+      Float4 bridge_curving = Select(x < zero, -x, zero);
+      
+      noise_amount = noise_amount * noise_amount * 0.025f;
+      Float4 ac_blocking_amount = bridge_curving;
+      
+      bridge_curving = bridge_curving * bridge_curving * 0.01f;
+      Float4 ap_gain = -0.618f * x / (0.15f + Abs(x));
+      
+      Float4 delay_fm = one;
+      delay_fm += next_dispersion_noise * noise_amount;
+      delay_fm -= curved_bridge * bridge_curving;
+      d = d * delay_fm;
+      
+      Float4 ap_delay = d * stretch_point;
+      Float4 main_delay = d - ap_delay;
+      Int4 allpass = (ap_delay >= 4.0f) & (main_delay >= 4.0f);
+      s = ReadHermite<kDelayLineSize>(
+          lines, write_ptr, Select(allpass, main_delay, d));
+      
+      // StiffnessDelayLine::Allpass.
+      const Int4 stretch_mask = Int4() + \
+          static_cast<int32_t>(kDelayLineSize / 2 - 1);
+      Float4 ap_read = Gather(
+          stretch_lines,
+          (stretch_write_ptr + ToInt(ap_delay)) & stretch_mask);
+      Float4 ap_write = s + ap_gain * ap_read;
+      stretch_write_ptr = Write<kDelayLineSize / 2>(
+          stretch_lines, stretch_write_ptr, ap_write, allpass & tick);
+      s = Select(allpass, -ap_write * ap_gain + ap_read, s);
+      
+      Float4 s_ac = dc_blocker_y * dc_blocker_pole + s - dc_blocker_x;
+      Update<upsample>(tick, s, &dc_blocker_x);
+      Update<upsample>(tick, s_ac, &dc_blocker_y);
+      s += ac_blocking_amount * (s_ac - s);
+      
+      Float4 value = Abs(s) - 0.025f;
+      Float4 sign = Select(s > zero, one, Splat(-1.5f));
+      Update<upsample>(tick, (Abs(value) + value) * sign, &curved_bridge);
+    } else {
+      s = ReadHermite<kDelayLineSize>(lines, write_ptr, d);
+    }
+    
+    s += in[i];
+    
+    // DampingFilter.
+    Float4 h0 = (one + fir_brightness) * 0.5f;
+    Float4 h1 = (one - fir_brightness) * 0.25f;
+    Float4 y = fir_damping * (h0 * fir_x + h1 * (s + fir_xx));
+    Update<upsample>(tick, fir_x, &fir_xx);
+    Update<upsample>(tick, s, &fir_x);
+    Update<upsample>(
+        tick, fir_brightness + fir_brightness_increment, &fir_brightness);
+    Update<upsample>(tick, fir_damping + fir_damping_increment, &fir_damping);
+    s = y;
+    
+#ifndef MIC_W
+    // Svf, low-pass.
+    Float4 hp = (s - iir_r * iir_state_1 - iir_g * iir_state_1 - iir_state_2) \
+        * iir_h;
+    Float4 bp = iir_g * hp + iir_state_1;
+    Float4 lp = iir_g * bp + iir_state_2;
+    Update<upsample>(tick, iir_g * hp + bp, &iir_state_1);
+    Update<upsample>(tick, iir_g * bp + lp, &iir_state_2);
+    s = lp;
+#endif  // MIC_W
+    
+    write_ptr = Write<kDelayLineSize>(lines, write_ptr, s, tick);
+    Float4 aux_sample = Read<kDelayLineSize>(lines, write_ptr, comb_delay);
+    
+    Update<upsample>(tick, out_sample_0, &out_sample_1);
+    Update<upsample>(tick, aux_sample_0, &aux_sample_1);
+    Update<upsample>(tick, s, &out_sample_0);
+    Update<upsample>(tick, aux_sample, &aux_sample_0);
+    
+    // Crossfade(out_sample_[1], out_sample_[0], src_phase_).
+    out[i] = out_sample_1 + (out_sample_0 - out_sample_1) * src_phase;
+    aux[i] = aux_sample_1 + (aux_sample_0 - aux_sample_1) * src_phase;
+  }
+  Deinterleave(out, size, num_strings, &out_[first]);
+  Deinterleave(aux, size, num_strings, &aux_[first]);
+  
+  Store(&delay_[first], delay);
+  Store(&clamped_position_[first], clamped_position);
+  Store(&previous_dispersion_[first], dispersion);
+  Store(&previous_damping_compensation_[first], damping_compensation);
+  Store(&src_phase_[first], src_phase);
+  Store(&out_sample_[0][first], out_sample_0);
+  Store(&out_sample_[1][first], out_sample_1);
+  Store(&aux_sample_[0][first], aux_sample_0);
+  Store(&aux_sample_[1][first], aux_sample_1);
+  Store(&dispersion_noise_[first], dispersion_noise);
+  Store(&curved_bridge_[first], curved_bridge);
+  Store(&dc_blocker_x_[first], dc_blocker_x);
+  Store(&dc_blocker_y_[first], dc_blocker_y);
+  Store(&fir_x_[first], fir_x);
+  Store(&fir_x__[first], fir_xx);
+  Store(&fir_brightness_[first], fir_brightness);
+  Store(&fir_damping_[first], fir_damping);
+  Store(&iir_state_1_[first], iir_state_1);
+  Store(&iir_state_2_[first], iir_state_2);
+  Store(&write_ptr_[first], write_ptr);
+  Store(&stretch_write_ptr_[first], stretch_write_ptr);
+}
+
+}  // namespace rings
+
+#endif  // STRING_USE_SIMD
@@ -0,0 +1,176 @@
+// Copyright 2015 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Bank of KS strings rendered in lockstep, 4 strings per vector.
+
+#ifndef RINGS_DSP_STRING_BANK_H_
+#define RINGS_DSP_STRING_BANK_H_
+
+#include "stmlib/stmlib.h"
+
+#include "rings/dsp/dsp.h"
+#include "rings/dsp/simd.h"
+#include "rings/dsp/string.h"
+
+// Only hosts with a vector unit render strings in banks. The firmware keeps
+// rendering them one at a time with String.
+#if defined(__SSE2__) || defined(__ARM_NEON__)
+  #define STRING_USE_SIMD
+#endif  // __SSE2__ || __ARM_NEON__
+
+#ifdef STRING_USE_SIMD
+
+namespace rings {
+
+const int32_t kMaxBankStrings = 8;
+
+// Renders up to kMaxBankStrings strings, with the same output as that many
+// String objects. The damping filters, interpolated parameters and read
+// positions are kept as structures of arrays and updated one vector of 4
+// strings at a time; only the delay line reads and writes are done string by
+// string.
+class StringBank {
+ public:
+  StringBank() { }
+  ~StringBank() { }
+  
+  void Init(bool enable_dispersion);
+  
+  // Computes the coefficients of a string for the next block, and sets the
+  // buffers it reads from and adds to. With dispersion, this also draws the
+  // random numbers the string will use during the block, so the strings must
+  // be prepared in the order in which String::Process would have been called
+  // to consume the same random sequence. For the same reason, strings with
+  // dispersion must not be prepared from several threads at once.
+  void Prepare(
+      int32_t string,
+      const float* in,
+      float* out,
+      float* aux,
+      size_t size);
+  
+  // Renders strings 0 to num_strings - 1. Strings sharing an output buffer are
+  // added to it in ascending order. Does not draw any random number, so
+  // different banks can be processed in parallel.
+  void Process(int32_t num_strings, size_t size);
+  
+  inline void set_frequency(int32_t string, float frequency) {
+    frequency_[string] = frequency;
+  }
+
+  inline void set_frequency(
+      int32_t string,
+      float frequency,
+      float coefficient) {
+    frequency_[string] += coefficient * (frequency - frequency_[string]);
+  }
+
+  inline void set_dispersion(int32_t string, float dispersion) {
+    dispersion_[string] = dispersion;
+  }
+  
+  inline void set_brightness(int32_t string, float brightness) {
+    brightness_[string] = brightness;
+  }
+  
+  inline void set_damping(int32_t string, float damping) {
+    damping_[string] = damping;
+  }
+  
+  inline void set_position(int32_t string, float position) {
+    position_[string] = position;
+  }
+  
+ private:
+  template<bool enable_dispersion, bool upsample>
+  void ProcessVector(int32_t first, int32_t num_strings, size_t size);
+  
+  float frequency_[kMaxBankStrings];
+  float dispersion_[kMaxBankStrings];
+  float brightness_[kMaxBankStrings];
+  float damping_[kMaxBankStrings];
+  float position_[kMaxBankStrings];
+  
+  bool enable_dispersion_;
+  StringCoefficientCache coefficients_[kMaxBankStrings];
+  
+  // Interpolated parameters, and their increment during the current block.
+  float delay_[kMaxBankStrings];
+  float delay_increment_[kMaxBankStrings];
+  float clamped_position_[kMaxBankStrings];
+  float clamped_position_increment_[kMaxBankStrings];
+  float previous_dispersion_[kMaxBankStrings];
+  float dispersion_increment_[kMaxBankStrings];
+  float previous_damping_compensation_[kMaxBankStrings];
+  float damping_compensation_increment_[kMaxBankStrings];
+  
+  float src_phase_[kMaxBankStrings];
+  float src_ratio_[kMaxBankStrings];
+  float out_sample_[2][kMaxBankStrings];
+  float aux_sample_[2][kMaxBankStrings];
+  
+  float dispersion_noise_[kMaxBankStrings];
+  float noise_filter_[kMaxBankStrings];
+  float noise_gain_[kMaxBankStrings];
+  float noise_[kMaxBlockSize][kMaxBankStrings];
+  float curved_bridge_[kMaxBankStrings];
+  float dc_blocker_x_[kMaxBankStrings];
+  float dc_blocker_y_[kMaxBankStrings];
+  
+  // DampingFilter.
+  float fir_x_[kMaxBankStrings];
+  float fir_x__[kMaxBankStrings];
+  float fir_brightness_[kMaxBankStrings];
+  float fir_brightness_increment_[kMaxBankStrings];
+  float fir_damping_[kMaxBankStrings];
+  float fir_damping_increment_[kMaxBankStrings];
+  
+  // Low-pass stmlib::Svf.
+  float iir_g_[kMaxBankStrings];
+  float iir_r_[kMaxBankStrings];
+  float iir_h_[kMaxBankStrings];
+  float iir_state_1_[kMaxBankStrings];
+  float iir_state_2_[kMaxBankStrings];
+  
+  const float* in_[kMaxBankStrings];
+  float* out_[kMaxBankStrings];
+  float* aux_[kMaxBankStrings];
+  
+  // Same indexing as StringDelayLine and StiffnessDelayLine, with the first
+  // kSimdWidth samples repeated at the end.
+  int32_t write_ptr_[kMaxBankStrings];
+  int32_t stretch_write_ptr_[kMaxBankStrings];
+  float string_[kMaxBankStrings][kDelayLineSize + kSimdWidth];
+  float stretch_[kMaxBankStrings][kDelayLineSize / 2 + kSimdWidth];
+  
+  DISALLOW_COPY_AND_ASSIGN(StringBank);
+};
+
+}  // namespace rings
+
+#endif  // STRING_USE_SIMD
+
+#endif  // RINGS_DSP_STRING_BANK_H_
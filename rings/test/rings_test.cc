@@ -13,17 +13,23 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <cstring>
 #include <cstdlib>
+#include <ctime>
+#include <vector>
 #include <xmmintrin.h>
 
 #include "rings/dsp/part.h"
+#include "rings/dsp/resonator.h"
+#include "rings/dsp/string_bank.h"
 #include "rings/dsp/onset_detector.h"
 #include "rings/dsp/string_synth_part.h"
 #include "rings/dsp/string_synth_oscillator.h"
 #include "rings/dsp/string_synth_voice.h"
+#include "rings/test/worker_pool.h"
 
 #include "stmlib/test/wav_writer.h"
 #include "stmlib/dsp/units.h"
@@ -556,6 +562,338 @@ void TestStringSynthPart() {
   }
 }
 
+void CompareResonatorBackends() {
+#ifdef RESONATOR_USE_SIMD
+  const size_t kDuration = 10;
+  
+  Resonator scalar;
+  Resonator simd;
+  Resonator* resonators[2] = { &scalar, &simd };
+  double time[2] = { 0.0, 0.0 };
+  float max_error = 0.0f;
+  float max_value = 0.0f;
+  
+  for (size_t r = 0; r < 2; ++r) {
+    resonators[r]->Init();
+  }
+  
+  for (uint32_t i = 0; i < ::kSampleRate * kDuration; i += kAudioBlockSize) {
+    float in[kAudioBlockSize];
+    float out[2][kAudioBlockSize];
+    float aux[2][kAudioBlockSize];
+    for (size_t j = 0; j < kAudioBlockSize; ++j) {
+      in[j] = (i + j) % 12000 == 0 ? 1.0f : 0.0f;
+    }
+    float t = static_cast<float>(i) / (::kSampleRate * kDuration);
+    // The frequency goes up, then down, so that the highest modes are
+    // dropped, then brought back.
+    float sweep = t < 0.5f ? 2.0f * t : 2.0f - 2.0f * t;
+    for (size_t r = 0; r < 2; ++r) {
+      Resonator* resonator = resonators[r];
+      resonator->set_frequency(
+          SemitonesToRatio(-24.0f + 60.0f * sweep) * 0.01f);
+      resonator->set_structure(t);
+      resonator->set_brightness(0.3f + 0.5f * t);
+      resonator->set_damping(0.8f);
+      resonator->set_position(0.2f + 0.6f * t);
+      clock_t start = clock();
+      if (r == 0) {
+        resonator->Process<RESONATOR_BACKEND_SCALAR>(
+            in, out[r], aux[r], kAudioBlockSize);
+      } else {
+        resonator->Process<RESONATOR_BACKEND_SIMD>(
+            in, out[r], aux[r], kAudioBlockSize);
+      }
+      time[r] += clock() - start;
+    }
+    for (size_t j = 0; j < kAudioBlockSize; ++j) {
+      max_error = std::max(max_error, fabsf(out[0][j] - out[1][j]));
+      max_error = std::max(max_error, fabsf(aux[0][j] - aux[1][j]));
+      max_value = std::max(max_value, fabsf(out[0][j]));
+    }
+  }
+  printf(
+      "scalar: %.2fx realtime\tsimd: %.2fx realtime\terror: %g (peak %g)\n",
+      kDuration / (time[0] / CLOCKS_PER_SEC),
+      kDuration / (time[1] / CLOCKS_PER_SEC),
+      max_error,
+      max_value);
+#endif  // RESONATOR_USE_SIMD
+}
+
+void CompareStringBackends() {
+#ifdef STRING_USE_SIMD
+  const size_t kDuration = 10;
+  const int32_t kNumStrings[] = { 4, 8 };
+  
+  static String strings[kMaxBankStrings];
+  static StringBank bank;
+  
+  printf("strings\tdispersion\tscalar\tbank\terror\n");
+  for (size_t d = 0; d < 2; ++d) {
+    for (size_t n = 0; n < 2; ++n) {
+      const int32_t num_strings = kNumStrings[n];
+      double time[2] = { 0.0, 0.0 };
+      float max_error = 0.0f;
+      float max_value = 0.0f;
+      
+      for (int32_t i = 0; i < num_strings; ++i) {
+        strings[i].Init(d == 1);
+      }
+      bank.Init(d == 1);
+      
+      std::vector<float> reference;
+      std::vector<float> reference_aux;
+      uint32_t seed = Random::GetWord();
+      for (size_t b = 0; b < 2; ++b) {
+        Random::Seed(seed);
+        std::vector<float> out(::kSampleRate * kDuration);
+        std::vector<float> aux(::kSampleRate * kDuration);
+        for (uint32_t i = 0; i < out.size(); i += kAudioBlockSize) {
+          float in[kAudioBlockSize];
+          for (size_t j = 0; j < kAudioBlockSize; ++j) {
+            in[j] = (i + j) % 12000 < 10 ? 0.5f : 0.0f;
+          }
+          float t = static_cast<float>(i) / out.size();
+          clock_t start = clock();
+          for (int32_t k = 0; k < num_strings; ++k) {
+            // The last string is below 11.7 Hz, and goes through the
+            // upsampler.
+            float note = k == num_strings - 1
+                ? -40.0f
+                : 36.0f + 5.0f * k + 12.0f * t;
+            float frequency = SemitonesToRatio(note - 69.0f) * a3;
+            float dispersion = 2.0f * t - 1.0f;
+            float brightness = 0.3f + 0.5f * t;
+            float damping = 0.5f + 0.05f * k;
+            float position = 0.2f + 0.6f * t;
+            if (b == 0) {
+              strings[k].set_dispersion(dispersion);
+              strings[k].set_frequency(frequency, 0.5f);
+              strings[k].set_brightness(brightness);
+              strings[k].set_damping(damping);
+              strings[k].set_position(position);
+              strings[k].Process(in, &out[i], &aux[i], kAudioBlockSize);
+            } else {
+              bank.set_dispersion(k, dispersion);
+              bank.set_frequency(k, frequency, 0.5f);
+              bank.set_brightness(k, brightness);
+              bank.set_damping(k, damping);
+              bank.set_position(k, position);
+              bank.Prepare(k, in, &out[i], &aux[i], kAudioBlockSize);
+            }
+          }
+          if (b == 1) {
+            bank.Process(num_strings, kAudioBlockSize);
+          }
+          time[b] += clock() - start;
+        }
+        if (b == 0) {
+          reference.swap(out);
+          reference_aux.swap(aux);
+        } else {
+          for (size_t j = 0; j < out.size(); ++j) {
+            max_error = std::max(max_error, fabsf(out[j] - reference[j]));
+            max_error = std::max(max_error, fabsf(aux[j] - reference_aux[j]));
+            max_value = std::max(max_value, fabsf(reference[j]));
+          }
+        }
+      }
+      printf(
+          "%d\t%s\t%.2fx realtime\t%.2fx realtime\t%g (peak %g)\n",
+          int(num_strings),
+          d == 1 ? "yes" : "no",
+          kDuration / (time[0] / CLOCKS_PER_SEC),
+          kDuration / (time[1] / CLOCKS_PER_SEC),
+          max_error,
+          max_value);
+    }
+  }
+#endif  // STRING_USE_SIMD
+}
+
+void TestResonatorUpdates() {
+  const size_t kDuration = 10;
+  
+  Resonator resonators[2];
+  resonators[0].Init();
+  resonators[1].Init();
+  resonators[1].set_modes_per_update(16);
+  
+  for (uint32_t i = 0; i < ::kSampleRate * kDuration; i += kAudioBlockSize) {
+    float in[kAudioBlockSize];
+    float out[kAudioBlockSize];
+    float aux[kAudioBlockSize];
+    for (size_t j = 0; j < kAudioBlockSize; ++j) {
+      in[j] = (i + j) % 12000 == 0 ? 1.0f : 0.0f;
+    }
+    // Held parameters for the first half, then a slow vibrato and a slow
+    // brightness sweep.
+    float t = static_cast<float>(i) / ::kSampleRate;
+    float modulation = t < kDuration / 2 ? 0.0f : 1.0f;
+    for (size_t r = 0; r < 2; ++r) {
+      Resonator* resonator = &resonators[r];
+      resonator->set_frequency(
+          SemitonesToRatio(0.2f * modulation * sinf(t * 30.0f)) * 0.01f);
+      resonator->set_structure(0.4f);
+      resonator->set_brightness(0.5f + 0.3f * modulation * sinf(t * 0.5f));
+      resonator->set_damping(0.8f);
+      resonator->set_position(0.3f);
+      resonator->Process(in, out, aux, kAudioBlockSize);
+    }
+  }
+  for (size_t r = 0; r < 2; ++r) {
+    uint32_t updates = resonators[r].num_updates();
+    uint32_t skipped = resonators[r].num_skipped_updates();
+    printf(
+        "%d updates, %d skipped (%.1f%%)\n",
+        updates,
+        skipped,
+        100.0f * skipped / (updates + skipped));
+  }
+}
+
+void TestSympatheticTuning() {
+  const size_t kDuration = 10;
+  
+  Part part;
+  part.Init(reverb_buffer);
+  part.set_polyphony(2);
+  part.set_model(RESONATOR_MODEL_SYMPATHETIC_STRING);
+  
+  Patch patch;
+  patch.brightness = 0.5f;
+  patch.damping = 0.8f;
+  patch.position = 0.3f;
+  
+  PerformanceState performance;
+  performance.internal_exciter = true;
+  performance.internal_strum = false;
+  performance.internal_note = false;
+  performance.tonic = 12.0f;
+  performance.fm = 0.0f;
+  performance.chord = 0;
+  
+  clock_t start = clock();
+  for (uint32_t i = 0; i < ::kSampleRate * kDuration; i += kAudioBlockSize) {
+    float in[kAudioBlockSize];
+    float out[kAudioBlockSize];
+    float aux[kAudioBlockSize];
+    fill(&in[0], &in[kAudioBlockSize], 0.0f);
+    // Held chord for the first half, then a slow sweep of the structure.
+    float t = static_cast<float>(i) / ::kSampleRate;
+    float modulation = t < kDuration / 2 ? 0.0f : 1.0f;
+    patch.structure = 0.4f + 0.1f * modulation * sinf(t * 0.5f);
+    performance.strum = i % 24000 == 0;
+    performance.note = i % 48000 < 24000 ? 48.0f : 55.0f;
+    part.Process(performance, patch, in, out, aux, kAudioBlockSize);
+  }
+  uint32_t updates = part.num_tuning_updates();
+  uint32_t skipped = part.num_skipped_tuning_updates();
+  printf(
+      "%d updates, %d skipped (%.1f%%), %.2fx realtime\n",
+      updates,
+      skipped,
+      100.0f * skipped / (updates + skipped),
+      kDuration / (static_cast<double>(clock() - start) / CLOCKS_PER_SEC));
+}
+
+// Renders kDuration seconds of strummed notes, and returns the wall-clock
+// rendering time in seconds.
+double RenderParallelVoices(
+    ResonatorModel model,
+    int32_t polyphony,
+    WorkerPool* pool,
+    float* out,
+    float* aux,
+    size_t size) {
+  Part part;
+  part.Init(reverb_buffer);
+  part.set_polyphony(polyphony);
+  part.set_model(model);
+  part.set_parallel_runner(pool);
+  
+  Patch patch;
+  patch.structure = 0.4f;
+  patch.brightness = 0.5f;
+  patch.damping = 0.8f;
+  patch.position = 0.3f;
+  
+  PerformanceState performance;
+  performance.internal_exciter = false;
+  performance.internal_strum = false;
+  performance.internal_note = false;
+  performance.tonic = 0.0f;
+  performance.fm = 0.0f;
+  performance.chord = 0;
+  
+  timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (size_t i = 0; i < size; i += kAudioBlockSize) {
+    float in[kAudioBlockSize];
+    for (size_t j = 0; j < kAudioBlockSize; ++j) {
+      in[j] = (i + j) % 6000 < 50 ? 0.5f : 0.0f;
+    }
+    performance.strum = i % 6000 == 0;
+    performance.note = 36.0f + static_cast<float>((i / 6000 * 7) % 24);
+    part.Process(
+        performance, patch, in, &out[i], &aux[i], kAudioBlockSize);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+}
+
+void BenchmarkParallelVoices() {
+  const size_t kDuration = 5;
+  const size_t kSize = ::kSampleRate * kDuration;
+  const ResonatorModel kModels[] = {
+    RESONATOR_MODEL_MODAL, RESONATOR_MODEL_SYMPATHETIC_STRING
+  };
+  const char* kModelNames[] = { "modal", "sympathetic string" };
+  const int32_t kPolyphonies[] = { 4, 8, 16 };
+  const size_t kNumThreads[] = { 1, 2, 4 };
+  
+  std::vector<float> reference(2 * kSize);
+  std::vector<float> output(2 * kSize);
+  
+  printf("model\tvoices\tthreads\tvoices/ms\tspeedup\tbit-exact\n");
+  for (size_t m = 0; m < 2; ++m) {
+    for (size_t p = 0; p < 3; ++p) {
+      double reference_time = 0.0;
+      for (size_t t = 0; t < 3; ++t) {
+        WorkerPool pool;
+        pool.Start(kNumThreads[t]);
+        
+        float* out = t == 0 ? &reference[0] : &output[0];
+        double time = RenderParallelVoices(
+            kModels[m],
+            kPolyphonies[p],
+            kNumThreads[t] == 1 ? NULL : &pool,
+            out,
+            out + kSize,
+            kSize);
+        pool.Stop();
+        
+        if (t == 0) {
+          reference_time = time;
+        }
+        // Voice-milliseconds of audio rendered per millisecond.
+        double voices_per_ms = kPolyphonies[p] * kDuration / time;
+        bool bit_exact = std::equal(
+            output.begin(), output.end(), reference.begin());
+        printf(
+            "%s\t%d\t%d\t%.1f\t%.2f\t%s\n",
+            kModelNames[m],
+            int(kPolyphonies[p]),
+            int(kNumThreads[t]),
+            voices_per_ms,
+            reference_time / time,
+            t == 0 ? "-" : (bit_exact ? "yes" : "no"));
+      }
+    }
+  }
+}
+
 int main(void) {
   _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
   TestNoteFilter();
@@ -569,4 +907,9 @@ int main(void) {
   TestStringSynthOscillator();
   TestStringSynthVoice();
   TestStringSynthPart();
+  // CompareResonatorBackends();
+  // CompareStringBackends();
+  // TestResonatorUpdates();
+  // TestSympatheticTuning();
+  // BenchmarkParallelVoices();
 }
@@ -0,0 +1,122 @@
+// Copyright 2015 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Fork/join pool of threads rendering the voices of a Part in parallel.
+
+#include "rings/test/worker_pool.h"
+
+#include <algorithm>
+
+namespace rings {
+
+using namespace std;
+
+bool WorkerPool::Start(size_t num_threads) {
+  Stop();
+  num_workers_ = 0;
+  quit_ = false;
+  sem_init(&done_, 0, 0);
+  running_ = true;
+  num_threads = min(max(num_threads, size_t(1)), kMaxWorkerThreads + 1);
+  for (size_t i = 0; i < num_threads - 1; ++i) {
+    WorkerState* w = &workers_[i];
+    w->pool = this;
+    w->index = i;
+    sem_init(&w->start, 0, 0);
+    if (pthread_create(&w->thread, NULL, &WorkerEntryPoint, w)) {
+      sem_destroy(&w->start);
+      Stop();
+      return false;
+    }
+    ++num_workers_;
+  }
+  return true;
+}
+
+void WorkerPool::Stop() {
+  if (!running_) {
+    return;
+  }
+  quit_ = true;
+  for (size_t i = 0; i < num_workers_; ++i) {
+    sem_post(&workers_[i].start);
+  }
+  for (size_t i = 0; i < num_workers_; ++i) {
+    pthread_join(workers_[i].thread, NULL);
+    sem_destroy(&workers_[i].start);
+  }
+  num_workers_ = 0;
+  sem_destroy(&done_);
+  running_ = false;
+}
+
+/* static */
+void* WorkerPool::WorkerEntryPoint(void* worker) {
+  WorkerState* w = static_cast<WorkerState*>(worker);
+  w->pool->Worker(w->index);
+  return NULL;
+}
+
+void WorkerPool::Worker(size_t index) {
+  while (true) {
+    sem_wait(&workers_[index].start);
+    if (quit_) {
+      break;
+    }
+    RunTasks();
+    sem_post(&done_);
+  }
+}
+
+void WorkerPool::RunTasks() {
+  while (true) {
+    int32_t index = __sync_fetch_and_add(&next_task_, 1);
+    if (index >= num_tasks_) {
+      break;
+    }
+    task_(context_, index);
+  }
+}
+
+void WorkerPool::Run(Task task, void* context, int32_t num_tasks) {
+  task_ = task;
+  context_ = context;
+  num_tasks_ = num_tasks;
+  next_task_ = 0;
+  
+  // The semaphores order these writes before the workers read them, and the
+  // writes of the workers before the return of this function.
+  size_t num_woken_up = min(num_workers_, size_t(max(num_tasks - 1, 0)));
+  for (size_t i = 0; i < num_woken_up; ++i) {
+    sem_post(&workers_[i].start);
+  }
+  RunTasks();
+  for (size_t i = 0; i < num_woken_up; ++i) {
+    sem_wait(&done_);
+  }
+}
+
+}  // namespace rings
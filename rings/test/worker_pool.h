@@ -0,0 +1,93 @@
+// Copyright 2015 Emilie Gillet.
+//
+// Author: Emilie Gillet (emilie.o.gillet@gmail.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Fork/join pool of threads rendering the voices of a Part in parallel.
+// Host only - this is not built into the firmware.
+
+#ifndef RINGS_TEST_WORKER_POOL_H_
+#define RINGS_TEST_WORKER_POOL_H_
+
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "stmlib/stmlib.h"
+
+#include "rings/dsp/part.h"
+
+namespace rings {
+
+const size_t kMaxWorkerThreads = 16;
+
+class WorkerPool : public ParallelRunner {
+ public:
+  WorkerPool() : num_workers_(0), running_(false) { }
+  virtual ~WorkerPool() { Stop(); }
+  
+  // num_threads counts the thread calling Run(), which renders its share of
+  // the tasks. Returns false if the threads cannot be created.
+  bool Start(size_t num_threads);
+  
+  // Joins the workers. Does nothing if the pool is not running, so it is safe
+  // to call more than once.
+  void Stop();
+  
+  // Wakes up as many workers as needed, and blocks until all the tasks are
+  // done: there is one fork and one join per call.
+  virtual void Run(Task task, void* context, int32_t num_tasks);
+  
+  inline size_t num_threads() const { return num_workers_ + 1; }
+  
+ private:
+  static void* WorkerEntryPoint(void* worker);
+  void Worker(size_t index);
+  void RunTasks();
+  
+  struct WorkerState {
+    WorkerPool* pool;
+    size_t index;
+    pthread_t thread;
+    sem_t start;
+  };
+  
+  WorkerState workers_[kMaxWorkerThreads];
+  size_t num_workers_;
+  sem_t done_;
+  volatile bool quit_;
+  bool running_;
+  
+  Task task_;
+  void* context_;
+  int32_t num_tasks_;
+  
+  // Tasks are claimed with an atomic increment.
+  volatile int32_t next_task_;
+  
+  DISALLOW_COPY_AND_ASSIGN(WorkerPool);
+};
+
+}  // namespace rings
+
+#endif  // RINGS_TEST_WORKER_POOL_H_